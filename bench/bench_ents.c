@@ -0,0 +1,291 @@
+// Entity storage benchmark:
+// times the entity handler's per entity loops (grid sync, gravity, update batch building) on it's hot field arrays,
+// against the same loops over an array of fat Entity structs laid out as before the hot/cold split.
+// Both walk the handler's active list, which is out of slot order once entities have been destroyed and remade
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "clock.h"
+#include "kmath.h"
+#include "entity.h"
+#include "ent_handler.h"
+
+#define PASSES			100
+#define ROUNDS			5
+#define BENCH_BODIES	4096
+#define BENCH_FISH		4096
+#define BENCH_BOUNDS	20000.0f
+
+// Orbit fields embedded in Entity before the hot/cold split
+typedef struct {
+	float angle;
+	float height;
+	float body_radius;
+	float angular_vel;
+	float next_angle;
+	float tang_vel;
+	float rad_vel;
+	Vector2 ent_vel;
+	Vector2 orbit_center;
+	Vector2 initial_pos;
+	Vector2 edge;
+	Vector2 dir;
+	Vector2 curr_pos;
+} LegacyOrbitData;
+
+// Layout of Entity before the hot/cold split
+typedef struct LegacyEntity {
+	uint8_t flags;
+	uint8_t type;
+	uint8_t sprite_id;
+
+	float radius;
+	float orbit_height;
+	float orbit_angle;
+	float sprite_angle;
+
+	Vector2 position;
+	Vector2 velocity;
+	Vector2 center_offset;
+
+	LegacyOrbitData orbit_data;
+
+	void (*update)(struct LegacyEntity *self, float dt);
+	void (*draw)(struct LegacyEntity *self, SpriteLoader *sl);
+
+	void *data;
+} LegacyEntity;
+
+extern bool type_update_serial[];
+extern bool type_gravity[];
+
+// Engine state shared by setup, the timed loops and teardown
+static EntHandler handler;
+static SpriteLoader sprite_loader;
+static RenderQueue render_queue;
+static Camera2D camera;
+
+// Legacy entities indexed by slot id, with their own copies of the handler's scratch arrays
+static LegacyEntity *legacy;
+static LegacyEntity **legacy_update_list;
+static EntUpdateBatch *legacy_batches;
+static uint32_t legacy_batch_count, legacy_serial_batch_count;
+static float legacy_max_radius;
+static GravityTree legacy_gravity;
+static GravityBatch legacy_gravity_batch;
+
+// Prevent loops from being optimized away
+static volatile float sink;
+
+// Fish get a batch function so batch building fills the update list with them, nothing is run
+static void NopBatch(Entity **ents, uint32_t count, float dt) {
+	(void)ents; (void)count; (void)dt;
+}
+
+static void SpawnFish(uint32_t *rng) {
+	Entity *fish = EntGet(&handler, EntMake(&handler, ENT_FISH));
+	ENT_RADIUS(fish) = 16;
+	EntSetPosition(fish, (Vector2){ RandRange(rng, -BENCH_BOUNDS, BENCH_BOUNDS), RandRange(rng, -BENCH_BOUNDS, BENCH_BOUNDS) });
+}
+
+// Bodies and free floating fish, a third of them remade so active list and slots are shuffled as in play
+static void Fill(void) {
+	sprite_loader.flags = SPR_LOADER_HEADLESS;
+	sprite_loader.spr_pool[1] = (Spritesheet){ .flags = SPR_META_ONLY, .frame_w = 128, .frame_h = 128, .cols = 1, .rows = 1, .frame_count = 1 };
+	sprite_loader.spr_count = 2;
+
+	EntHandlerInit(&handler, &sprite_loader, &render_queue, &camera);
+	ent_update_funcs[ENT_FISH] = &NopBatch;
+
+	uint32_t rng = 0x5EED1234;
+	for(uint32_t i = 0; i < BENCH_BODIES; i++)
+		AsteroidSpawn(&handler, (Vector2){ RandRange(&rng, -BENCH_BOUNDS, BENCH_BOUNDS), RandRange(&rng, -BENCH_BOUNDS, BENCH_BOUNDS) });
+	for(uint32_t i = 0; i < BENCH_FISH; i++) SpawnFish(&rng);
+
+	for(uint32_t i = 0; i < handler.count; i += 3) {
+		uint32_t id = handler.active[i];
+		bool body = EntHotOf(&handler, id)->flags[id & ENT_CHUNK_MASK] & ENT_IS_BODY;
+
+		EntDestroy(&handler, EntGetHandle(&handler, id));
+		if(body) AsteroidSpawn(&handler, (Vector2){ RandRange(&rng, -BENCH_BOUNDS, BENCH_BOUNDS), RandRange(&rng, -BENCH_BOUNDS, BENCH_BOUNDS) });
+		else SpawnFish(&rng);
+	}
+
+	legacy = calloc(handler.capacity, sizeof(LegacyEntity));
+	legacy_update_list = calloc(handler.capacity, sizeof(LegacyEntity*));
+	legacy_batches = calloc(ENT_UPDATE_MAX_BATCHES(handler.capacity), sizeof(EntUpdateBatch));
+	GravityTreeInit(&legacy_gravity);
+	GravityBatchInit(&legacy_gravity_batch);
+
+	for(uint32_t i = 0; i < handler.count; i++) {
+		uint32_t id = handler.active[i];
+		EntHot *hot = EntHotOf(&handler, id);
+		uint32_t h = id & ENT_CHUNK_MASK;
+
+		legacy[id] = (LegacyEntity){
+			.flags = hot->flags[h],
+			.type = hot->type[h],
+			.radius = hot->radius[h],
+			.position = hot->position[h],
+			.velocity = hot->velocity[h],
+			.center_offset = hot->center_offset[h]
+		};
+	}
+}
+
+// Handler's GridSync loop
+static void GridSyncLegacy(void) {
+	for(uint32_t i = 0; i < handler.count; i++) {
+		uint32_t id = handler.active[i];
+		LegacyEntity *e = &legacy[id];
+
+		GridMove(&handler.grid, id, Vector2Add(e->position, e->center_offset));
+		if(e->radius > legacy_max_radius) legacy_max_radius = e->radius;
+	}
+}
+
+// EntGravityUpdate
+static void GravityLegacy(float dt) {
+	GravityTree *tree = &legacy_gravity;
+	GravityBatch *batch = &legacy_gravity_batch;
+	tree->count = 0;
+	batch->count = 0;
+
+	uint32_t body_count = 0, float_count = 0;
+	for(uint32_t i = 0; i < handler.count; i++) {
+		LegacyEntity *e = &legacy[handler.active[i]];
+
+		if(e->flags & ENT_IS_BODY) body_count++;
+		else if(!(e->flags & ENT_ORBIT) && type_gravity[e->type]) float_count++;
+	}
+
+	if(!body_count || !float_count) return;
+	if(!GravityTreeReserve(tree, body_count) || !GravityBatchReserve(batch, float_count)) return;
+
+	for(uint32_t i = 0; i < handler.count; i++) {
+		uint32_t id = handler.active[i];
+		LegacyEntity *e = &legacy[id];
+		Vector2 center = Vector2Add(e->position, e->center_offset);
+
+		if(e->flags & ENT_IS_BODY) {
+			uint32_t n = tree->count++;
+			tree->x[n] = center.x;
+			tree->y[n] = center.y;
+			tree->mass[n] = e->radius * e->radius;
+		} else if(!(e->flags & ENT_ORBIT) && type_gravity[e->type]) {
+			uint32_t n = batch->count++;
+			batch->ids[n] = id;
+			batch->x[n] = center.x;
+			batch->y[n] = center.y;
+		}
+	}
+
+	GravityTreeBuild(tree);
+	GravityBatchSolve(batch, tree, NULL);
+
+	for(uint32_t n = 0; n < batch->count; n++) {
+		LegacyEntity *e = &legacy[batch->ids[n]];
+		Vector2 accel = { batch->ax[n], batch->ay[n] };
+		e->velocity = Vector2Add(e->velocity, Vector2Scale(accel, dt));
+
+		if(!ent_update_funcs[e->type]) e->position = Vector2Add(e->position, Vector2Scale(e->velocity, dt));
+	}
+}
+
+// EntBuildUpdateBatches
+static void BuildBatchesLegacy(void) {
+	uint32_t counts[ENT_TYPE_COUNT] = {0};
+
+	for(uint32_t i = 0; i < handler.count; i++) counts[legacy[handler.active[i]].type]++;
+
+	uint32_t type_start[ENT_TYPE_COUNT], pos = 0;
+	for(int pass = 0; pass < 2; pass++) {
+		for(uint8_t t = 0; t < ENT_TYPE_COUNT; t++) {
+			if(type_update_serial[t] != (pass == 0)) continue;
+			if(!ent_update_funcs[t]) counts[t] = 0;
+
+			type_start[t] = pos;
+			pos += counts[t];
+		}
+	}
+
+	uint32_t fill[ENT_TYPE_COUNT];
+	memcpy(fill, type_start, sizeof(fill));
+	for(uint32_t i = 0; i < handler.count; i++) {
+		LegacyEntity *e = &legacy[handler.active[i]];
+		if(counts[e->type]) legacy_update_list[fill[e->type]++] = e;
+	}
+
+	legacy_batch_count = 0;
+	for(int pass = 0; pass < 2; pass++) {
+		for(uint8_t t = 0; t < ENT_TYPE_COUNT; t++) {
+			if(type_update_serial[t] != (pass == 0)) continue;
+
+			for(uint32_t begin = type_start[t]; begin < fill[t]; begin += ENT_UPDATE_CHUNK) {
+				uint32_t end = (begin + ENT_UPDATE_CHUNK < fill[t]) ? begin + ENT_UPDATE_CHUNK : fill[t];
+				legacy_batches[legacy_batch_count++] = (EntUpdateBatch){ begin, end, t };
+			}
+		}
+
+		if(pass == 0) legacy_serial_batch_count = legacy_batch_count;
+	}
+}
+
+// Pass functions, gravity has no time step so every pass pulls the same entities from the same places
+static void GridSyncLegacyPass(void) { GridSyncLegacy(); }
+static void GridSyncHotPass(void) { EntGridSync(&handler); }
+static void GravityLegacyPass(void) { GravityLegacy(0); }
+static void GravityHotPass(void) { EntGravityUpdate(&handler, 0); }
+static void BatchesLegacyPass(void) { BuildBatchesLegacy(); }
+static void BatchesHotPass(void) { EntBuildUpdateBatches(&handler); }
+
+// Fastest of ROUNDS rounds of PASSES passes, layouts take turns so both see the same machine state
+static void Compare(const char *name, void (*aos)(void), void (*soa)(void)) {
+	uint64_t best_aos = UINT64_MAX, best_soa = UINT64_MAX;
+
+	for(int r = 0; r < ROUNDS; r++) {
+		uint64_t t0 = ClockNowNs();
+		for(int p = 0; p < PASSES; p++) aos();
+		uint64_t t1 = ClockNowNs();
+		for(int p = 0; p < PASSES; p++) soa();
+		uint64_t t2 = ClockNowNs();
+
+		if(t1 - t0 < best_aos) best_aos = t1 - t0;
+		if(t2 - t1 < best_soa) best_soa = t2 - t1;
+	}
+
+	double scale = 1.0 / ((double)PASSES * handler.count);
+	printf("%-14s aos: %7.2f ns/ent   soa: %7.2f ns/ent   speedup: %.2fx\n", name, best_aos * scale, best_soa * scale, (double)best_aos / best_soa);
+}
+
+int main(void) {
+	Fill();
+
+	printf("entity handler loops, %u entities (%u bodies), best of %d rounds of %d passes\n", handler.count, BENCH_BODIES, ROUNDS, PASSES);
+	printf("sizeof(LegacyEntity) = %zu, hot bytes per entity = %zu\n", sizeof(LegacyEntity), sizeof(EntHot) / ENT_CHUNK_SIZE);
+
+	// Build both gravity trees, bodies don't move so later passes keep the tree
+	GravityLegacyPass();
+	GravityHotPass();
+
+	Compare("grid_sync", GridSyncLegacyPass, GridSyncHotPass);
+	Compare("gravity", GravityLegacyPass, GravityHotPass);
+	Compare("update_batches", BatchesLegacyPass, BatchesHotPass);
+
+	if(legacy_batch_count != handler.batch_count || legacy_serial_batch_count != handler.serial_batch_count)
+		printf("ERROR: legacy loop built %u batches, handler %u\n", legacy_batch_count, handler.batch_count);
+
+	sink = legacy_max_radius + handler.max_radius + legacy_gravity_batch.ax[0] + handler.gravity_batch.ax[0];
+
+	ent_update_funcs[ENT_FISH] = NULL;
+	GravityTreeClose(&legacy_gravity);
+	GravityBatchClose(&legacy_gravity_batch);
+	free(legacy_batches);
+	free(legacy_update_list);
+	free(legacy);
+	EntHandlerClose(&handler);
+	return 0;
+}
@@ -0,0 +1,128 @@
+// Gravity benchmark:
+// builds a Barnes-Hut tree over a generated asteroid field and compares the tree walk against direct summation
+// over every body, at several opening angles. Error is the distance from the direct sum as a fraction of the mean
+// direct pull, pulls nearly cancel between bodies of an even field so per point relative error says little
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "clock.h"
+#include "kmath.h"
+#include "gravity.h"
+#include "field_gen.h"
+
+#define POINTS			4096
+#define BODY_RADIUS		64.0f
+#define BUILD_REPS		20
+#define FRAME_BUDGET_MS	(1000.0 / 60.0)
+
+// Prevent loops from being optimized away
+static volatile float sink;
+
+// Field points become bodies, all with the same radius
+static void FillTree(GravityTree *tree, const FieldPoints *field) {
+	tree->count = field->count;
+
+	for(uint32_t i = 0; i < field->count; i++) {
+		tree->x[i] = field->points[i].x;
+		tree->y[i] = field->points[i].y;
+		tree->mass[i] = BODY_RADIUS * BODY_RADIUS;
+	}
+}
+
+static void Run(uint32_t bodies) {
+	float spacing = FieldBodySpacing(BODY_RADIUS);
+	FieldParams params = {
+		.seed = 0x5EED1234,
+		.bounds = FieldBoundsFor(bodies, spacing),
+		.spacing = spacing,
+		.max_points = bodies
+	};
+
+	FieldPoints field;
+	GravityTree tree;
+	GravityTreeInit(&tree);
+
+	if(!FieldGenerate(&params, NULL, &field) || !GravityTreeReserve(&tree, field.count)) {
+		printf("could not allocate %u bodies\n", bodies);
+		return;
+	}
+
+	// Build is timed on its own, forced each rep. Ticks with unchanged bodies only pay for the compare
+	uint64_t t_build = 0, t_reuse = 0;
+	for(int r = 0; r < BUILD_REPS; r++) {
+		FillTree(&tree, &field);
+		tree.built_count = 0;
+
+		uint64_t t0 = ClockNowNs();
+		GravityTreeBuild(&tree);
+		uint64_t t1 = ClockNowNs();
+		GravityTreeBuild(&tree);
+
+		t_build += t1 - t0;
+		t_reuse += ClockNowNs() - t1;
+	}
+
+	// Query points spread over the field, between bodies and on top of them
+	Vector2 *points = malloc(sizeof(Vector2) * POINTS);
+	Vector2 *exact = malloc(sizeof(Vector2) * POINTS);
+	Vector2 *approx = malloc(sizeof(Vector2) * POINTS);
+	uint32_t rng = 0x9e3779b9;
+	Rectangle b = params.bounds;
+
+	for(uint32_t i = 0; i < POINTS; i++) {
+		points[i].x = b.x + (RandNext(&rng) & 0xFFFF) / 65536.0f * b.width;
+		points[i].y = b.y + (RandNext(&rng) & 0xFFFF) / 65536.0f * b.height;
+	}
+
+	uint64_t t0 = ClockNowNs();
+	for(uint32_t i = 0; i < POINTS; i++) exact[i] = GravityAccelDirect(&tree, points[i]);
+	uint64_t t_direct = ClockNowNs() - t0;
+
+	double mean_pull = 0;
+	for(uint32_t i = 0; i < POINTS; i++) mean_pull += Vector2Length(exact[i]);
+	mean_pull /= POINTS;
+
+	printf("%u bodies, %u nodes, build %.3f ms (%.1f%% of 60 fps frame), unchanged bodies %.3f ms\n", tree.built_count, tree.node_count,
+		t_build * 1e-6 / BUILD_REPS, t_build * 1e-6 / BUILD_REPS / FRAME_BUDGET_MS * 100.0, t_reuse * 1e-6 / BUILD_REPS);
+	printf("  %-6s %12s %10s %14s %14s\n", "theta", "ns/point", "speedup", "mean err", "max err");
+	printf("  %-6s %12.1f %10s %14s %14s\n", "direct", (double)t_direct / POINTS, "1.00x", "-", "-");
+
+	float thetas[] = { 0.25f, 0.5f, 0.75f, 1.0f };
+	for(uint32_t t = 0; t < sizeof(thetas) / sizeof(thetas[0]); t++) {
+		tree.theta = thetas[t];
+
+		uint64_t t1 = ClockNowNs();
+		for(uint32_t i = 0; i < POINTS; i++) approx[i] = GravityAccel(&tree, points[i]);
+		uint64_t t_tree = ClockNowNs() - t1;
+
+		double err_sum = 0, err_max = 0;
+		for(uint32_t i = 0; i < POINTS; i++) {
+			double dx = approx[i].x - exact[i].x, dy = approx[i].y - exact[i].y;
+			double err = sqrt(dx * dx + dy * dy) / mean_pull;
+			err_sum += err;
+			if(err > err_max) err_max = err;
+		}
+
+		sink = approx[0].x;
+
+		printf("  %-6.2f %12.1f %9.2fx %13.4f%% %13.4f%%\n", thetas[t], (double)t_tree / POINTS, (double)t_direct / t_tree,
+			err_sum / POINTS * 100.0, err_max * 100.0);
+	}
+
+	free(points);
+	free(exact);
+	free(approx);
+	FieldPointsFree(&field);
+	GravityTreeClose(&tree);
+}
+
+int main(void) {
+	puts("barnes-hut gravity vs direct summation");
+
+	Run(10000);
+	Run(50000);
+	return 0;
+}
@@ -0,0 +1,172 @@
+// Orbit update benchmark:
+// compares per entity EntOrbitUpdate against the batched orbit kernel (scalar and SSE2 paths)
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "clock.h"
+#include "entity.h"
+#include "orbit.h"
+
+// Orbiter updates per measurement, split into passes over all orbiters
+#define UPDATES_PER_RUN	10000000
+#define BODY_COUNT		64
+#define DT				(1.0f / 60.0f)
+
+// Prevent loops from being optimized away
+static volatile float sink;
+
+// Orbiters and bodies spread over as many hot blocks as needed
+typedef struct {
+	int count;
+	EntHot *hot;
+	Entity *ents;
+	Entity *bodies;
+	OrbitData *orbits;
+	int *anchor;
+} Scene;
+
+static void SceneInit(Scene *scene, int count) {
+	int blocks = count / ENT_CHUNK_SIZE + 2;
+
+	scene->count = count;
+	scene->hot = calloc(blocks, sizeof(EntHot));
+	scene->ents = calloc(count, sizeof(Entity));
+	scene->bodies = calloc(BODY_COUNT, sizeof(Entity));
+	scene->orbits = calloc(count, sizeof(OrbitData));
+	scene->anchor = calloc(count, sizeof(int));
+
+	// Bodies live in last block
+	EntHot *body_hot = &scene->hot[blocks - 1];
+	for(int b = 0; b < BODY_COUNT; b++) {
+		Entity *body = &scene->bodies[b];
+		body->hot = body_hot;
+		body->id = b;
+		ENT_TYPEOF(body) = ENT_ASTEROID;
+		ENT_RADIUS(body) = 64;
+		ENT_OFFSET(body) = (Vector2){64, 64};
+		ENT_POS(body) = (Vector2){(float)(b % 8) * 600, (float)(b / 8) * 600};
+	}
+
+	for(int i = 0; i < count; i++) {
+		Entity *ent = &scene->ents[i];
+		ent->hot = &scene->hot[i / ENT_CHUNK_SIZE];
+		ent->id = i % ENT_CHUNK_SIZE;
+		ent->orbit = &scene->orbits[i];
+		ENT_TYPEOF(ent) = ENT_FISH;
+		ENT_FLAGS(ent) = ENT_ACTIVE | ENT_ORBIT;
+		ENT_RADIUS(ent) = 16;
+		ENT_OFFSET(ent) = (Vector2){16, 16};
+
+		scene->anchor[i] = i % BODY_COUNT;
+		*ent->orbit = (OrbitData) {
+			.angle = (float)(i % 628) * 0.01f,
+			.height = 10.0f + (float)(i % 50),
+			.angular_vel = ((i % 2) ? 1.0f : -1.0f) * (0.5f + (float)(i % 7) * 0.1f)
+		};
+	}
+}
+
+static void SceneClose(Scene *scene) {
+	free(scene->hot);
+	free(scene->ents);
+	free(scene->bodies);
+	free(scene->orbits);
+	free(scene->anchor);
+}
+
+// Fill batch from scene, same gather the entity handler does
+static void BatchFill(OrbitBatch *batch, Scene *scene) {
+	batch->count = scene->count;
+
+	for(int i = 0; i < scene->count; i++) {
+		Entity *ent = &scene->ents[i], *body = &scene->bodies[scene->anchor[i]];
+		Vector2 body_center = EntCenter(body);
+
+		batch->angle[i] = ent->orbit->angle;
+		batch->height[i] = ent->orbit->height;
+		batch->angular_vel[i] = ent->orbit->angular_vel;
+		batch->body_x[i] = body_center.x;
+		batch->body_y[i] = body_center.y;
+		batch->body_radius[i] = ENT_RADIUS(body);
+		batch->ent_radius[i] = ENT_RADIUS(ent);
+	}
+}
+
+static void UpdateLegacy(Scene *scene) {
+	for(int i = 0; i < scene->count; i++)
+		EntOrbitUpdate(&scene->ents[i], &scene->bodies[scene->anchor[i]], DT);
+}
+
+// Largest difference in orbiter center between scene and batch
+static float MaxError(Scene *scene, OrbitBatch *batch) {
+	float max_err = 0;
+	for(int i = 0; i < scene->count; i++) {
+		Vector2 center = EntCenter(&scene->ents[i]);
+		float err = fmaxf(fabsf(center.x - batch->center_x[i]), fabsf(center.y - batch->center_y[i]));
+		if(err > max_err) max_err = err;
+	}
+	return max_err;
+}
+
+static void Run(int count) {
+	Scene scene;
+	SceneInit(&scene, count);
+
+	OrbitBatch scalar, simd;
+	if(!OrbitBatchInit(&scalar, count) || !OrbitBatchInit(&simd, count)) {
+		printf("could not allocate %d orbiters\n", count);
+		OrbitBatchClose(&scalar);
+		SceneClose(&scene);
+		return;
+	}
+	BatchFill(&scalar, &scene);
+	BatchFill(&simd, &scene);
+
+	// Accuracy, one step from the same start state
+	UpdateLegacy(&scene);
+	OrbitBatchSolveScalar(&scalar, DT);
+	OrbitBatchSolve(&simd, DT);
+
+	float err_legacy = MaxError(&scene, &simd);
+	float err_paths = 0;
+	for(int i = 0; i < count; i++) {
+		err_paths = fmaxf(err_paths, fabsf(scalar.center_x[i] - simd.center_x[i]));
+		err_paths = fmaxf(err_paths, fabsf(scalar.center_y[i] - simd.center_y[i]));
+	}
+
+	int passes = UPDATES_PER_RUN / count;
+
+	uint64_t t0 = ClockNowNs();
+	for(int p = 0; p < passes; p++) UpdateLegacy(&scene);
+	uint64_t t1 = ClockNowNs();
+	for(int p = 0; p < passes; p++) OrbitBatchSolveScalar(&scalar, DT);
+	uint64_t t2 = ClockNowNs();
+	for(int p = 0; p < passes; p++) OrbitBatchSolve(&simd, DT);
+	uint64_t t3 = ClockNowNs();
+
+	double scale = 1.0 / ((double)passes * count);
+	printf("%6d orbiters  per entity: %6.2f ns   batch scalar: %6.2f ns   batch simd: %6.2f ns   speedup: %.2fx / %.2fx\n",
+		count, (t1 - t0) * scale, (t2 - t1) * scale, (t3 - t2) * scale, (double)(t1 - t0) / (t2 - t1), (double)(t1 - t0) / (t3 - t2));
+	printf("%6s max center error  vs per entity: %g px   scalar vs simd: %g px\n", "", err_legacy, err_paths);
+
+	sink = scene.orbits[0].angle + scalar.center_x[0] + simd.center_x[0];
+
+	OrbitBatchClose(&scalar);
+	OrbitBatchClose(&simd);
+	SceneClose(&scene);
+}
+
+int main(void) {
+#ifdef __SSE2__
+	puts("orbit update, batch simd path: SSE2");
+#else
+	puts("orbit update, batch simd path: scalar fallback");
+#endif
+
+	Run(1000);
+	Run(10000);
+	return 0;
+}
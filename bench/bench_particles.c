@@ -0,0 +1,105 @@
+// Particle benchmark:
+// keeps a particle system topped up at a fixed live count and times the per tick update
+// (emission, integration, swap removal) with the scalar and SSE2 pool kernels
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include "raylib.h"
+#include "clock.h"
+#include "particles.h"
+
+#define FRAMES			600
+#define DT				(1.0f / 60.0f)
+#define FRAME_BUDGET_MS	(1000.0 / 60.0)
+
+// Prevent loops from being optimized away
+static volatile float sink;
+
+// Replace what died last tick, spread over every effect so both pools stay busy
+static void TopUp(ParticleSystem *ps, uint32_t live) {
+	uint32_t have = ps->pools[PFX_POOL_SPARK].count + ps->pools[PFX_POOL_DUST].count;
+	if(have >= live) return;
+
+	uint32_t missing = live - have;
+	uint32_t per_effect = missing / PFX_EFFECT_COUNT;
+
+	for(uint8_t fx = 0; fx < PFX_EFFECT_COUNT; fx++) {
+		uint32_t count = (fx == PFX_EFFECT_COUNT - 1) ? missing - per_effect * fx : per_effect;
+		ParticleBurst(ps, fx, (Vector2){ (float)(fx * 100), 0 }, fx * 120.0f, count);
+	}
+}
+
+static void StepScalar(ParticleSystem *ps) {
+	for(uint8_t i = 0; i < PFX_POOL_COUNT; i++) ParticlePoolUpdateScalar(&ps->pools[i], DT);
+}
+
+static void StepSimd(ParticleSystem *ps) {
+	for(uint8_t i = 0; i < PFX_POOL_COUNT; i++) ParticlePoolUpdate(&ps->pools[i], DT);
+}
+
+// Largest position difference between two systems that should hold the same particles
+static float MaxError(ParticleSystem *a, ParticleSystem *b) {
+	float max_err = 0;
+
+	for(uint8_t p = 0; p < PFX_POOL_COUNT; p++) {
+		ParticlePool *pa = &a->pools[p], *pb = &b->pools[p];
+		if(pa->count != pb->count) return INFINITY;
+
+		for(uint32_t i = 0; i < pa->count; i++) {
+			max_err = fmaxf(max_err, fabsf(pa->pos_x[i] - pb->pos_x[i]));
+			max_err = fmaxf(max_err, fabsf(pa->pos_y[i] - pb->pos_y[i]));
+		}
+	}
+
+	return max_err;
+}
+
+static void Run(uint32_t live) {
+	ParticleSystem scalar, simd;
+	if(!ParticleSystemInit(&scalar, NULL, live) || !ParticleSystemInit(&simd, NULL, live)) {
+		printf("could not allocate %u particles\n", live);
+		return;
+	}
+
+	// Both systems start from the same random state, so they spawn the same particles
+	TopUp(&scalar, live);
+	TopUp(&simd, live);
+
+	uint64_t t_scalar = 0, t_simd = 0, worst_simd = 0;
+	for(int f = 0; f < FRAMES; f++) {
+		uint64_t t0 = ClockNowNs();
+		StepScalar(&scalar);
+		TopUp(&scalar, live);
+		uint64_t t1 = ClockNowNs();
+		StepSimd(&simd);
+		TopUp(&simd, live);
+		uint64_t t2 = ClockNowNs();
+
+		t_scalar += t1 - t0;
+		t_simd += t2 - t1;
+		if(t2 - t1 > worst_simd) worst_simd = t2 - t1;
+	}
+
+	double ms_scalar = t_scalar * 1e-6 / FRAMES, ms_simd = t_simd * 1e-6 / FRAMES;
+	printf("%7u live  scalar: %6.3f ms/tick   simd: %6.3f ms/tick (worst %6.3f)   speedup: %.2fx   %.1f%% of 60 fps frame\n",
+		live, ms_scalar, ms_simd, worst_simd * 1e-6, (double)t_scalar / t_simd, ms_simd / FRAME_BUDGET_MS * 100.0);
+	printf("%7s max position error scalar vs simd: %g px\n", "", MaxError(&scalar, &simd));
+
+	sink = scalar.pools[0].pos_x[0] + simd.pools[0].pos_x[0];
+
+	ParticleSystemClose(&scalar);
+	ParticleSystemClose(&simd);
+}
+
+int main(void) {
+#ifdef __SSE2__
+	puts("particle update, simd path: SSE2");
+#else
+	puts("particle update, simd path: scalar fallback");
+#endif
+
+	Run(10000);
+	Run(100000);
+	return 0;
+}
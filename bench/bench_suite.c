@@ -0,0 +1,705 @@
+// Engine microbenchmark suite:
+// times core routines without a window, prints a table and optionally writes CSV for comparing commits
+//
+// usage: bench_suite [--reps N] [--warmup N] [--filter text] [--csv path]
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "config.h"
+#include "clock.h"
+#include "entity.h"
+#include "ent_handler.h"
+#include "input.h"
+#include "kmath.h"
+#include "sprites.h"
+#include "snapshot.h"
+#include "field_gen.h"
+#include "particles.h"
+#include "projectiles.h"
+#include "gravity.h"
+#include "jobs.h"
+
+#define DEFAULT_REPS	15
+#define DEFAULT_WARMUP	3
+#define MAX_REPS		1000
+#define DT				(1.0f / 60.0f)
+
+// Entity mix of a full scene, plus the player
+#define SCENE_ASTEROIDS	503
+#define SCENE_FISH		512
+#define SCENE_NPCS		8
+
+// Entities made by the stress case
+#define STRESS_ENTITIES	100000
+
+// World saved and restored by snapshot cases, player plus bodies and orbiting fish
+#define SNAPSHOT_BODIES	767
+#define SNAPSHOT_FISH	256
+
+// Bodies placed by field generation case
+#define FIELD_BODIES	50000
+
+// Live particles kept by particle case
+#define PARTICLE_LIVE	100000
+
+// Orbiters solved each run by orbit batch cases, spread over a handful of bodies
+#define ORBIT_BATCH_COUNT	10000
+#define ORBIT_BATCH_BODIES	64
+
+// Bodies and projectiles fired each run by projectile case
+#define PROJECTILE_BODIES	4096
+#define PROJECTILE_SHOTS	4096
+#define PROJECTILE_SPEED	3000.0f
+
+// Bodies in gravity tree and points evaluated each run by gravity cases, direct summation visits every body per point
+#define GRAVITY_BODIES			10000
+#define GRAVITY_POINTS			1000
+#define GRAVITY_DIRECT_POINTS	100
+
+// Fish updated each run by parallel update case, check ticks are run once per thread count before timing
+#define UPDATE_FISH			4096
+#define UPDATE_CHECK_TICKS	120
+#define UPDATE_THREADS		4
+#define UPDATE_BOUNDS		2048.0f		// Fish past this far from origin destroy themselves
+#define UPDATE_SPEED		200.0f
+
+// Prevent loops from being optimized away
+static volatile float sink;
+
+// Engine state shared by each case's setup, run and teardown
+static EntHandler handler;
+static SpriteLoader sprite_loader;
+static RenderQueue render_queue;
+static Camera2D camera;
+static InputState input;
+
+// Frame layouts matching the game's spritesheets, no textures needed
+static void LoaderInit(void) {
+	sprite_loader = (SpriteLoader){0};
+	sprite_loader.flags = SPR_LOADER_HEADLESS;
+
+	sprite_loader.spr_pool[0] = (Spritesheet){ .flags = SPR_META_ONLY, .frame_w = 64, .frame_h = 64, .cols = 4, .rows = 2, .frame_count = 8 };
+	sprite_loader.spr_pool[1] = (Spritesheet){ .flags = SPR_META_ONLY, .frame_w = 128, .frame_h = 128, .cols = 1, .rows = 1, .frame_count = 1 };
+	sprite_loader.spr_count = 2;
+
+	AddSpriteAnim(&sprite_loader.spr_pool[0], FrameIndex(&sprite_loader.spr_pool[0], 0, 1), 4, 1, &sprite_loader);
+}
+
+static void HandlerOpen(void) {
+	memset(&handler, 0, sizeof(handler));
+	EntHandlerInit(&handler, &sprite_loader, &render_queue, &camera);
+	handler.input = &input;
+
+	Entity *player = EntGet(&handler, EntMake(&handler, ENT_PLAYER));
+	EntSetPosition(player, (Vector2){-90, 100});
+}
+
+// Square field of bodies around origin, same spacing as headless mode
+static void SpawnField(uint32_t bodies) {
+	uint32_t side = 1;
+	while(side * side < bodies) side++;
+
+	for(uint32_t i = 0; i < bodies; i++) {
+		Vector2 pos = { ((int)(i % side) - (int)side / 2) * 600.0f, ((int)(i / side) - (int)side / 2) * 600.0f };
+		AsteroidSpawn(&handler, pos);
+	}
+}
+
+// *** CASES ***
+//
+// Each case does ops operations per call of run, setup and teardown are not timed
+
+typedef struct {
+	char name[48];
+	uint32_t ops;
+	void (*setup)(void);
+	void (*run)(void);
+	void (*teardown)(void);
+	uint32_t param;
+} BenchCase;
+
+static uint32_t case_param;
+
+// Types at their cap must get a slot back once one is destroyed, checked before timing anything
+static void FillArenaSetup(void) {
+	HandlerOpen();
+
+	EntDestroy(&handler, handler.player);
+	Entity *player = EntGet(&handler, EntMake(&handler, ENT_PLAYER));
+	if(!player || player != EntPlayer(&handler)) printf("ERROR: could not remake destroyed player\n");
+	else EntSetPosition(player, (Vector2){-90, 100});
+
+	EntHandle npcs[SCENE_NPCS];
+	for(uint32_t i = 0; i < SCENE_NPCS; i++) npcs[i] = EntMake(&handler, ENT_NPC);
+
+	EntDestroy(&handler, npcs[SCENE_NPCS / 2]);
+	npcs[SCENE_NPCS / 2] = EntMake(&handler, ENT_NPC);
+	if(!EntGet(&handler, npcs[SCENE_NPCS / 2])) printf("ERROR: could not remake destroyed npc\n");
+
+	for(uint32_t i = 0; i < SCENE_NPCS; i++) EntDestroy(&handler, npcs[i]);
+}
+
+// Make a full scene: player, asteroids, fish and npcs, then destroy them
+static void FillArenaRun(void) {
+	uint32_t made = 1;
+
+	for(uint32_t i = 0; i < SCENE_ASTEROIDS; i++, made++)
+		AsteroidSpawn(&handler, (Vector2){ (float)(i % 32) * 300, (float)(i / 32) * 300 });
+
+	for(uint32_t i = 0; i < SCENE_FISH; i++, made++) EntMake(&handler, ENT_FISH);
+	for(uint32_t i = 0; i < SCENE_NPCS; i++, made++) EntMake(&handler, ENT_NPC);
+
+	// Keep player, release everything else for next run
+	for(uint32_t i = handler.count; i > 1; i--)
+		EntDestroy(&handler, EntGetHandle(&handler, handler.active[i - 1]));
+
+	sink = made;
+}
+
+// Grow a fresh handler to STRESS_ENTITIES asteroids, timing includes chunk allocation
+static void StressRun(void) {
+	HandlerOpen();
+	for(uint32_t i = 0; i < STRESS_ENTITIES; i++)
+		AsteroidSpawn(&handler, (Vector2){ (float)(i % 512) * 300, (float)(i / 512) * 300 });
+
+	sink = handler.count;
+	EntHandlerClose(&handler);
+}
+
+static void FindOrbitSetup(void) {
+	HandlerOpen();
+	SpawnField(case_param);
+}
+
+static void FindOrbitRun(void) {
+	PlayerData *p = EntPlayer(&handler)->data;
+
+	for(int i = 0; i < 1000; i++) {
+		// Sweep ray direction so the ray test sees different cells
+		float a = i * 0.00628f;
+		p->orbit_dir = (Vector2){ cosf(a), sinf(a) };
+		FindPlayerOrbit(&handler, DT);
+	}
+}
+
+// Player orbiting first body
+static void OrbitSetup(void) {
+	HandlerOpen();
+	EntHandle body = AsteroidSpawn(&handler, (Vector2){0, 0});
+
+	Entity *player = EntPlayer(&handler);
+	EntOrbitStart(player, EntGet(&handler, body));
+	player->orbit->anchor = body;
+}
+
+static void OrbitSingleRun(void) {
+	Entity *player = EntPlayer(&handler);
+	Entity *body = EntGet(&handler, player->orbit->anchor);
+
+	for(int i = 0; i < 10000; i++) {
+		player->orbit->angle += 0.01f;
+		EntOrbitUpdate(player, body, DT);
+	}
+}
+
+// Player plus every fish orbiting the field
+static void OrbitAllSetup(void) {
+	HandlerOpen();
+	SpawnField(64);
+
+	for(uint32_t i = 0; i < SCENE_FISH; i++) {
+		Entity *fish = EntGet(&handler, EntMake(&handler, ENT_FISH));
+		EntHandle body = EntGetHandle(&handler, handler.active[1 + i % 64]);
+
+		ENT_RADIUS(fish) = 16;
+		EntOrbitStart(fish, EntGet(&handler, body));
+		fish->orbit->anchor = body;
+		fish->orbit->angular_vel = 1.0f;
+	}
+}
+
+static void OrbitAllRun(void) {
+	for(int i = 0; i < 100; i++) EntOrbitUpdateAll(&handler, DT);
+}
+
+// Orbit kernel on it's own, batch filled once as the entity handler would
+static OrbitBatch orbit_batch;
+
+static void OrbitBatchSetup(void) {
+	if(!OrbitBatchInit(&orbit_batch, ORBIT_BATCH_COUNT)) {
+		printf("ERROR: could not allocate orbit batch\n");
+		return;
+	}
+
+	orbit_batch.count = ORBIT_BATCH_COUNT;
+	for(uint32_t i = 0; i < ORBIT_BATCH_COUNT; i++) {
+		uint32_t b = i % ORBIT_BATCH_BODIES;
+
+		orbit_batch.angle[i] = (float)(i % 628) * 0.01f;
+		orbit_batch.height[i] = 10.0f + (float)(i % 50);
+		orbit_batch.angular_vel[i] = ((i % 2) ? 1.0f : -1.0f) * (0.5f + (float)(i % 7) * 0.1f);
+		orbit_batch.body_x[i] = (float)(b % 8) * 600 + 64;
+		orbit_batch.body_y[i] = (float)(b / 8) * 600 + 64;
+		orbit_batch.body_radius[i] = 64;
+		orbit_batch.ent_radius[i] = 16;
+	}
+}
+
+static void OrbitBatchRun(void) {
+	OrbitBatchSolve(&orbit_batch, DT);
+	sink = orbit_batch.center_x[0];
+}
+
+// Plain C kernel, for comparing against the SSE2 path
+static void OrbitBatchScalarRun(void) {
+	OrbitBatchSolveScalar(&orbit_batch, DT);
+	sink = orbit_batch.center_x[0];
+}
+
+static void OrbitBatchTeardown(void) {
+	OrbitBatchClose(&orbit_batch);
+}
+
+// Full world snapshot, checks a restore gives back the saved state before timing anything
+static Snapshot snapshot;
+
+static void SnapshotSetup(void) {
+	HandlerOpen();
+	SpawnField(SNAPSHOT_BODIES);
+
+	for(uint32_t i = 0; i < SNAPSHOT_FISH; i++) {
+		Entity *fish = EntGet(&handler, EntMake(&handler, ENT_FISH));
+		EntHandle body = EntGetHandle(&handler, handler.active[1 + i % SNAPSHOT_BODIES]);
+
+		ENT_RADIUS(fish) = 16;
+		EntOrbitStart(fish, EntGet(&handler, body));
+		fish->orbit->anchor = body;
+	}
+
+	uint32_t hash = EntHandlerHash(&handler);
+	SnapshotSave(&handler, &snapshot);
+
+	// Ticked world must come back to saved state
+	EntHandle late = AsteroidSpawn(&handler, (Vector2){0, 0});
+	EntOrbitUpdateAll(&handler, DT);
+	if(!SnapshotRestore(&handler, snapshot.data, snapshot.size) || EntHandlerHash(&handler) != hash)
+		printf("ERROR: snapshot round trip changed world state\n");
+
+	// Body made after the save must stay stale once it's slot is reused
+	AsteroidSpawn(&handler, (Vector2){0, 0});
+	if(EntGet(&handler, late)) printf("ERROR: handle from before restore resolves to a new entity\n");
+	SnapshotRestore(&handler, snapshot.data, snapshot.size);
+}
+
+static void SnapshotSaveRun(void) {
+	SnapshotSave(&handler, &snapshot);
+}
+
+static void SnapshotRestoreRun(void) {
+	SnapshotRestore(&handler, snapshot.data, snapshot.size);
+}
+
+static void SnapshotTeardown(void) {
+	SnapshotFree(&snapshot);
+	EntHandlerClose(&handler);
+}
+
+// Parallel update batches, fish get a stand in batch function since no type of the game updates in parallel yet
+static JobSystem update_jobs;
+static uint32_t update_rng;
+
+// Move fish, destroying those out of bounds. Destroys are deferred to the running batch's buffer
+static void UpdateFishBatch(Entity **fish, uint32_t count, float dt) {
+	for(uint32_t i = 0; i < count; i++) {
+		Entity *ent = fish[i];
+		EntUpdatePosition(ent, dt);
+
+		Vector2 pos = ENT_POS(ent);
+		if(fabsf(pos.x) > UPDATE_BOUNDS || fabsf(pos.y) > UPDATE_BOUNDS) EntDestroy(&handler, EntGetHandle(&handler, ent->id));
+	}
+}
+
+static void UpdateSpawnFish(uint32_t count) {
+	for(uint32_t i = 0; i < count; i++) {
+		Entity *fish = EntGet(&handler, EntMake(&handler, ENT_FISH));
+		ENT_RADIUS(fish) = 16;
+		EntSetPosition(fish, (Vector2){ RandRange(&update_rng, -UPDATE_BOUNDS, UPDATE_BOUNDS), RandRange(&update_rng, -UPDATE_BOUNDS, UPDATE_BOUNDS) });
+		ENT_VEL(fish) = (Vector2){ RandRange(&update_rng, -UPDATE_SPEED, UPDATE_SPEED), RandRange(&update_rng, -UPDATE_SPEED, UPDATE_SPEED) };
+	}
+}
+
+static void UpdateOpen(int threads) {
+	HandlerOpen();
+	JobSystemInit(&update_jobs, threads);
+	handler.jobs = &update_jobs;
+	ent_update_funcs[ENT_FISH] = &UpdateFishBatch;
+
+	update_rng = 0x5EED1234;
+	UpdateSpawnFish(UPDATE_FISH);
+}
+
+static void UpdateClose(void) {
+	ent_update_funcs[ENT_FISH] = NULL;
+	EntHandlerClose(&handler);
+	JobSystemClose(&update_jobs);
+}
+
+// Hash of world after check ticks on provided thread count, fish destroyed along the way are counted
+static uint32_t UpdateCheckHash(int threads, uint32_t *destroyed) {
+	UpdateOpen(threads);
+	for(uint32_t i = 0; i < UPDATE_CHECK_TICKS; i++) EntHandlerUpdate(&handler, DT);
+
+	*destroyed = UPDATE_FISH + 1 - handler.count;
+	uint32_t hash = EntHandlerHash(&handler);
+	UpdateClose();
+
+	return hash;
+}
+
+// Batches run on any thread count must leave the world as one thread does, checked before timing anything
+static void UpdateSetup(void) {
+	uint32_t destroyed_serial, destroyed;
+	uint32_t serial = UpdateCheckHash(1, &destroyed_serial);
+	uint32_t parallel = UpdateCheckHash(case_param, &destroyed);
+
+	if(!destroyed_serial) printf("ERROR: update check destroyed no fish\n");
+	if(serial != parallel || destroyed != destroyed_serial)
+		printf("ERROR: %u thread update gave hash %08x, %u destroyed, single thread %08x, %u destroyed\n",
+			case_param, parallel, destroyed, serial, destroyed_serial);
+
+	UpdateOpen(case_param);
+}
+
+// One tick, destroyed fish are replaced so count holds steady
+static void UpdateRun(void) {
+	EntHandlerUpdate(&handler, DT);
+	UpdateSpawnFish(UPDATE_FISH + 1 - handler.count);
+}
+
+// Single threaded, job system is left out so results compare across machines
+static void FieldGenRun(void) {
+	float spacing = FieldBodySpacing(sprite_loader.spr_pool[1].frame_w * 0.5f);
+
+	FieldParams params = {
+		.seed = 0x5EED1234,
+		.bounds = FieldBoundsFor(FIELD_BODIES, spacing),
+		.spacing = spacing,
+		.max_points = FIELD_BODIES
+	};
+
+	FieldPoints field;
+	FieldGenerate(&params, NULL, &field);
+	sink = field.count;
+	FieldPointsFree(&field);
+}
+
+static ParticleSystem particles;
+
+static void ParticleSetup(void) {
+	ParticleSystemInit(&particles, NULL, PARTICLE_LIVE);
+}
+
+// Dead particles are replaced so count holds steady
+static void ParticleTopUp(void) {
+	uint32_t missing = PARTICLE_LIVE - particles.pools[PFX_POOL_SPARK].count;
+	ParticleBurst(&particles, PFX_THRUST, (Vector2){0, 0}, 0, missing);
+	sink = particles.pools[PFX_POOL_SPARK].pos_x[0];
+}
+
+// One tick of a full pool
+static void ParticleRun(void) {
+	ParticleSystemUpdate(&particles, DT);
+	ParticleTopUp();
+}
+
+// Same tick on the plain C pool kernel, for comparing against the SSE2 path
+static void ParticleScalarRun(void) {
+	for(uint8_t i = 0; i < PFX_POOL_COUNT; i++) ParticlePoolUpdateScalar(&particles.pools[i], DT);
+	ParticleTopUp();
+}
+
+static void ParticleTeardown(void) {
+	ParticleSystemClose(&particles);
+}
+
+static ProjectileSystem projectiles;
+
+// Field of bodies, checks a shot moving several body widths per tick still hits the body it passes through
+static void ProjectileSetup(void) {
+	HandlerOpen();
+	SpawnField(PROJECTILE_BODIES);
+	ProjectileSystemInit(&projectiles, &handler, PROJECTILE_SHOTS);
+
+	Entity *body = EntAt(&handler, handler.active[1]);
+	Vector2 center = EntCenter(body);
+	float radius = ENT_RADIUS(body);
+	float speed = radius * 4 / DT;
+
+	ProjectileFire(&projectiles, NULL, (Vector2){ center.x - radius * 2, center.y }, (Vector2){ speed, 0 }, 1, 1);
+	ProjectileSystemUpdate(&projectiles, DT);
+
+	if(projectiles.hit_count != 1 || projectiles.hits[0].target != EntGetHandle(&handler, body->id))
+		printf("ERROR: fast projectile passed through body\n");
+}
+
+// Full pool fired across the field and swept for one tick, single threaded
+static void ProjectileRun(void) {
+	ProjectileSystemClear(&projectiles);
+
+	uint32_t side = 1;
+	while(side * side < PROJECTILE_BODIES) side++;
+	float extent = side * 600.0f;
+
+	uint32_t rng = 0x9e3779b9;
+	for(uint32_t i = 0; i < PROJECTILE_SHOTS; i++) {
+		rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+		Vector2 pos = { ((rng & 0xffff) / 65536.0f - 0.5f) * extent, ((rng >> 16) / 65536.0f - 0.5f) * extent };
+		float angle = i * (PI2 / PROJECTILE_SHOTS);
+
+		ProjectileFire(&projectiles, NULL, pos, (Vector2){ cosf(angle) * PROJECTILE_SPEED, sinf(angle) * PROJECTILE_SPEED }, 4, 2);
+	}
+
+	ProjectileSystemUpdate(&projectiles, DT);
+	sink = projectiles.hit_count;
+}
+
+static void ProjectileTeardown(void) {
+	ProjectileSystemClose(&projectiles);
+	EntHandlerClose(&handler);
+}
+
+static GravityTree gravity;
+static Rectangle gravity_bounds;
+
+// Tree over a generated field at the default opening angle
+static void GravitySetup(void) {
+	float spacing = FieldBodySpacing(sprite_loader.spr_pool[1].frame_w * 0.5f);
+	gravity_bounds = FieldBoundsFor(GRAVITY_BODIES, spacing);
+
+	FieldParams params = { .seed = 0x5EED1234, .bounds = gravity_bounds, .spacing = spacing, .max_points = GRAVITY_BODIES };
+	FieldPoints field;
+	GravityTreeInit(&gravity);
+
+	if(!FieldGenerate(&params, NULL, &field) || !GravityTreeReserve(&gravity, field.count)) {
+		printf("ERROR: could not allocate gravity bodies\n");
+		return;
+	}
+
+	gravity.count = field.count;
+	for(uint32_t i = 0; i < field.count; i++) {
+		gravity.x[i] = field.points[i].x;
+		gravity.y[i] = field.points[i].y;
+		gravity.mass[i] = 1;
+	}
+
+	GravityTreeBuild(&gravity);
+	FieldPointsFree(&field);
+}
+
+// Points on a diagonal across the field
+static void GravityRun(void) {
+	Vector2 accel = {0};
+
+	for(uint32_t i = 0; i < GRAVITY_POINTS; i++) {
+		float t = (i + 0.5f) / GRAVITY_POINTS;
+		Vector2 p = { gravity_bounds.x + gravity_bounds.width * t, gravity_bounds.y + gravity_bounds.height * t };
+		accel = Vector2Add(accel, GravityAccel(&gravity, p));
+	}
+
+	sink = accel.x;
+}
+
+// Same diagonal summed over every body, the reference the tree walk is measured against
+static void GravityDirectRun(void) {
+	Vector2 accel = {0};
+
+	for(uint32_t i = 0; i < GRAVITY_DIRECT_POINTS; i++) {
+		float t = (i + 0.5f) / GRAVITY_DIRECT_POINTS;
+		Vector2 p = { gravity_bounds.x + gravity_bounds.width * t, gravity_bounds.y + gravity_bounds.height * t };
+		accel = Vector2Add(accel, GravityAccelDirect(&gravity, p));
+	}
+
+	sink = accel.x;
+}
+
+// Full build, forced since bodies equal to the last build's would keep the tree
+static void GravityBuildRun(void) {
+	gravity.built_count = 0;
+	GravityTreeBuild(&gravity);
+	sink = gravity.node_count;
+}
+
+static void GravityTeardown(void) {
+	GravityTreeClose(&gravity);
+}
+
+static void AngleLerpRun(void) {
+	float sum = 0;
+	for(int i = 0; i < 100000; i++) sum += AngleLerp((float)(i % 360), (float)((i * 7) % 720) - 360, 0.001f);
+	sink = sum;
+}
+
+static void FrameRecRun(void) {
+	Spritesheet *ss = &sprite_loader.spr_pool[0];
+	float x = 0;
+	for(int i = 0; i < 100000; i++) x += GetFrameRec(i % ss->frame_count, ss).x;
+	sink = x;
+}
+
+static void AnimPlayRun(void) {
+	SpriteAnimation *anim = &sprite_loader.anims[0];
+	for(int i = 0; i < 100000; i++) AnimPlay(anim, DT);
+	sink = anim->cur_frame;
+}
+
+static const char *config_lines[] = {
+	"window_width=1920\n", "window_height=1080\n", "refresh_rate=60\n",
+	"tick_rate=60\n", "max_ticks_per_frame=5\n", "threads=4\n", "# comment\n", "unknown_key=1\n"
+};
+#define CONFIG_LINE_COUNT (sizeof(config_lines) / sizeof(config_lines[0]))
+
+static void ConfigParseRun(void) {
+	Config conf = {0};
+	char line[64];
+
+	// Parsing writes into the line, parse a copy
+	for(int i = 0; i < 10000; i++) {
+		strcpy(line, config_lines[i % CONFIG_LINE_COUNT]);
+		ConfigParseLine(&conf, line);
+	}
+
+	sink = conf.tickRate;
+}
+
+static void HandlerClose(void) {
+	EntHandlerClose(&handler);
+}
+
+// *** HARNESS ***
+//
+static int CompareU64(const void *a, const void *b) {
+	uint64_t ua = *(const uint64_t*)a, ub = *(const uint64_t*)b;
+	return (ua > ub) - (ua < ub);
+}
+
+typedef struct {
+	double min, median, mean;		// ns/op
+} BenchResult;
+
+static BenchResult RunCase(BenchCase *bc, int warmup, int reps) {
+	static uint64_t samples[MAX_REPS];
+
+	case_param = bc->param;
+	if(bc->setup) bc->setup();
+
+	for(int i = 0; i < warmup; i++) bc->run();
+
+	uint64_t total = 0;
+	for(int i = 0; i < reps; i++) {
+		uint64_t t0 = ClockNowNs();
+		bc->run();
+		samples[i] = ClockNowNs() - t0;
+		total += samples[i];
+	}
+
+	if(bc->teardown) bc->teardown();
+
+	qsort(samples, reps, sizeof(uint64_t), CompareU64);
+
+	return (BenchResult) {
+		.min = (double)samples[0] / bc->ops,
+		.median = (double)samples[reps / 2] / bc->ops,
+		.mean = (double)total / reps / bc->ops
+	};
+}
+
+int main(int argc, char **argv) {
+	int reps = DEFAULT_REPS, warmup = DEFAULT_WARMUP;
+	const char *csv_path = NULL, *filter = NULL;
+
+	for(int i = 1; i < argc; i++) {
+		if(streq(argv[i], "--reps") && i + 1 < argc) reps = atoi(argv[++i]);
+		else if(streq(argv[i], "--warmup") && i + 1 < argc) warmup = atoi(argv[++i]);
+		else if(streq(argv[i], "--filter") && i + 1 < argc) filter = argv[++i];
+		else if(streq(argv[i], "--csv") && i + 1 < argc) csv_path = argv[++i];
+		else printf("unknown argument: %s\n", argv[i]);
+	}
+
+	if(reps < 1) reps = 1;
+	if(reps > MAX_REPS) reps = MAX_REPS;
+	if(warmup < 0) warmup = 0;
+
+	LoaderInit();
+	RenderQueueInit(&render_queue, RQ_DEFAULT_CAPACITY);
+
+	BenchCase cases[32];
+	int case_count = 0;
+
+	cases[case_count++] = (BenchCase){ "ent_make_destroy_arena", SCENE_ASTEROIDS + SCENE_FISH + SCENE_NPCS, FillArenaSetup, FillArenaRun, HandlerClose, 0 };
+	cases[case_count++] = (BenchCase){ "ent_grow_100k", STRESS_ENTITIES, NULL, StressRun, NULL, 0 };
+
+	uint32_t body_counts[] = { 16, 128, SCENE_ASTEROIDS };
+	for(int i = 0; i < 3; i++) {
+		BenchCase *bc = &cases[case_count++];
+		*bc = (BenchCase){ "", 1000, FindOrbitSetup, FindOrbitRun, HandlerClose, body_counts[i] };
+		snprintf(bc->name, sizeof(bc->name), "find_player_orbit_%u", body_counts[i]);
+	}
+
+	cases[case_count++] = (BenchCase){ "ent_orbit_update", 10000, OrbitSetup, OrbitSingleRun, HandlerClose, 0 };
+	cases[case_count++] = (BenchCase){ "ent_orbit_update_all", 100 * (SCENE_FISH + 1), OrbitAllSetup, OrbitAllRun, HandlerClose, 0 };
+	cases[case_count++] = (BenchCase){ "orbit_batch_10k", ORBIT_BATCH_COUNT, OrbitBatchSetup, OrbitBatchRun, OrbitBatchTeardown, 0 };
+	cases[case_count++] = (BenchCase){ "orbit_batch_scalar_10k", ORBIT_BATCH_COUNT, OrbitBatchSetup, OrbitBatchScalarRun, OrbitBatchTeardown, 0 };
+
+	int update_threads[] = { 1, UPDATE_THREADS };
+	for(int i = 0; i < 2; i++) {
+		BenchCase *bc = &cases[case_count++];
+		*bc = (BenchCase){ "", UPDATE_FISH, UpdateSetup, UpdateRun, UpdateClose, update_threads[i] };
+		snprintf(bc->name, sizeof(bc->name), "ent_update_%u_t%d", UPDATE_FISH, update_threads[i]);
+	}
+
+	cases[case_count++] = (BenchCase){ "snapshot_save_1024", 1, SnapshotSetup, SnapshotSaveRun, SnapshotTeardown, 0 };
+	cases[case_count++] = (BenchCase){ "snapshot_restore_1024", 1, SnapshotSetup, SnapshotRestoreRun, SnapshotTeardown, 0 };
+	cases[case_count++] = (BenchCase){ "field_gen_50k", FIELD_BODIES, NULL, FieldGenRun, NULL, 0 };
+	cases[case_count++] = (BenchCase){ "particles_update_100k", PARTICLE_LIVE, ParticleSetup, ParticleRun, ParticleTeardown, 0 };
+	cases[case_count++] = (BenchCase){ "particles_scalar_100k", PARTICLE_LIVE, ParticleSetup, ParticleScalarRun, ParticleTeardown, 0 };
+	cases[case_count++] = (BenchCase){ "projectiles_sweep_4096", PROJECTILE_SHOTS, ProjectileSetup, ProjectileRun, ProjectileTeardown, 0 };
+	cases[case_count++] = (BenchCase){ "gravity_accel_10k", GRAVITY_POINTS, GravitySetup, GravityRun, GravityTeardown, 0 };
+	cases[case_count++] = (BenchCase){ "gravity_direct_10k", GRAVITY_DIRECT_POINTS, GravitySetup, GravityDirectRun, GravityTeardown, 0 };
+	cases[case_count++] = (BenchCase){ "gravity_build_10k", GRAVITY_BODIES, GravitySetup, GravityBuildRun, GravityTeardown, 0 };
+	cases[case_count++] = (BenchCase){ "angle_lerp", 100000, NULL, AngleLerpRun, NULL, 0 };
+	cases[case_count++] = (BenchCase){ "get_frame_rec", 100000, NULL, FrameRecRun, NULL, 0 };
+	cases[case_count++] = (BenchCase){ "anim_play", 100000, NULL, AnimPlayRun, NULL, 0 };
+	cases[case_count++] = (BenchCase){ "config_parse_line", 10000, NULL, ConfigParseRun, NULL, 0 };
+
+	FILE *csv = NULL;
+	if(csv_path) {
+		csv = fopen(csv_path, "w");
+		if(!csv) printf("ERROR: Could not open csv file at: %s\n", csv_path);
+		else fputs("name,ops,warmup,reps,min_ns_op,median_ns_op,mean_ns_op\n", csv);
+	}
+
+	printf("engine bench suite, %d warmup, %d reps\n", warmup, reps);
+	printf("%-24s %10s %12s %12s %12s\n", "case", "ops/rep", "min ns/op", "median ns/op", "mean ns/op");
+
+	for(int i = 0; i < case_count; i++) {
+		BenchCase *bc = &cases[i];
+		if(filter && !strstr(bc->name, filter)) continue;
+
+		BenchResult r = RunCase(bc, warmup, reps);
+		printf("%-24s %10u %12.2f %12.2f %12.2f\n", bc->name, bc->ops, r.min, r.median, r.mean);
+
+		if(csv) fprintf(csv, "%s,%u,%d,%d,%.3f,%.3f,%.3f\n", bc->name, bc->ops, warmup, reps, r.min, r.median, r.mean);
+	}
+
+	if(csv) {
+		fclose(csv);
+		printf("results written to: %s\n", csv_path);
+	}
+
+	RenderQueueClose(&render_queue);
+	return 0;
+}
@@ -0,0 +1,67 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+static size_t PageRound(size_t size) {
+	return (size + ARENA_PAGE_SIZE - 1) & ~(size_t)(ARENA_PAGE_SIZE - 1);
+}
+
+void *PageAlloc(size_t size) {
+	void *mem = NULL;
+	size = PageRound(size);
+
+	if(posix_memalign(&mem, ARENA_PAGE_SIZE, size) != 0) return NULL;
+	memset(mem, 0, size);
+
+	return mem;
+}
+
+void ArenaInit(ChunkArena *arena, size_t elem_size, uint32_t chunk_bits, uint32_t max_elems) {
+	*arena = (ChunkArena){0};
+
+	// A single chunk holding every element is enough for small arenas
+	while(chunk_bits > 0 && (1u << (chunk_bits - 1)) >= max_elems) chunk_bits--;
+
+	arena->elem_size = elem_size;
+	arena->chunk_bits = chunk_bits;
+	arena->max_elems = max_elems;
+	arena->chunk_bytes = PageRound(elem_size << chunk_bits);
+}
+
+void ArenaClose(ChunkArena *arena) {
+	for(uint32_t i = 0; i < arena->chunk_count; i++) free(arena->chunks[i]);
+	free(arena->chunks);
+
+	arena->chunks = NULL;
+	arena->chunk_count = 0;
+	arena->table_cap = 0;
+}
+
+bool ArenaReserve(ChunkArena *arena, uint32_t count) {
+	if(count > arena->max_elems) return false;
+
+	while(ArenaCapacity(arena) < count) {
+		// Only the pointer table moves when growing, chunks stay put
+		if(arena->chunk_count >= arena->table_cap) {
+			uint32_t cap = (arena->table_cap) ? arena->table_cap * 2 : 8;
+			void **table = realloc(arena->chunks, sizeof(void*) * cap);
+			if(!table) return false;
+
+			arena->chunks = table;
+			arena->table_cap = cap;
+		}
+
+		void *chunk = PageAlloc(arena->chunk_bytes);
+		if(!chunk) return false;
+
+		arena->chunks[arena->chunk_count++] = chunk;
+	}
+
+	return true;
+}
+
+size_t ArenaBytes(ChunkArena *arena) {
+	return arena->chunk_bytes * arena->chunk_count;
+}
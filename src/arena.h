@@ -0,0 +1,50 @@
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Chunks are rounded up to whole pages and page aligned
+#define ARENA_PAGE_SIZE		4096
+
+// Chunked arena:
+// fixed size elements stored in page aligned chunks, allocated one chunk at a time as the arena grows.
+// Chunks never move, so pointers to elements stay valid until the arena is closed
+typedef struct {
+	size_t elem_size;
+	uint32_t chunk_bits;		// Elements per chunk is 1 << chunk_bits
+	uint32_t max_elems;			// Arena never grows past this many elements
+
+	uint32_t chunk_count;
+	uint32_t table_cap;			// Size of chunk pointer table
+	size_t chunk_bytes;			// Bytes allocated per chunk, whole pages
+	void **chunks;
+} ChunkArena;
+
+// Set up an empty arena, chunk size is clamped so small arenas don't allocate more than max_elems
+void ArenaInit(ChunkArena *arena, size_t elem_size, uint32_t chunk_bits, uint32_t max_elems);
+void ArenaClose(ChunkArena *arena);
+
+// Allocate chunks until arena holds at least count elements, new elements are zeroed,
+// returns false if count is over the arena's limit or out of memory
+bool ArenaReserve(ChunkArena *arena, uint32_t count);
+
+// Number of elements arena can hold without allocating
+static inline uint32_t ArenaCapacity(ChunkArena *arena) {
+	return arena->chunk_count << arena->chunk_bits;
+}
+
+// Pointer to element, index must be below arena's capacity
+static inline void *ArenaAt(ChunkArena *arena, uint32_t index) {
+	uint32_t mask = (1u << arena->chunk_bits) - 1;
+	return (char*)arena->chunks[index >> arena->chunk_bits] + (size_t)(index & mask) * arena->elem_size;
+}
+
+// Bytes allocated for chunks
+size_t ArenaBytes(ChunkArena *arena);
+
+// Allocate zeroed, page aligned memory, size is rounded up to whole pages. NULL on failure
+void *PageAlloc(size_t size);
+
+#endif // !ARENA_H_
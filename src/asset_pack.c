@@ -0,0 +1,270 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include "raylib.h"
+#include "asset_pack.h"
+#include "content.h"
+
+static uint32_t AlignUp(uint32_t n) {
+	return (n + ASSET_PACK_ALIGN - 1) & ~(uint32_t)(ASSET_PACK_ALIGN - 1);
+}
+
+// Bytes taken by header and tables, pixel data starts after
+static uint32_t TablesSize(uint32_t sheet_count, uint32_t anim_count, uint32_t page_count) {
+	return sizeof(AssetPackHeader) +
+		sheet_count * sizeof(AssetPackSheet) +
+		anim_count * sizeof(AssetPackAnim) +
+		page_count * sizeof(AssetPackPage);
+}
+
+bool AssetPackWrite(SpriteLoader *sl, const char *path) {
+	AssetPackHeader header = {
+		.magic = ASSET_PACK_MAGIC,
+		.version = ASSET_PACK_VERSION,
+		.sheet_count = sl->spr_count,
+		.anim_count = sl->anim_count,
+		.page_count = sl->atlas_count
+	};
+
+	AssetPackSheet sheets[SPR_POOL_CAPACITY] = {0};
+	AssetPackAnim anims[SPR_POOL_CAPACITY] = {0};
+	AssetPackPage pages[SPR_ATLAS_MAX_PAGES] = {0};
+
+	for(uint8_t i = 0; i < sl->spr_count; i++) {
+		Spritesheet *ss = &sl->spr_pool[i];
+
+		// Pack only holds atlas pages, sheets that needed their own texture can't be stored
+		if(ss->atlas_page >= sl->atlas_count) {
+			printf("ERROR: spritesheet[%d] is not in an atlas page, can't be packed\n", i);
+			return false;
+		}
+
+		const char *source = (sl->sources[i]) ? sl->sources[i] : "";
+		if(strlen(source) >= ASSET_PACK_NAME_LEN) {
+			printf("ERROR: spritesheet[%d] source path too long: %s\n", i, source);
+			return false;
+		}
+
+		strcpy(sheets[i].source, source);
+		sheets[i].frame_count = ss->frame_count;
+		sheets[i].cols = ss->cols;
+		sheets[i].rows = ss->rows;
+		sheets[i].frame_w = ss->frame_w;
+		sheets[i].frame_h = ss->frame_h;
+		sheets[i].page = ss->atlas_page;
+		sheets[i].atlas_x = ss->atlas_x;
+		sheets[i].atlas_y = ss->atlas_y;
+		sheets[i].block = SpriteBlockOfSheet(i);
+
+		// Blocks share pages, a page is loaded with the first block using it
+		pages[ss->atlas_page].blocks |= 1u << sheets[i].block;
+	}
+
+	for(uint8_t i = 0; i < sl->anim_count; i++) {
+		SpriteAnimation *anim = &sl->anims[i];
+		anims[i] = (AssetPackAnim) {
+			.sheet = anim->spritesheet - sl->spr_pool,
+			.start_frame = anim->start_frame,
+			.frame_count = anim->frame_count,
+			.speed = anim->speed
+		};
+	}
+
+	// Page pixels follow tables, each page starts on its own alignment boundary
+	uint32_t offset = AlignUp(TablesSize(header.sheet_count, header.anim_count, header.page_count));
+	for(uint8_t p = 0; p < sl->atlas_count; p++) {
+		Image *img = &sl->atlas.pages[p];
+		if(img->format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) ImageFormat(img, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+		pages[p].width = img->width;
+		pages[p].height = img->height;
+		pages[p].offset = offset;
+		pages[p].size = (uint32_t)img->width * img->height * 4;
+		offset = AlignUp(offset + pages[p].size);
+	}
+
+	header.file_size = offset;
+
+	FILE *pF = fopen(path, "wb");
+	if(!pF) {
+		printf("ERROR: Could not write asset pack: %s\n", path);
+		return false;
+	}
+
+	fwrite(&header, sizeof(header), 1, pF);
+	fwrite(sheets, sizeof(AssetPackSheet), header.sheet_count, pF);
+	fwrite(anims, sizeof(AssetPackAnim), header.anim_count, pF);
+	fwrite(pages, sizeof(AssetPackPage), header.page_count, pF);
+
+	for(uint8_t p = 0; p < sl->atlas_count; p++) {
+		fseek(pF, pages[p].offset, SEEK_SET);
+		fwrite(sl->atlas.pages[p].data, 1, pages[p].size, pF);
+	}
+
+	// Pad last page so file size matches header
+	fseek(pF, header.file_size - 1, SEEK_SET);
+	fputc(0, pF);
+
+	bool ok = !ferror(pF);
+	if(fclose(pF) != 0) ok = false;
+
+	if(!ok) {
+		printf("ERROR: Failed writing asset pack: %s\n", path);
+		return false;
+	}
+
+	printf("asset pack written to: %s (%d sheets, %d anims, %d pages, %u bytes)\n",
+		path, header.sheet_count, header.anim_count, header.page_count, header.file_size);
+
+	return true;
+}
+
+// Check tables of a mapped pack before anything is read from them
+static bool AssetPackValidate(AssetPack *pack) {
+	const AssetPackHeader *header = pack->header;
+	size_t size = pack->size;
+
+	if(header->magic != ASSET_PACK_MAGIC || header->version != ASSET_PACK_VERSION) return false;
+	if(header->file_size != size) return false;
+	if(header->sheet_count > SPR_POOL_CAPACITY || header->anim_count > SPR_POOL_CAPACITY) return false;
+	if(header->page_count > SPR_ATLAS_MAX_PAGES) return false;
+	if(TablesSize(header->sheet_count, header->anim_count, header->page_count) > size) return false;
+
+	for(uint32_t p = 0; p < header->page_count; p++) {
+		const AssetPackPage *page = &pack->pages[p];
+		if(page->size != page->width * page->height * 4 || !page->blocks || (page->blocks >> SPR_BLOCK_COUNT)) return false;
+		if(page->offset % ASSET_PACK_ALIGN || page->offset > size || page->size > size - page->offset) return false;
+	}
+
+	for(uint32_t i = 0; i < header->sheet_count; i++) {
+		const AssetPackSheet *sheet = &pack->sheets[i];
+		if(sheet->page >= header->page_count || sheet->source[ASSET_PACK_NAME_LEN - 1] != '\0') return false;
+		if(sheet->cols == 0 || sheet->rows == 0) return false;
+
+		// Sheet must lie inside a page used by it's own block
+		const AssetPackPage *page = &pack->pages[sheet->page];
+		if(sheet->block >= SPR_BLOCK_COUNT || !(page->blocks & (1u << sheet->block))) return false;
+		if(sheet->atlas_x + sheet->cols * sheet->frame_w > page->width) return false;
+		if(sheet->atlas_y + sheet->rows * sheet->frame_h > page->height) return false;
+	}
+
+	for(uint32_t i = 0; i < header->anim_count; i++)
+		if(pack->anims[i].sheet >= header->sheet_count) return false;
+
+	return true;
+}
+
+// Pack made before one of its source pngs changed, loose files are newer
+static bool AssetPackStale(AssetPack *pack, time_t pack_time) {
+	for(uint32_t i = 0; i < pack->header->sheet_count; i++) {
+		const char *source = pack->sheets[i].source;
+
+		struct stat st;
+		if(source[0] == '\0' || stat(source, &st) != 0) continue;
+
+		if(st.st_mtime > pack_time) {
+			printf("asset pack older than %s, loading loose files\n", source);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool AssetPackOpen(AssetPack *pack, const char *path) {
+	*pack = (AssetPack){0};
+
+	int fd = open(path, O_RDONLY);
+	if(fd < 0) return false;
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(AssetPackHeader)) {
+		close(fd);
+		return false;
+	}
+
+	size_t size = st.st_size;
+	void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if(map == MAP_FAILED) return false;
+
+	pack->base = map;
+	pack->size = size;
+	pack->header = map;
+	pack->sheets = (const AssetPackSheet*)(pack->header + 1);
+	pack->anims = (const AssetPackAnim*)(pack->sheets + pack->header->sheet_count);
+	pack->pages = (const AssetPackPage*)(pack->anims + pack->header->anim_count);
+
+	// Table pointers are only used once counts are known to fit the file
+	if(!AssetPackValidate(pack)) {
+		printf("ERROR: Invalid asset pack: %s\n", path);
+		AssetPackClose(pack);
+		return false;
+	}
+
+	if(AssetPackStale(pack, st.st_mtime)) {
+		AssetPackClose(pack);
+		return false;
+	}
+
+	printf("asset pack opened: %s (%d sheets, %d anims, %d pages)\n", 
+		path, pack->header->sheet_count, pack->header->anim_count, pack->header->page_count);
+
+	return true;
+}
+
+void AssetPackClose(AssetPack *pack) {
+	if(pack->base) munmap(pack->base, pack->size);
+	*pack = (AssetPack){0};
+}
+
+void AssetPackReadBlock(AssetPack *pack, uint8_t block, SpriteLoader *sl) {
+	for(uint32_t i = 0; i < pack->header->sheet_count; i++) {
+		const AssetPackSheet *sheet = &pack->sheets[i];
+		if(sheet->block != block) continue;
+
+		sl->spr_pool[i] = (Spritesheet) {
+			.flags = (SPR_ALLOCATED | SPR_META_ONLY),
+			.frame_count = sheet->frame_count,
+			.cols = sheet->cols,
+			.rows = sheet->rows,
+			.frame_w = sheet->frame_w,
+			.frame_h = sheet->frame_h,
+			.atlas_page = sheet->page,
+			.atlas_x = sheet->atlas_x,
+			.atlas_y = sheet->atlas_y
+		};
+		sl->sources[i] = sheet->source;
+	}
+
+	// Animation speed is stored already scaled, set fields directly instead of going through AnimCreate
+	for(uint32_t i = 0; i < pack->header->anim_count; i++) {
+		const AssetPackAnim *anim = &pack->anims[i];
+		if(pack->sheets[anim->sheet].block != block) continue;
+
+		sl->anims[i] = (SpriteAnimation) {
+			.frame_count = anim->frame_count,
+			.start_frame = anim->start_frame,
+			.cur_frame = anim->start_frame,
+			.speed = anim->speed,
+			.timer = anim->speed,
+			.spritesheet = &sl->spr_pool[anim->sheet]
+		};
+	}
+}
+
+long ProcessPeakRssKiB(void) {
+	struct rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+
+	// Linux reports ru_maxrss in KiB
+	return usage.ru_maxrss;
+}
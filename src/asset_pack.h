@@ -0,0 +1,83 @@
+#ifndef ASSET_PACK_H_
+#define ASSET_PACK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sprites.h"
+
+// Asset pack:
+// sprite blocks from load_content.c baked offline by the asset packer (make pack),
+// atlas pages are stored as decoded RGBA pixels so loading is mmap and upload, no png decode or atlas packing.
+// Sheets and animations are stored in pool slot order, pages are shared by every block with sheets on them
+//
+// Layout: header, sheet table, animation table, page table, then page pixels (each page aligned to ASSET_PACK_ALIGN),
+// table entries are multiples of 4 bytes so every table stays aligned inside the mapping
+
+#define ASSET_PACK_PATH		"resources.pack"
+#define ASSET_PACK_MAGIC	0x4B505346		// "FSPK"
+#define ASSET_PACK_VERSION	3
+#define ASSET_PACK_ALIGN	4096
+#define ASSET_PACK_NAME_LEN	64
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t sheet_count;
+	uint32_t anim_count;
+	uint32_t page_count;
+	uint32_t file_size;
+} AssetPackHeader;
+
+typedef struct {
+	char source[ASSET_PACK_NAME_LEN];	// Png sheet was made from, pack is rejected if source is newer
+	uint8_t frame_count;
+	uint8_t cols, rows;
+	uint8_t frame_w, frame_h;
+	uint8_t page;						// Atlas page holding sheet's pixels
+	uint16_t atlas_x, atlas_y;
+	uint8_t block;						// Content block sheet is loaded with
+	uint8_t pad;
+} AssetPackSheet;
+
+typedef struct {
+	uint8_t sheet;						// Index into sheet table
+	uint8_t start_frame;
+	uint8_t frame_count;
+	uint8_t pad;
+	float speed;
+} AssetPackAnim;
+
+typedef struct {
+	uint32_t width, height;
+	uint32_t offset;					// Byte offset of RGBA8 pixels from start of file
+	uint32_t size;
+	uint32_t blocks;					// Bit of each block with sheets on page
+} AssetPackPage;
+
+// Mapped pack, tables point into the mapping
+typedef struct {
+	uint8_t *base;
+	size_t size;
+
+	const AssetPackHeader *header;
+	const AssetPackSheet *sheets;
+	const AssetPackAnim *anims;
+	const AssetPackPage *pages;
+} AssetPack;
+
+// Write sheets, animations and atlas page images of a loader made with SPR_LOADER_KEEP_PAGES,
+// every sprite block must be loaded
+bool AssetPackWrite(SpriteLoader *sl, const char *path);
+
+// Map pack and check it's tables, returns false if pack is missing, invalid or older than its sources
+bool AssetPackOpen(AssetPack *pack, const char *path);
+void AssetPackClose(AssetPack *pack);
+
+// Fill slots of a block's sheets and animations from pack tables, sheets are left without textures,
+// atlas_page is set to the pack's page index
+void AssetPackReadBlock(AssetPack *pack, uint8_t block, SpriteLoader *sl);
+
+// Peak resident set size of process so far, in KiB
+long ProcessPeakRssKiB(void);
+
+#endif // !ASSET_PACK_H_
@@ -1,20 +1,22 @@
+#include <stdint.h>
 #include "raylib.h"
 #include "entity.h"
 #include "sprites.h"
 
-void AsteroidUpdate(Entity *asteroid, float dt) 
+void AsteroidDrawBatch(Entity **asteroids, uint32_t count, RenderQueue *rq, SpriteLoader *sl) 
 {
+	// Every asteroid uses the same sheet and frame
+	Spritesheet *sheet = &sl->spr_pool[1];
 
-}
-
-void AsteroidDraw(Entity *asteroid, SpriteLoader *sl) 
-{
-	DrawSpritePro(&sl->spr_pool[1], 0, asteroid->position, asteroid->sprite_angle, 0);
+	for(uint32_t i = 0; i < count; i++) {
+		Entity *asteroid = asteroids[i];
+		RenderQueueSprite(rq, sheet, 0, asteroid->draw_pos, asteroid->draw_angle, 0, LAYER_BODIES);
 
-	/*
-	Vector2 center = (Vector2){asteroid->position.x + asteroid->radius, asteroid->position.y + asteroid->radius};
-	DrawCircleV(center, 10, RED);
-	DrawCircleLinesV(center, asteroid->radius, RAYWHITE);
-	DrawCircleLinesV(center, asteroid->radius * 3, RAYWHITE);
-	*/	
+		/*
+		Vector2 center = (Vector2){ENT_POS(asteroid).x + ENT_RADIUS(asteroid), ENT_POS(asteroid).y + ENT_RADIUS(asteroid)};
+		DrawCircleV(center, 10, RED);
+		DrawCircleLinesV(center, ENT_RADIUS(asteroid), RAYWHITE);
+		DrawCircleLinesV(center, ENT_RADIUS(asteroid) * 3, RAYWHITE);
+		*/	
+	}
 }
@@ -0,0 +1,13 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <time.h>
+#include "clock.h"
+
+// Current monotonic time in nanoseconds
+uint64_t ClockNowNs(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
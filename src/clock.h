@@ -0,0 +1,9 @@
+#ifndef CLOCK_H_
+#define CLOCK_H_
+
+#include <stdint.h>
+
+// Monotonic clock, works without a window or raylib timer
+uint64_t ClockNowNs(void);
+
+#endif // !CLOCK_H_
@@ -1,8 +1,24 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 #include "raylib.h"
 #include "config.h"
 
+static Config ConfigDefaults(void) {
+	return (Config) {
+		.windowWidth  = CONFIG_DEFAULT_WW,
+		.windowHeight = CONFIG_DEFAULT_WH,
+		.refreshRate  = CONFIG_DEFAULT_RR,
+		.tickRate     = CONFIG_DEFAULT_TR,
+		.maxTicksPerFrame = CONFIG_DEFAULT_MT,
+		.threadCount  = CONFIG_DEFAULT_TH,
+		.entityReserve = CONFIG_DEFAULT_ER,
+		.dynamicRes   = CONFIG_DEFAULT_DR
+	};
+}
+
 // Read configuration options from provided file
 void ConfigRead(Config *conf, char *path) {
 	// Open file
@@ -16,6 +32,9 @@ void ConfigRead(Config *conf, char *path) {
 	}
 
 	puts("Reading configuration file...");
+
+	// Options missing from file keep their default values
+	*conf = ConfigDefaults();
 	
 	// Parse config file line by line
 	char line[64];
@@ -40,6 +59,9 @@ void ConfigParseLine(Config *conf, char *line) {
 	char *key = line;
 	char *val = eq + 1;
 
+	// Strip line ending from value
+	val[strcspn(val, "\r\n")] = '\0';
+
 	if(streq(key, "window_width")) {
 		// Window width:    
 		// if auto option provided, set from monitor resolution
@@ -63,17 +85,47 @@ void ConfigParseLine(Config *conf, char *line) {
 			conf->refreshRate = GetMonitorRefreshRate(0);
 		else 
 			sscanf(val, "%f", &conf->refreshRate);
+
+	} else if(streq(key, "tick_rate")) {
+		// Simulation tick rate:
+		// if auto option provided, tick at refresh rate
+		if(streq(val, AUTO)) 
+			conf->tickRate = conf->refreshRate;
+		else 
+			sscanf(val, "%f", &conf->tickRate);
+
+		if(conf->tickRate <= 0) conf->tickRate = CONFIG_DEFAULT_TR;
+
+	} else if(streq(key, "max_ticks_per_frame")) {
+		// Most simulation ticks to catch up on per frame
+		sscanf(val, "%d", &conf->maxTicksPerFrame);
+		if(conf->maxTicksPerFrame < 1) conf->maxTicksPerFrame = 1;
+
+	} else if(streq(key, "threads")) {
+		// Job system threads, main thread included:
+		// if auto option provided, use one per cpu core
+		if(streq(val, AUTO)) 
+			conf->threadCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+		else
+			sscanf(val, "%d", &conf->threadCount);
+
+		if(conf->threadCount < 1) conf->threadCount = 1;
+
+	} else if(streq(key, "entity_reserve")) {
+		// Entities to allocate storage for up front, 
+		// scenes with more entities grow storage as they go
+		sscanf(val, "%d", &conf->entityReserve);
+		if(conf->entityReserve < 0) conf->entityReserve = 0;
+
+	} else if(streq(key, "dynamic_res")) {
+		// Lower render resolution when frames run over budget, 0 to always render at full size
+		sscanf(val, "%d", &conf->dynamicRes);
 	}
 }
 
 // Set default config options 
 void ConfigSetDefault(Config *conf) {
-	*conf = (Config) {
-		.windowWidth  = CONFIG_DEFAULT_WW,
-		.windowHeight = CONFIG_DEFAULT_WH,
-		.refreshRate  = CONFIG_DEFAULT_RR
-	};
-
+	*conf = ConfigDefaults();
 	ConfigPrintValues(conf);
 }
 
@@ -81,5 +133,9 @@ void ConfigSetDefault(Config *conf) {
 void ConfigPrintValues(Config *conf) {
 	printf("resolution: %dx%d\n", conf->windowWidth, conf->windowHeight);
 	printf("refresh rate: %f\n", conf->refreshRate);
+	printf("tick rate: %f, max ticks per frame: %d\n", conf->tickRate, conf->maxTicksPerFrame);
+	printf("threads: %d\n", conf->threadCount);
+	printf("entity reserve: %d\n", conf->entityReserve);
+	printf("dynamic resolution: %d\n", conf->dynamicRes);
 }
 
@@ -7,12 +7,32 @@
 #define CONFIG_DEFAULT_WH	1080
 #define CONFIG_DEFAULT_RR	  60
 
+// Default simulation tick rate and most ticks simulated per rendered frame
+#define CONFIG_DEFAULT_TR	  60
+#define CONFIG_DEFAULT_MT	   5
+
+// Default thread count for job system, main thread included
+#define CONFIG_DEFAULT_TH	   1
+
+// Default number of entities to allocate storage for on start, storage still grows past it
+#define CONFIG_DEFAULT_ER	1024
+
+// Dynamic resolution on by default
+#define CONFIG_DEFAULT_DR	   1
+
 #define AUTO "auto"
 #define streq(a, b) (strcmp((a), (b)) == 0)
 
 typedef struct {
 	int windowWidth, windowHeight;
 	float refreshRate;
+
+	float tickRate;
+	int maxTicksPerFrame;
+
+	int threadCount;
+	int entityReserve;
+	int dynamicRes;
 } Config;
 
 void ConfigRead(Config *conf, char *path);
@@ -0,0 +1,65 @@
+#ifndef CONTENT_H_
+#define CONTENT_H_
+
+#include <stdint.h>
+#include "sprites.h"
+
+// Content blocks:
+// assets are grouped into blocks that load together, sprite blocks share atlas pages in the order they're loaded.
+// Sheets and animations get fixed pool slots in table order, so block load order doesn't move them
+
+#define BLOCK_MAX_SHEETS	8
+#define BLOCK_MAX_ANIMS		8
+#define BLOCK_MAX_SOUNDS	16
+
+enum SPRITE_BLOCKS {
+	SPR_BLOCK_PLAYER,
+	SPR_BLOCK_BODIES,
+	SPR_BLOCK_COUNT
+};
+
+enum AUDIO_BLOCKS {
+	AUDIO_BLOCK_MAIN,
+	AUDIO_BLOCK_COUNT
+};
+
+typedef struct {
+	const char *path;
+	uint8_t frame_w, frame_h;
+} BlockSheet;
+
+typedef struct {
+	uint8_t sheet;					// Sheet index inside block
+	uint8_t col, row;				// First frame
+	uint8_t frame_count;
+	float speed;
+} BlockAnim;
+
+typedef struct {
+	uint8_t sheet_count, anim_count;
+	uint8_t sheet_base, anim_base;	// First pool slots, filled in by ContentBlocksInit
+
+	BlockSheet sheets[BLOCK_MAX_SHEETS];
+	BlockAnim anims[BLOCK_MAX_ANIMS];
+} SpriteBlock;
+
+typedef struct {
+	uint8_t sound_count;
+	uint8_t sound_base;
+
+	const char *paths[BLOCK_MAX_SOUNDS];
+} AudioBlock;
+
+extern SpriteBlock sprite_blocks[SPR_BLOCK_COUNT];
+extern AudioBlock audio_blocks[AUDIO_BLOCK_COUNT];
+
+// Assign pool slots of every block, call once before loading anything
+void ContentBlocksInit(void);
+
+// Block a sheet slot belongs to, SPR_BLOCK_COUNT if none
+uint8_t SpriteBlockOfSheet(uint8_t slot);
+
+// Load a sprite block on calling thread and pack it's atlas pages (asset packer, tools)
+void LoadSpriteBlock(SpriteLoader *sl, uint8_t block_id);
+
+#endif // !CONTENT_H_
@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include "raylib.h"
+#include "dyn_res.h"
+
+// Resolution scale of each level
+static const float level_scales[DYN_RES_LEVELS] = { 1.0f, 0.875f, 0.75f, 0.625f, 0.5f };
+
+void DynResInit(DynRes *dr, int width, int height, int window_width, int window_height, float refresh_rate, bool enabled) {
+	*dr = (DynRes){0};
+	dr->width = width;
+	dr->height = height;
+	dr->enabled = enabled;
+	dr->direct = (window_width == width && window_height == height);
+
+	dr->budget_ns = 1e9f / ((refresh_rate > 0) ? refresh_rate : 60.0f);
+	dr->load_ns = 0;
+	dr->raise_frames = DYN_RES_RAISE_FRAMES;
+	dr->since_raise = DYN_RES_PROBE_FRAMES;
+
+	for(uint8_t i = 0; i < DYN_RES_LEVELS; i++) {
+		int w = width * level_scales[i];
+		int h = height * level_scales[i];
+		dr->scales[i] = level_scales[i];
+
+		// Levels that never get used still get their target, switching mid game must not allocate
+		dr->targets[i] = LoadRenderTexture(w, h);
+		dr->src_recs[i] = (Rectangle){ 0, 0, w, -h };
+
+		// Full size keeps sharp pixels, scaled levels are filtered when stretched back up
+		SetTextureFilter(dr->targets[i].texture, (i == 0) ? TEXTURE_FILTER_POINT : TEXTURE_FILTER_BILINEAR);
+
+		if(!enabled) break;
+	}
+}
+
+void DynResClose(DynRes *dr) {
+	for(uint8_t i = 0; i < DYN_RES_LEVELS; i++) {
+		if(dr->targets[i].id) UnloadRenderTexture(dr->targets[i]);
+		dr->targets[i] = (RenderTexture2D){0};
+	}
+}
+
+static void DynResSetLevel(DynRes *dr, uint8_t level) {
+	printf("render scale %.3f -> %.3f (%.2f ms of %.2f ms)\n",
+		dr->scales[dr->level], dr->scales[level], dr->load_ns * 1e-6f, dr->budget_ns * 1e-6f);
+
+	dr->level = level;
+	dr->over_frames = 0;
+	dr->under_frames = 0;
+}
+
+bool DynResUpdate(DynRes *dr, uint64_t work_ns, float frame_time) {
+	if(!dr->enabled) return false;
+
+	// Frame limiter waits make frame time useless as a measure under budget, work time is used instead.
+	// Once frames run long though, time lost outside measured work (swap, driver, gpu) is counted too
+	float frame_ns = frame_time * 1e9f;
+	float load = (frame_ns > dr->budget_ns * DYN_RES_OVERRUN) ? frame_ns : (float)work_ns;
+
+	dr->load_ns += (load - dr->load_ns) * DYN_RES_SMOOTHING;
+	dr->since_raise++;
+
+	dr->over_frames = (dr->load_ns > dr->budget_ns * DYN_RES_DROP_LOAD) ? dr->over_frames + 1 : 0;
+	dr->under_frames = (dr->load_ns < dr->budget_ns * DYN_RES_RAISE_LOAD) ? dr->under_frames + 1 : 0;
+
+	if(dr->over_frames >= DYN_RES_DROP_FRAMES && dr->level + 1 < DYN_RES_LEVELS) {
+		// Raised level didn't hold, wait longer before trying it again
+		if(dr->since_raise < DYN_RES_PROBE_FRAMES && dr->raise_frames < DYN_RES_RAISE_MAX) dr->raise_frames *= 2;
+
+		DynResSetLevel(dr, dr->level + 1);
+		return true;
+	}
+
+	if(dr->under_frames >= dr->raise_frames && dr->level > 0) {
+		DynResSetLevel(dr, dr->level - 1);
+		dr->since_raise = 0;
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,63 @@
+#ifndef DYN_RES_H_
+#define DYN_RES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "raylib.h"
+
+// Dynamic resolution:
+// render targets for a fixed set of scales are allocated up front, each frame's cost picks which one is drawn to.
+// Drops a level after a run of frames over budget, raises one after a longer run well under it.
+// A raise that is dropped again soon after doubles the wait before the next raise, so a level that doesn't fit isn't retried every few seconds
+
+#define DYN_RES_LEVELS			5
+#define DYN_RES_DROP_LOAD		0.90f		// Fraction of frame budget, averaged load above this counts as over
+#define DYN_RES_RAISE_LOAD		0.70f		// Averaged load below this counts as under
+#define DYN_RES_OVERRUN			1.10f		// Frames this much over budget count their whole time as load
+#define DYN_RES_DROP_FRAMES		10			// Frames over budget in a row before dropping
+#define DYN_RES_RAISE_FRAMES	120			// Frames under budget in a row before raising, starting value
+#define DYN_RES_RAISE_MAX		1920		// Most frames raise wait can back off to
+#define DYN_RES_PROBE_FRAMES	180			// Drop this soon after a raise means the raised level didn't fit
+#define DYN_RES_SMOOTHING		0.1f		// Weight of newest frame in load average
+
+typedef struct {
+	int width, height;						// Virtual resolution, size of level 0
+	float scales[DYN_RES_LEVELS];			// Resolution scale of each level, level 0 is full size
+	RenderTexture2D targets[DYN_RES_LEVELS];
+	Rectangle src_recs[DYN_RES_LEVELS];		// Flipped source rectangle of each target
+
+	bool enabled;							// Levels only change if set
+	bool direct;							// Window matches virtual size, level 0 draws straight to backbuffer
+	uint8_t level;
+
+	float budget_ns;						// Frame time at target refresh rate
+	float load_ns;							// Smoothed frame cost
+	uint32_t over_frames, under_frames;
+	uint32_t raise_frames;					// Under budget frames needed for next raise
+	uint32_t since_raise;					// Frames since last raise
+} DynRes;
+
+// Allocate a render target per level, needs a GL context.
+// Direct path is used while at full size if window is exactly width x height
+void DynResInit(DynRes *dr, int width, int height, int window_width, int window_height, float refresh_rate, bool enabled);
+void DynResClose(DynRes *dr);
+
+// Feed one frame's cost, work_ns is time spent updating and drawing, frame_time is the full frame including waits.
+// Returns true if level changed
+bool DynResUpdate(DynRes *dr, uint64_t work_ns, float frame_time);
+
+static inline float DynResScale(DynRes *dr) {
+	return dr->scales[dr->level];
+}
+
+// Render target of current level
+static inline RenderTexture2D *DynResTarget(DynRes *dr) {
+	return &dr->targets[dr->level];
+}
+
+// Skip the render target, draw straight to window
+static inline bool DynResDirect(DynRes *dr) {
+	return dr->direct && dr->level == 0;
+}
+
+#endif // !DYN_RES_H_
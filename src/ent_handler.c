@@ -1,19 +1,32 @@
 #include <math.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <float.h>
 #include "raylib.h"
 #include "raymath.h"
 #include "ent_handler.h"
 #include "entity.h"
+#include "clock.h"
+#include "kmath.h"
+#include "profiler.h"
+#include "projectiles.h"
+
+// Maximum count of entity type
+uint32_t type_max[] = {
+	[ENT_PLAYER]   = MAX_PLAYERS,
+	[ENT_ASTEROID] = MAX_ASTEROIDS,
+	[ENT_FISH]     = MAX_FISH,
+	[ENT_NPC]      = MAX_NPCS
+};
 
-// Maximum count of entity type array
-uint16_t type_max[] = {
-	MAX_PLAYERS,
-	MAX_FISH,
-	MAX_NPCS,
-	MAX_ASTEROIDS
+// Size of entity type's data
+size_t type_data_size[] = {
+	[ENT_PLAYER]   = sizeof(PlayerData),
+	[ENT_ASTEROID] = sizeof(AsteroidData),
+	[ENT_FISH]     = sizeof(FishData),
+	[ENT_NPC]      = sizeof(NpcData)
 };
 
 Vector2 ray_start;
@@ -22,212 +35,976 @@ Vector2 ray_coll_point;
 
 // Entity reservation function prototype and array 
 typedef void(*ReserveDataFunc)(EntHandler *handler, Entity *ent);
-ReserveDataFunc data_reserve_funcs[] = { &ReserveDataPlayer, &ReserveDataFish, &ReserveDataNpc, &ReserveDataAsteroid };
+ReserveDataFunc data_reserve_funcs[] = { &ReserveDataPlayer, &ReserveDataAsteroid, &ReserveDataFish, &ReserveDataNpc };
+
+// Update batch function of each type, NULL for types that don't update
+EntUpdateBatchFunc ent_update_funcs[] = { &PlayerUpdateBatch, NULL, NULL, NULL };
 
-// Entity update function prototype and array 
-typedef void(*EntUpdateFunc)(Entity *ent, float dt);
-EntUpdateFunc ent_update_funcs[] = { &PlayerUpdate, &AsteroidUpdate, NULL, NULL };
+// Types updated on main thread (input, camera, etc.), all others update in parallel batches
+bool type_update_serial[] = {
+	[ENT_PLAYER]   = true,
+	[ENT_ASTEROID] = false,
+	[ENT_FISH]     = false,
+	[ENT_NPC]      = false
+};
 
-// Entity draw function prototype and array 
-typedef void(*EntDrawFunc)(Entity *ent, SpriteLoader *sl);
-EntDrawFunc ent_draw_funcs[] = { &PlayerDraw, &AsteroidDraw, NULL, NULL };
+// Types pulled by body gravity while free floating
+bool type_gravity[] = {
+	[ENT_PLAYER]   = true,
+	[ENT_ASTEROID] = false,
+	[ENT_FISH]     = true,
+	[ENT_NPC]      = true
+};
+
+// Draw batch function of each type, NULL for types that aren't drawn
+EntDrawBatchFunc ent_draw_funcs[] = { &PlayerDrawBatch, &AsteroidDrawBatch, NULL, NULL };
 
 // Initialize entity handler 
-void EntHandlerInit(EntHandler *handler, SpriteLoader *sprite_loader, Camera2D *camera) {
+void EntHandlerInit(EntHandler *handler, SpriteLoader *sprite_loader, RenderQueue *render_queue, Camera2D *camera) {
 	handler->sprite_loader = sprite_loader;
+	handler->render_queue = render_queue;
 	handler->camera = camera;
+	handler->input = NULL;
+	handler->particles = NULL;
+	handler->projectiles = NULL;
+	handler->world = NULL;
+	handler->player = ENT_HANDLE_NONE;
+
+	// Initialize slot pools and arenas, nothing is allocated until entities are made or reserved
+	handler->count = 0;
+	handler->capacity = 0;
+	handler->active = NULL;
+	handler->update_list = NULL;
+	handler->draw_list = NULL;
+	handler->batches = NULL;
+	handler->cmd_buffers = NULL;
+	handler->query_ids = NULL;
+
+	handler->ent_pool = (SlotPool){ .cap = ENT_MAX_ENTITIES };
+	ArenaInit(&handler->chunks, sizeof(EntChunk), 0, ENT_MAX_ENTITIES / ENT_CHUNK_SIZE);
+
+	handler->orbit_pool = (SlotPool){ .cap = MAX_ORBITERS };
+	ArenaInit(&handler->orbit_data, sizeof(OrbitData), ENT_DATA_CHUNK_BITS, MAX_ORBITERS);
+
+	for(uint8_t i = 0; i < ENT_TYPE_COUNT; i++) {
+		handler->type_counts[i] = 0;
+		handler->data_pools[i] = (SlotPool){ .cap = type_max[i] };
+		ArenaInit(&handler->type_data[i], type_data_size[i], ENT_DATA_CHUNK_BITS, type_max[i]);
+	}
+
+	GridInit(&handler->grid, ENT_GRID_CELL_SIZE, 0);
+	OrbitBatchInit(&handler->orbit_batch, 0);
+	GravityTreeInit(&handler->gravity);
+	GravityBatchInit(&handler->gravity_batch);
+	handler->max_radius = 0;
+	handler->max_body_radius = 0;
+
+	// Updates run serially until a job system is set
+	handler->jobs = NULL;
+	handler->updating = false;
+	memset(handler->worker_cmds, 0, sizeof(handler->worker_cmds));
+}
+
+// Free memory allocated by entity handler
+void EntHandlerClose(EntHandler *handler) {
+	GridClose(&handler->grid);
+	OrbitBatchClose(&handler->orbit_batch);
+	GravityTreeClose(&handler->gravity);
+	GravityBatchClose(&handler->gravity_batch);
+
+	ArenaClose(&handler->chunks);
+	ArenaClose(&handler->orbit_data);
+	SlotPoolClose(&handler->ent_pool);
+	SlotPoolClose(&handler->orbit_pool);
+
+	for(uint8_t i = 0; i < ENT_TYPE_COUNT; i++) {
+		ArenaClose(&handler->type_data[i]);
+		SlotPoolClose(&handler->data_pools[i]);
+	}
+
+	free(handler->active);
+	free(handler->update_list);
+	free(handler->draw_list);
+	free(handler->batches);
+	free(handler->cmd_buffers);
+	free(handler->query_ids);
+
+	handler->active = NULL;
+	handler->update_list = NULL;
+	handler->draw_list = NULL;
+	handler->batches = NULL;
+	handler->cmd_buffers = NULL;
+	handler->query_ids = NULL;
+	handler->count = 0;
+	handler->capacity = 0;
+}
+
+// Grow array of elem_size elements from old_count to new_count, new elements are zeroed.
+// Array is left as is on failure
+static bool GrowArray(void **array, size_t elem_size, uint32_t old_count, uint32_t new_count) {
+	void *grown = realloc(*array, elem_size * new_count);
+	if(!grown) return false;
+
+	memset((char*)grown + elem_size * old_count, 0, elem_size * (new_count - old_count));
+	*array = grown;
+
+	return true;
+}
+
+// Entity storage grows a chunk at a time, index lists are grown to match
+bool EntHandlerReserve(EntHandler *handler, uint32_t count) {
+	if(count <= handler->capacity) return true;
+	if(count > ENT_MAX_ENTITIES) return false;
+
+	uint32_t chunk_count = (count + ENT_CHUNK_SIZE - 1) >> ENT_CHUNK_BITS;
+	if(!ArenaReserve(&handler->chunks, chunk_count)) return false;
+
+	uint32_t old_cap = handler->capacity;
+	uint32_t new_cap = chunk_count << ENT_CHUNK_BITS;
+	uint32_t old_batches = (old_cap) ? ENT_UPDATE_MAX_BATCHES(old_cap) : 0;
+	uint32_t new_batches = ENT_UPDATE_MAX_BATCHES(new_cap);
+
+	bool grown = 
+		GrowArray((void**)&handler->active, sizeof(uint32_t), old_cap, new_cap) &&
+		GrowArray((void**)&handler->update_list, sizeof(Entity*), old_cap, new_cap) &&
+		GrowArray((void**)&handler->draw_list, sizeof(Entity*), old_cap, new_cap) &&
+		GrowArray((void**)&handler->query_ids, sizeof(int32_t), old_cap, new_cap) &&
+		GrowArray((void**)&handler->batches, sizeof(EntUpdateBatch), old_batches, new_batches) &&
+		GrowArray((void**)&handler->cmd_buffers, sizeof(EntCmdBuffer), old_batches, new_batches) &&
+		GridReserve(&handler->grid, new_cap);
+
+	// Arrays that did grow keep their new size, capacity only moves once all of them have
+	if(!grown) return false;
+
+	handler->capacity = new_cap;
+	return true;
+}
+
+size_t EntHandlerBytes(EntHandler *handler) {
+	size_t bytes = ArenaBytes(&handler->chunks) + ArenaBytes(&handler->orbit_data);
+	for(uint8_t i = 0; i < ENT_TYPE_COUNT; i++) bytes += ArenaBytes(&handler->type_data[i]);
+
+	return bytes;
+}
+
+// FNV-1a step over a whole 32 bit word, floats are hashed by their bit patterns
+static inline uint32_t HashWord(uint32_t hash, uint32_t word) {
+	return (hash ^ word) * 16777619u;
+}
+
+static inline uint32_t FloatBits(float f) {
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	return bits;
+}
+
+uint32_t EntHandlerHash(EntHandler *handler) {
+	uint32_t hash = HashWord(2166136261u, handler->count);
+
+	for(uint32_t i = 0; i < handler->count; i++) {
+		uint32_t id = handler->active[i];
+		Entity *ent = EntAt(handler, id);
+		Vector2 pos = ENT_POS(ent), vel = ENT_VEL(ent);
+
+		hash = HashWord(hash, id);
+		hash = HashWord(hash, ENT_FLAGS(ent) | (ENT_TYPEOF(ent) << 8));
+		hash = HashWord(hash, FloatBits(pos.x));
+		hash = HashWord(hash, FloatBits(pos.y));
+		hash = HashWord(hash, FloatBits(vel.x));
+		hash = HashWord(hash, FloatBits(vel.y));
+
+		if(ent->orbit && (ENT_FLAGS(ent) & ENT_ORBIT)) {
+			hash = HashWord(hash, EntHandleKey(handler, ent->orbit->anchor));
+			hash = HashWord(hash, FloatBits(ent->orbit->angle));
+		}
+	}
+
+	if(handler->projectiles) hash = ProjectileSystemHash(handler->projectiles, hash);
+
+	return hash;
 }
 
 // Update all entities
 void EntHandlerUpdate(EntHandler *handler, float dt) {
-	Entity *player_ent = &handler->ents[0];
-	PlayerData *p = player_ent->data;
+	PROF_BEGIN("EntHandlerUpdate");
+
+	EntTimings *timings = handler->timings;
+	uint64_t t0 = (timings) ? ClockNowNs() : 0;
+
+	// Keep start of tick state for render interpolation
+	EntHandlerStorePrev(handler);
+
+	// Drop player anchor if orbited body was destroyed
+	Entity *player_ent = EntPlayer(handler);
+	if(player_ent) {
+		PlayerData *p = player_ent->data;
+		if(!EntGet(handler, p->anchor)) p->anchor = ENT_HANDLE_NONE;
+	}
+
+	PROF_BEGIN("EntOrbitUpdateAll");
+	EntOrbitUpdateAll(handler, dt);
+	PROF_END();
+
+	uint64_t t1 = (timings) ? ClockNowNs() : 0;
+
+	PROF_BEGIN("EntGravityUpdate");
+	EntGravityUpdate(handler, dt);
+	PROF_END();
+
+	uint64_t tg = (timings) ? ClockNowNs() : 0;
 
-	if(p->anchor_id > -1)	
-		EntOrbitUpdate(player_ent, &handler->ents[p->anchor_id], dt);
+	handler->updating = true;
+	handler->update_dt = dt;
 
-	for(uint16_t i = 0; i < handler->count; i++) {
-		// Get entity pointer
-		Entity *ent = &handler->ents[i];
+	// Main thread batches first, then all other batches in parallel, returns once every batch is done
+	PROF_BEGIN("EntUpdateBatches");
+	EntBuildUpdateBatches(handler);
+	for(uint32_t b = 0; b < handler->serial_batch_count; b++) EntRunUpdateBatch(handler, b);
+	JobParallelFor(handler->jobs, EntUpdateJob, handler, handler->batch_count - handler->serial_batch_count, 1);
+	PROF_END();
 
-		// Skip update if not active
-		if(!(ent->flags & ENT_ACTIVE)) continue;
+	// Apply commands in batch order, same result for any thread count
+	handler->updating = false;
+	for(uint32_t b = 0; b < handler->batch_count; b++) {
+		EntCmdBuffer *buf = &handler->cmd_buffers[b];
 
-		// Call entity's update function
-		if(ent->update) ent->update(ent, dt);
+		for(uint16_t i = 0; i < buf->count; i++) {
+			EntCmd *cmd = &buf->cmds[i];
+
+			switch(cmd->type) {
+				case ENT_CMD_DESTROY: 
+					EntDestroy(handler, cmd->handle);
+					break;
+			}
+		}
+
+		buf->count = 0;
 	}
+
+	PROF_BEGIN("GridSync");
+	EntGridSync(handler);
+	PROF_END();
+
+	uint64_t t2 = (timings) ? ClockNowNs() : 0;
 	
+	PROF_BEGIN("FindPlayerOrbit");
 	FindPlayerOrbit(handler, dt);
+	PROF_END();
+
+	if(timings) {
+		uint64_t t3 = ClockNowNs();
+		timings->orbit_ns += t1 - t0;
+		timings->gravity_ns += tg - t1;
+		timings->update_ns += t2 - tg;
+		timings->find_orbit_ns += t3 - t2;
+	}
+
+	PROF_END();
+}
+
+// Keep grid in sync with moving entities
+void EntGridSync(EntHandler *handler) {
+	for(uint32_t i = 0; i < handler->count; i++) {
+		uint32_t id = handler->active[i];
+		EntHot *hot = EntHotOf(handler, id);
+		uint32_t h = id & ENT_CHUNK_MASK;
+
+		GridMove(&handler->grid, id, Vector2Add(hot->position[h], hot->center_offset[h]));
+		if(hot->radius[h] > handler->max_radius) handler->max_radius = hot->radius[h];
+	}
 }
 
-// Draw all entities
-void EntHandlerDraw(EntHandler *handler, uint8_t flags) {
+void EntGravityUpdate(EntHandler *handler, float dt) {
+	GravityTree *tree = &handler->gravity;
+	GravityBatch *batch = &handler->gravity_batch;
+	tree->count = 0;
+	batch->count = 0;
+
+	// Count first, tree is only built when something will be pulled by it
+	uint32_t body_count = 0, float_count = 0;
+	for(uint32_t i = 0; i < handler->count; i++) {
+		uint32_t id = handler->active[i];
+		EntHot *hot = EntHotOf(handler, id);
+		uint32_t h = id & ENT_CHUNK_MASK;
+
+		if(hot->flags[h] & ENT_IS_BODY) body_count++;
+		else if(!(hot->flags[h] & ENT_ORBIT) && type_gravity[hot->type[h]]) float_count++;
+	}
+
+	if(!body_count || !float_count) return;
+	if(!GravityTreeReserve(tree, body_count) || !GravityBatchReserve(batch, float_count)) return;
+
+	// Active list order, tree and results are the same for any thread count
+	for(uint32_t i = 0; i < handler->count; i++) {
+		uint32_t id = handler->active[i];
+		EntHot *hot = EntHotOf(handler, id);
+		uint32_t h = id & ENT_CHUNK_MASK;
+		Vector2 center = Vector2Add(hot->position[h], hot->center_offset[h]);
+
+		if(hot->flags[h] & ENT_IS_BODY) {
+			uint32_t n = tree->count++;
+			tree->x[n] = center.x;
+			tree->y[n] = center.y;
+			tree->mass[n] = hot->radius[h] * hot->radius[h];
+		} else if(!(hot->flags[h] & ENT_ORBIT) && type_gravity[hot->type[h]]) {
+			uint32_t n = batch->count++;
+			batch->ids[n] = id;
+			batch->x[n] = center.x;
+			batch->y[n] = center.y;
+		}
+	}
+
+	GravityTreeBuild(tree);
+	GravityBatchSolve(batch, tree, handler->jobs);
+
+	for(uint32_t n = 0; n < batch->count; n++) {
+		Entity *ent = EntAt(handler, batch->ids[n]);
+		Vector2 accel = { batch->ax[n], batch->ay[n] };
+		ENT_VEL(ent) = Vector2Add(ENT_VEL(ent), Vector2Scale(accel, dt));
+
+		uint8_t type = ENT_TYPEOF(ent);
+		if(!ent_update_funcs[type]) EntUpdatePosition(ent, dt);
+
+		if(type == ENT_PLAYER) {
+			PlayerData *p = ent->data;
+			p->grav_pull = accel;
+		}
+	}
+}
+
+// Group active entities of types that update by type (keeping active list order),
+// then split each type's run into batches: serial types first, then every other type
+void EntBuildUpdateBatches(EntHandler *handler) {
+	uint32_t counts[ENT_TYPE_COUNT] = {0};
+
+	// Counting sort by type, types without an update function are left out
+	for(uint32_t i = 0; i < handler->count; i++) {
+		uint32_t id = handler->active[i];
+		counts[EntHotOf(handler, id)->type[id & ENT_CHUNK_MASK]]++;
+	}
+
+	uint32_t type_start[ENT_TYPE_COUNT], pos = 0;
+	for(int pass = 0; pass < 2; pass++) {
+		for(uint8_t t = 0; t < ENT_TYPE_COUNT; t++) {
+			if(type_update_serial[t] != (pass == 0)) continue;
+			if(!ent_update_funcs[t]) counts[t] = 0;
+
+			type_start[t] = pos;
+			pos += counts[t];
+		}
+	}
+
+	uint32_t fill[ENT_TYPE_COUNT];
+	memcpy(fill, type_start, sizeof(fill));
+	for(uint32_t i = 0; i < handler->count; i++) {
+		uint32_t id = handler->active[i];
+		uint8_t type = EntHotOf(handler, id)->type[id & ENT_CHUNK_MASK];
+		if(counts[type]) handler->update_list[fill[type]++] = EntAt(handler, id);
+	}
+
+	// Split runs into batches of a single type, serial batches first
+	handler->batch_count = 0;
+	for(int pass = 0; pass < 2; pass++) {
+		for(uint8_t t = 0; t < ENT_TYPE_COUNT; t++) {
+			if(type_update_serial[t] != (pass == 0)) continue;
+
+			for(uint32_t begin = type_start[t]; begin < fill[t]; begin += ENT_UPDATE_CHUNK) {
+				uint32_t end = (begin + ENT_UPDATE_CHUNK < fill[t]) ? begin + ENT_UPDATE_CHUNK : fill[t];
+				handler->batches[handler->batch_count++] = (EntUpdateBatch){ begin, end, t };
+			}
+		}
+
+		if(pass == 0) handler->serial_batch_count = handler->batch_count;
+	}
+}
+
+// Call type's batch function on every entity in batch, commands are recorded to batch's buffer
+void EntRunUpdateBatch(EntHandler *handler, uint32_t batch_id) {
+	EntUpdateBatch *batch = &handler->batches[batch_id];
+	EntCmdBuffer *buf = &handler->cmd_buffers[batch_id];
+	buf->count = 0;
+
+	handler->worker_cmds[JobWorkerIndex(handler->jobs)] = buf;
+
+	PROF_BEGIN("EntUpdateBatch");
+	ent_update_funcs[batch->type](&handler->update_list[batch->begin], batch->end - batch->begin, handler->update_dt);
+	PROF_END();
+}
+
+// Job function, runs a range of batches after the serial ones
+void EntUpdateJob(void *ctx, uint32_t begin, uint32_t end) {
+	EntHandler *handler = ctx;
+	for(uint32_t b = begin; b < end; b++) EntRunUpdateBatch(handler, b + handler->serial_batch_count);
+}
+
+// Update every orbiting entity in one batch:
+// gather orbit state into batch arrays, solve, write results back
+void EntOrbitUpdateAll(EntHandler *handler, float dt) {
+	OrbitBatch *batch = &handler->orbit_batch;
+	batch->count = 0;
+
+	// Every entity with orbit data could be orbiting, orbiters hold still for a tick if there's no room
+	if(!OrbitBatchReserve(batch, handler->orbit_pool.top)) return;
+
+	for(uint32_t i = 0; i < handler->count; i++) {
+		uint32_t id = handler->active[i];
+		EntHot *hot = EntHotOf(handler, id);
+		uint32_t h = id & ENT_CHUNK_MASK;
+		if(!(hot->flags[h] & ENT_ORBIT)) continue;
+
+		OrbitData *orbit = EntAt(handler, id)->orbit;
+		if(!orbit) continue;
+
+		// Drop orbit if orbited body was destroyed
+		Entity *anchor = EntGet(handler, orbit->anchor);
+		if(!anchor) {
+			orbit->anchor = ENT_HANDLE_NONE;
+			hot->flags[h] &= ~ENT_ORBIT;
+			continue;
+		}
+
+		Vector2 body_center = EntCenter(anchor);
+		uint32_t n = batch->count++;
+
+		batch->ids[n] = id;
+		batch->angle[n] = orbit->angle;
+		batch->height[n] = orbit->height;
+		batch->angular_vel[n] = orbit->angular_vel;
+		batch->body_x[n] = body_center.x;
+		batch->body_y[n] = body_center.y;
+		batch->body_radius[n] = ENT_RADIUS(anchor);
+		batch->ent_radius[n] = hot->radius[h];
+	}
+
+	OrbitBatchSolve(batch, dt);
+
+	for(uint32_t n = 0; n < batch->count; n++) {
+		uint32_t id = batch->ids[n];
+		Entity *ent = EntAt(handler, id);
+		OrbitData *orbit = ent->orbit;
+
+		Vector2 dir = { batch->dir_x[n], batch->dir_y[n] };
+		Vector2 center = { batch->center_x[n], batch->center_y[n] };
+
+		ENT_POS(ent) = Vector2Add(center, Vector2Scale(ENT_OFFSET(ent), -1));
+		ent->sprite_angle = AngleLerp(ent->sprite_angle, batch->target_angle[n], 0.1f * dt);
+		if(batch->grounded[n]) ENT_FLAGS(ent) |= ENT_GROUNDED;
+
+		if(ENT_TYPEOF(ent) == ENT_PLAYER) {
+			PlayerData *p = ent->data;
+			p->orbit_dir = dir;
+		}
+
+		orbit->angle = batch->angle[n];
+		orbit->height = batch->height[n];
+		orbit->orbit_center = (Vector2){ batch->body_x[n], batch->body_y[n] };
+		orbit->dir = dir;
+		orbit->edge = (Vector2){ batch->edge_x[n], batch->edge_y[n] };
+		orbit->curr_pos = EntCenter(ent);
+	}
+}
+
+// Copy current positions and sprite angles to previous state
+void EntHandlerStorePrev(EntHandler *handler) {
+	// Only slots handed out so far can hold entities, copy each chunk's used part
+	for(uint32_t first = 0; first < handler->ent_pool.top; first += ENT_CHUNK_SIZE) {
+		uint32_t used = handler->ent_pool.top - first;
+		if(used > ENT_CHUNK_SIZE) used = ENT_CHUNK_SIZE;
+
+		EntHot *hot = EntHotOf(handler, first);
+		memcpy(hot->prev_position, hot->position, sizeof(Vector2) * used);
+	}
+
+	for(uint32_t i = 0; i < handler->count; i++) {
+		Entity *ent = EntAt(handler, handler->active[i]);
+		ent->prev_sprite_angle = ent->sprite_angle;
+	}
+}
+
+// Draw all entities,
+// alpha is how far between previous and current tick state to draw them (0 to 1)
+void EntHandlerDraw(EntHandler *handler, float alpha, uint8_t flags) {
 	if(flags & SHOW_DEBUG)
 		DrawLine(ray_start.x, ray_start.y, ray_end.x, ray_end.y, WHITE);
 
-	for(uint16_t i = 1; i < handler->count; i++) {
-		// Get entity pointer
-		Entity *ent = &handler->ents[i];
-			
-		// Skip draw call if entitiy inactive
-		if(!(ent->flags & ENT_ACTIVE)) continue;
-		
-		// Call entity's draw function
-		if(ent->draw) ent->draw(ent, handler->sprite_loader);
+	// Visible world area, only grid cells around it are visited
+	Rectangle view = CameraViewRect(handler->camera, handler->view_size);
+	view = (Rectangle){ 
+		view.x - ENT_CULL_MARGIN, view.y - ENT_CULL_MARGIN,
+		view.width + ENT_CULL_MARGIN * 2, view.height + ENT_CULL_MARGIN * 2 
+	};
+
+	// Grid holds entity centers, pad query so entities overlapping the view edge are found
+	float pad = handler->max_radius;
+	Rectangle query = { view.x - pad, view.y - pad, view.width + pad * 2, view.height + pad * 2 };
+	int32_t count = GridQueryRect(&handler->grid, query, handler->query_ids, handler->capacity);
+
+	uint32_t counts[ENT_TYPE_COUNT] = {0};
+	uint32_t visible = 0;
+
+	for(int32_t i = 0; i < count; i++) {
+		Entity *ent = EntAt(handler, handler->query_ids[i]);
+
+		// Skip entities whose bounding circle is outside view
+		if(!CheckCollisionCircleRec(EntCenter(ent), ENT_RADIUS(ent), view)) continue;
+
+		// Interpolate render state
+		ent->draw_pos = Vector2Lerp(ENT_PREV_POS(ent), ENT_POS(ent), alpha);
+		ent->draw_angle = AngleInterp(ent->prev_sprite_angle, ent->sprite_angle, alpha);
+
+		handler->query_ids[visible++] = ent->id;
+		counts[ENT_TYPEOF(ent)]++;
+	}
+
+	handler->drawn_count = visible;
+
+	// Group visible entities by type
+	uint32_t fill[ENT_TYPE_COUNT], pos = 0;
+	for(uint8_t t = 0; t < ENT_TYPE_COUNT; t++) {
+		fill[t] = pos;
+		pos += counts[t];
+	}
+
+	for(uint32_t i = 0; i < visible; i++) {
+		Entity *ent = EntAt(handler, handler->query_ids[i]);
+		handler->draw_list[fill[ENT_TYPEOF(ent)]++] = ent;
 	}
 
-	Entity *player_ent = &handler->ents[0];	
+	// Entities queue their sprites by type, layers keep the player on top of everything else
+	RenderQueue *rq = handler->render_queue;
+	for(uint8_t t = 0; t < ENT_TYPE_COUNT; t++) {
+		if(!counts[t] || !ent_draw_funcs[t]) continue;
+		ent_draw_funcs[t](&handler->draw_list[fill[t] - counts[t]], counts[t], rq, handler->sprite_loader);
+	}
+
+	handler->culled_count = handler->count - handler->drawn_count;
+
+	// Sort and submit sprites grouped by texture
+	PROF_BEGIN("RenderQueueFlush");
+	RenderQueueFlush(rq);
+	PROF_END();
+
+	Entity *player_ent = EntPlayer(handler);
+	if(!player_ent) return;
+
 	PlayerData *p = player_ent->data;
 
-	player_ent->draw(player_ent, handler->sprite_loader);
-	if(p->raycast_id > -1) {
-		Entity *cast_hit_body = &handler->ents[p->raycast_id];
-		DrawCircleLinesV(EntCenter(cast_hit_body), cast_hit_body->radius * 3, BLUE);
+	if(ENT_FLAGS(player_ent) & ENT_ORBIT) OrbitDataDrawDebug(player_ent->orbit);
+
+	Entity *cast_hit_body = EntGet(handler, p->raycast_hit);
+	if(cast_hit_body) {
+		DrawCircleLinesV(EntCenter(cast_hit_body), ENT_RADIUS(cast_hit_body) * 3, BLUE);
+		DrawCircleV(p->raycast_point, 5, BLUE);
 		
-		DrawText(TextFormat("%d", p->raycast_id), player_ent->position.x, player_ent->position.y, 16, BLUE);	
+		DrawText(TextFormat("%d", cast_hit_body->id), player_ent->draw_pos.x, player_ent->draw_pos.y, 16, BLUE);	
 	}
 }
 
+// Take a slot from pool, prefer recycled slots
+int32_t SlotAlloc(SlotPool *pool) {
+	if(pool->free_count > 0) return pool->free_slots[--pool->free_count];
+	if(pool->top >= pool->cap) return -1;
+
+	return pool->top++;
+}
+
+// Return a slot to pool
+void SlotFree(SlotPool *pool, uint32_t slot) {
+	// Free stack never holds more than top slots, grow it as needed
+	if(pool->free_count >= pool->free_cap) {
+		uint32_t cap = (pool->free_cap) ? pool->free_cap * 2 : 64;
+		uint32_t *slots = realloc(pool->free_slots, sizeof(uint32_t) * cap);
+
+		// Slot is leaked if stack can't grow, pool keeps working
+		if(!slots) return;
+
+		pool->free_slots = slots;
+		pool->free_cap = cap;
+	}
+
+	pool->free_slots[pool->free_count++] = slot;
+}
+
+void SlotPoolClose(SlotPool *pool) {
+	free(pool->free_slots);
+	pool->free_slots = NULL;
+	pool->free_cap = 0;
+	pool->free_count = 0;
+	pool->top = 0;
+}
+
 // Create a new entity and add to pool (corresponding to entity type)
-int16_t EntMake(EntHandler *handler, uint8_t type) {
+EntHandle EntMake(EntHandler *handler, uint8_t type) {
 	// Get count for entity type
-	uint16_t *type_count = &handler->type_counts[type];
+	uint32_t *type_count = &handler->type_counts[type];
 	
 	// Dont't add entity data if slots are full
-	if(*type_count >= type_max[type]) return -1;
+	if(*type_count >= type_max[type]) return ENT_HANDLE_NONE;
+
+	// Make sure type data has room before taking any slots, a freed data slot is reused before top grows
+	SlotPool *data_pool = &handler->data_pools[type];
+	if(!ArenaReserve(&handler->type_data[type], data_pool->free_count ? data_pool->top : data_pool->top + 1)) return ENT_HANDLE_NONE;
 	
-	// Get entity pointer
-	Entity *ent = &handler->ents[handler->count]; 
-	ent->type = type;
+	int32_t slot = SlotAlloc(&handler->ent_pool);
+	if(slot == -1) return ENT_HANDLE_NONE;
 
-	// Initialize entity
-	*ent = (Entity){0};
-	ent->flags |= ENT_ACTIVE;
+	// New slot past allocated chunks, grow storage
+	if((uint32_t)slot >= handler->capacity && !EntHandlerReserve(handler, slot + 1)) {
+		SlotFree(&handler->ent_pool, slot);
+		return ENT_HANDLE_NONE;
+	}
+
+	// Get entity pointer, initialize cold fields
+	uint32_t id = slot;
+	EntChunk *chunk = EntChunkOf(handler, id);
+	Entity *ent = &chunk->ents[id & ENT_CHUNK_MASK]; 
+	*ent = (Entity){ .hot = &chunk->hot, .id = id };
+
+	// Initialize hot fields
+	ENT_FLAGS(ent) = ENT_ACTIVE;
+	ENT_TYPEOF(ent) = type;
+	ENT_RADIUS(ent) = 0;
+	ENT_POS(ent) = Vector2Zero();
+	ENT_VEL(ent) = Vector2Zero();
+	ENT_OFFSET(ent) = Vector2Zero();
+
+	ENT_PREV_POS(ent) = Vector2Zero();
+
+	// Add to grid, spawn functions move it once position is set
+	GridInsert(&handler->grid, id, Vector2Zero());
+
+	// First use of slot, generation 0 is never valid so ENT_HANDLE_NONE can't resolve
+	uint16_t *generation = &chunk->generation[id & ENT_CHUNK_MASK];
+	if(*generation == 0) *generation = 1;
 
-	// Set function pointers
-	ent->update = ent_update_funcs[type];
-	ent->draw = ent_draw_funcs[type];
-	
 	// Reserve data
-	data_reserve_funcs[type](handler, &handler->ents[handler->count]);
+	data_reserve_funcs[type](handler, ent);
 	
 	// Increment count for entity type
 	(*type_count)++;
 
-	// Return entity's index 
-	return handler->count++;
+	// Add to active list
+	chunk->active_pos[id & ENT_CHUNK_MASK] = handler->count;
+	handler->active[handler->count++] = id;
+
+	// Return entity's handle
+	EntHandle handle = EntGetHandle(handler, id);
+	if(type == ENT_PLAYER) handler->player = handle;
+
+	return handle;
+}
+
+// Destroy an entity, all of it's slots are released in constant time
+bool EntDestroy(EntHandler *handler, EntHandle handle) {
+	Entity *ent = EntGet(handler, handle);
+	if(!ent) return false;
+
+	// Entities might be mid-iteration, record to running batch's command buffer
+	if(handler->updating) {
+		EntCmdBuffer *buf = handler->worker_cmds[JobWorkerIndex(handler->jobs)];
+		if(!buf || buf->count >= ENT_CMD_BUFFER_CAP) return false;
+
+		buf->cmds[buf->count++] = (EntCmd){ ENT_CMD_DESTROY, handle };
+		return true;
+	}
+
+	EntChunk *chunk = EntChunkOf(handler, ent->id);
+	uint32_t id = ent->id;
+	uint8_t type = ENT_TYPEOF(ent);
+
+	GridRemove(&handler->grid, id);
+
+	// Release type data and orbit data
+	SlotFree(&handler->data_pools[type], ent->data_id);
+	if(ent->orbit) SlotFree(&handler->orbit_pool, ent->orbit_id);
+
+	handler->type_counts[type]--;
+	ENT_FLAGS(ent) = 0;
+
+	// Swap last active entity into removed entity's place
+	uint32_t pos = chunk->active_pos[id & ENT_CHUNK_MASK];
+	uint32_t last = handler->active[--handler->count];
+	handler->active[pos] = last;
+	EntChunkOf(handler, last)->active_pos[last & ENT_CHUNK_MASK] = pos;
+
+	// Invalidate existing handles to slot, skip 0 on wrap around
+	uint16_t *generation = &chunk->generation[id & ENT_CHUNK_MASK];
+	*generation = (*generation + 1) & ENT_GEN_MASK;
+	if(*generation == 0) *generation = 1;
+
+	SlotFree(&handler->ent_pool, id);
+	*ent = (Entity){0};
+
+	return true;
+}
+
+// Resolve handle to entity pointer, checks generation to catch stale handles
+Entity *EntGet(EntHandler *handler, EntHandle handle) {
+	uint32_t id = EntHandleIndex(handle);
+	if(handle == ENT_HANDLE_NONE || id >= handler->capacity) return NULL;
+
+	EntChunk *chunk = EntChunkOf(handler, id);
+	uint32_t h = id & ENT_CHUNK_MASK;
+	if(chunk->generation[h] != EntHandleGen(handle)) return NULL;
+	if(!(chunk->hot.flags[h] & ENT_ACTIVE)) return NULL;
+
+	return &chunk->ents[h];
+}
+
+EntHandle EntGetHandle(EntHandler *handler, uint32_t id) {
+	return ((EntHandle)EntChunkOf(handler, id)->generation[id & ENT_CHUNK_MASK] << ENT_INDEX_BITS) | id;
+}
+
+uint32_t EntHandleKey(EntHandler *handler, EntHandle handle) {
+	return EntHandleIndex(handle) | ((EntGet(handler, handle)) ? 0x80000000u : 0);
+}
+
+Entity *EntPlayer(EntHandler *handler) {
+	Entity *ent = EntGet(handler, handler->player);
+	if(!ent || ENT_TYPEOF(ent) != ENT_PLAYER) return NULL;
+
+	return ent;
 }
 
 // Reserve data for entity of type "player"
 void ReserveDataPlayer(EntHandler *handler, Entity *ent) {
 	// Get data index
-	uint16_t data_id = handler->type_counts[ENT_PLAYER];
+	uint32_t data_id = SlotAlloc(&handler->data_pools[ENT_PLAYER]);
 
-	// Init data
-	PlayerData player_data = (PlayerData){0};
-	handler->player_data[data_id] = player_data;
+	// Init data, arena was grown by EntMake
+	PlayerData *player_data = ArenaAt(&handler->type_data[ENT_PLAYER], data_id);
+	*player_data = (PlayerData){0};
 
-	// Set entity data pointer
-	ent->data = &handler->player_data[data_id];
+	// Set entity data pointers
+	ent->data_id = data_id;
+	ent->data = player_data;
+	ReserveDataOrbit(handler, ent);
 	PlayerInit(ent, handler->sprite_loader, handler->camera);
+	player_data->input = handler->input;
+	player_data->particles = handler->particles;
+	player_data->projectiles = handler->projectiles;
 }
 
 // Reserve data for entity of type "asteroid"
 void ReserveDataAsteroid(EntHandler *handler, Entity *ent) {
 	// Get data index
-	uint16_t data_id = handler->type_counts[ENT_ASTEROID];
+	uint32_t data_id = SlotAlloc(&handler->data_pools[ENT_ASTEROID]);
 
-	// Init data
-	AsteroidData data = (AsteroidData){0};
-	handler->asteroid_data[data_id] = data;
+	// Init data, arena was grown by EntMake
+	AsteroidData *data = ArenaAt(&handler->type_data[ENT_ASTEROID], data_id);
+	*data = (AsteroidData){0};
 
 	// Set entity data pointers
-	ent->data = &handler->asteroid_data[data_id];
+	ent->data_id = data_id;
+	ent->data = data;
 }
 
 // Reserve data for entity of type "fish"
 void ReserveDataFish(EntHandler *handler, Entity *ent) {
 	// Get data index
-	uint16_t data_id = handler->type_counts[ENT_FISH];
+	uint32_t data_id = SlotAlloc(&handler->data_pools[ENT_FISH]);
 
-	// Init data
-	FishData data = (FishData){0};
-	handler->fish_data[data_id] = data;
+	// Init data, arena was grown by EntMake
+	FishData *data = ArenaAt(&handler->type_data[ENT_FISH], data_id);
+	*data = (FishData){0};
 
-	// Set entity data pointer
-	ent->data = &handler->fish_data[data_id];
+	// Set entity data pointers
+	ent->data_id = data_id;
+	ent->data = data;
+	ReserveDataOrbit(handler, ent);
 }
 
 // Reserve data for entity of type "npc"
 void ReserveDataNpc(EntHandler *handler, Entity *ent) {
 	// Get data index
-	uint16_t data_id = handler->type_counts[ENT_NPC];
+	uint32_t data_id = SlotAlloc(&handler->data_pools[ENT_NPC]);
+
+	// Init data, arena was grown by EntMake
+	NpcData *data = ArenaAt(&handler->type_data[ENT_NPC], data_id);
+	*data = (NpcData){0};
+
+	// Set entity data pointers
+	ent->data_id = data_id;
+	ent->data = data;
+	ReserveDataOrbit(handler, ent);
+}
+
+// Reserve orbit data side table entry, for entity types that can orbit bodies
+void ReserveDataOrbit(EntHandler *handler, Entity *ent) {
+	int32_t orbit_id = SlotAlloc(&handler->orbit_pool);
+	if(orbit_id == -1) return;
+
+	// Entity can't orbit if arena can't grow
+	if(!ArenaReserve(&handler->orbit_data, orbit_id + 1)) {
+		SlotFree(&handler->orbit_pool, orbit_id);
+		return;
+	}
 
 	// Init data
-	NpcData data = (NpcData){0};
-	handler->npc_data[data_id] = data;
+	OrbitData *orbit = ArenaAt(&handler->orbit_data, orbit_id);
+	*orbit = (OrbitData){0};
 
-	// Set entity data pointer
-	ent->data = &handler->fish_data[data_id];
+	// Set entity orbit pointer
+	ent->orbit_id = orbit_id;
+	ent->orbit = orbit;
 }
 
 // Spawn an asteroid entity at provided position
-void AsteroidSpawn(EntHandler *handler, Vector2 position) {
-	int16_t id = EntMake(handler, ENT_ASTEROID);
-	if(id == -1) return;
+EntHandle AsteroidSpawn(EntHandler *handler, Vector2 position) {
+	EntHandle handle = EntMake(handler, ENT_ASTEROID);
+	Entity *ast = EntGet(handler, handle);
+	if(!ast) return ENT_HANDLE_NONE;
+
+	EntSetPosition(ast, position);
+	ENT_RADIUS(ast) = AsteroidSpawnRadius(handler);
+	ENT_OFFSET(ast) = (Vector2){ENT_RADIUS(ast), ENT_RADIUS(ast)};
+	ENT_FLAGS(ast) |= ENT_IS_BODY;
+
+	// Place in grid
+	GridMove(&handler->grid, ast->id, EntCenter(ast));
+	if(ENT_RADIUS(ast) > handler->max_radius) handler->max_radius = ENT_RADIUS(ast);
+	if(ENT_RADIUS(ast) > handler->max_body_radius) handler->max_body_radius = ENT_RADIUS(ast);
+
+	return handle;
+}
+
+uint32_t AsteroidSpawnBatch(EntHandler *handler, const Vector2 *positions, uint32_t count) {
+	// Entity chunks and asteroid data grow once instead of as each spawn crosses a chunk
+	EntHandlerReserve(handler, handler->ent_pool.top + count);
+	ArenaReserve(&handler->type_data[ENT_ASTEROID], handler->data_pools[ENT_ASTEROID].top + count);
+
+	uint32_t spawned = 0;
+	for(uint32_t i = 0; i < count; i++) {
+		if(AsteroidSpawn(handler, positions[i]) == ENT_HANDLE_NONE) break;
+		spawned++;
+	}
+
+	return spawned;
+}
 
-	Entity *ast = &handler->ents[id];
-	ast->position = position;
-	ast->radius = handler->sprite_loader->spr_pool[1].frame_w * 0.5f;
-	ast->center_offset = (Vector2){ast->radius, ast->radius};
-	ast->flags |= ENT_IS_BODY;
+float AsteroidSpawnRadius(EntHandler *handler) {
+	return handler->sprite_loader->spr_pool[1].frame_w * 0.5f;
 }
 
 void FindPlayerOrbit(EntHandler *handler, float dt) {
-	Entity *player_ent = &handler->ents[0];
+	Entity *player_ent = EntPlayer(handler);
+	if(!player_ent) return;
+
 	PlayerData *p = player_ent->data;
 
 	Entity *orbit_body = NULL;
 
-	int16_t nearest_body_id = -1;
-	int16_t raycast_body_id = -1;
+	int32_t nearest_body_id = -1;
+	EntHandle raycast_hit = ENT_HANDLE_NONE;
 
-	float shortest_dist = FLT_MAX, shortest_cast_dist = FLT_MAX;
+	float shortest_dist = FLT_MAX;
 
-	ray_start = EntCenter(player_ent);
-	ray_end = Vector2Add(EntCenter(player_ent), Vector2Scale(p->orbit_dir, 2000)); 
- 
-	for(uint16_t i = 0; i < handler->count; i++) {
-		Entity *body = &handler->ents[i];
-		if(!(body->flags & ENT_IS_BODY)) continue;
-	
-		float dist = Vector2Distance(EntCenter(player_ent), EntCenter(body));		
+	Vector2 player_center = EntCenter(player_ent);
+	ray_start = player_center;
+	ray_end = Vector2Add(player_center, Vector2Scale(p->orbit_dir, ORBIT_CAST_LENGTH)); 
+
+	// Only bodies close enough for their capture radius to reach the player can be orbited,
+	// so search the grid cells within that distance instead of every entity
+	float capture_reach = ENT_RADIUS(player_ent) + handler->max_body_radius * 3;
+	int32_t count = GridQueryCircle(&handler->grid, player_center, capture_reach, handler->query_ids, handler->capacity);
+
+	for(int32_t i = 0; i < count; i++) {
+		int32_t id = handler->query_ids[i];
+		EntHot *hot = EntHotOf(handler, id);
+		uint32_t h = id & ENT_CHUNK_MASK;
+		if(!(hot->flags[h] & ENT_IS_BODY)) continue;
+
+		Vector2 body_center = Vector2Add(hot->position[h], hot->center_offset[h]);
+
+		float dist = Vector2Distance(player_center, body_center);		
 		if(dist < shortest_dist) {
-			nearest_body_id = i;	
+			nearest_body_id = id;	
 			shortest_dist = dist;
 		}
+	}
 
-		if(CheckCollisionCircleLine(EntCenter(body), body->radius * 3, ray_start, ray_end)) {
-			if(p->anchor_id != i) {
-				raycast_body_id = i;
-			}
-		}
+	// Orbit raycast, closest body along orbit direction
+	EntRayHit hit;
+	if(PlayerOrbitCast(handler, &hit)) {
+		raycast_hit = hit.body;
+		p->raycast_point = hit.point;
 	}
 
 	if(nearest_body_id > -1) {
-		orbit_body = &handler->ents[nearest_body_id];
+		orbit_body = EntAt(handler, nearest_body_id);
+		EntHandle nearest_body = EntGetHandle(handler, nearest_body_id);
 		
-		if(player_ent->flags & ENT_ORBIT)
-			p->prev_anchor_id = p->anchor_id;
+		if(ENT_FLAGS(player_ent) & ENT_ORBIT)
+			p->prev_anchor = p->anchor;
 
-		if(CheckCollisionCircles(EntCenter(player_ent), player_ent->radius, EntCenter(orbit_body), orbit_body->radius * 3)) {
-			if(((player_ent->flags & ENT_ORBIT) == 0) || p->anchor_id != nearest_body_id) {
+		if(CheckCollisionCircles(player_center, ENT_RADIUS(player_ent), EntCenter(orbit_body), ENT_RADIUS(orbit_body) * 3)) {
+			if(((ENT_FLAGS(player_ent) & ENT_ORBIT) == 0) || p->anchor != nearest_body) {
 				EntOrbitStart(player_ent, orbit_body);
-				p->anchor_id = nearest_body_id;
+				player_ent->orbit->anchor = nearest_body;
+				p->anchor = nearest_body;
 			}
 		}
 	}
 
-	p->raycast_id = raycast_body_id;
+	p->raycast_hit = raycast_hit;
 }
 
+// Raycast filter state
+typedef struct {
+	EntHandler *handler;
+	uint32_t exclude_id;
+	bool has_exclude;
+} BodyRayCtx;
+
+// Ray against body's capture radius, returns entry distance or -1 for a miss
+static float BodyRayTest(void *ctx, int32_t id, Vector2 origin, Vector2 dir) {
+	BodyRayCtx *ray = ctx;
+	EntHot *hot = EntHotOf(ray->handler, id);
+	uint32_t h = id & ENT_CHUNK_MASK;
+
+	if(!(hot->flags[h] & ENT_IS_BODY)) return -1;
+	if(ray->has_exclude && (uint32_t)id == ray->exclude_id) return -1;
+
+	Vector2 center = Vector2Add(hot->position[h], hot->center_offset[h]);
+	float r = hot->radius[h] * 3;
+
+	Vector2 m = Vector2Subtract(origin, center);
+	float b = Vector2DotProduct(m, dir);
+	float c = Vector2DotProduct(m, m) - r * r;
+
+	// Origin outside circle and pointing away
+	if(c > 0 && b > 0) return -1;
+
+	float disc = b * b - c;
+	if(disc < 0) return -1;
+
+	// Origin inside circle counts as a hit at distance 0
+	float t = -b - sqrtf(disc);
+	return (t < 0) ? 0 : t;
+}
+
+bool EntRaycastBodies(EntHandler *handler, Vector2 origin, Vector2 dir, float max_dist, EntHandle exclude, EntRayHit *hit) {
+	*hit = (EntRayHit){ .body = ENT_HANDLE_NONE, .distance = max_dist };
+
+	Entity *exclude_ent = EntGet(handler, exclude);
+	BodyRayCtx ctx = { handler, (exclude_ent) ? exclude_ent->id : 0, (exclude_ent != NULL) };
+
+	// Items are stored by center, pad by largest capture radius
+	GridRayHit grid_hit;
+	if(!GridRaycast(&handler->grid, origin, Vector2Normalize(dir), max_dist, handler->max_body_radius * 3, BodyRayTest, &ctx, &grid_hit))
+		return false;
+
+	hit->body = EntGetHandle(handler, grid_hit.id);
+	hit->distance = grid_hit.distance;
+	hit->point = grid_hit.point;
+	return true;
+}
+
+bool PlayerOrbitCast(EntHandler *handler, EntRayHit *hit) {
+	Entity *player_ent = EntPlayer(handler);
+	if(!player_ent) return false;
+
+	PlayerData *p = player_ent->data;
+
+	return EntRaycastBodies(handler, EntCenter(player_ent), p->orbit_dir, ORBIT_CAST_LENGTH, p->anchor, hit);
+}
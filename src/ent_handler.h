@@ -1,50 +1,251 @@
 #include <stdlib.h>
 #include "entity.h"
+#include "spatial.h"
+#include "orbit.h"
+#include "gravity.h"
+#include "jobs.h"
+#include "arena.h"
 
 #ifndef ENT_HANDLER_H
 #define ENT_HANDLER_H
 
-#define ENT_ARENA_CAP	1024	
-#define ENT_PLAYER_ID	0
-
+// Most live entities of each type, types without a fixed limit are only bound by ENT_MAX_ENTITIES
 #define MAX_PLAYERS 	1
-#define MAX_ASTEROIDS 	((ENT_ARENA_CAP/2)-9) 
-#define MAX_FISH		(ENT_ARENA_CAP/2)
+#define MAX_ASTEROIDS 	ENT_MAX_ENTITIES
+#define MAX_FISH		ENT_MAX_ENTITIES
 #define MAX_NPCS		8
 
+// Orbit data is only reserved for entity types that can orbit
+#define MAX_ORBITERS	ENT_MAX_ENTITIES
+
+// Elements per chunk of type data and orbit data arenas
+#define ENT_DATA_CHUNK_BITS		8
+
 #define SHOW_DEBUG	0x01
 
+// Entity grid cell size, should be larger than the biggest capture radius (radius * 3)
+#define ENT_GRID_CELL_SIZE	256.0f
+
+// Extra world space around camera view kept when culling,
+// covers sprites drawn up to a tick behind their current position
+#define ENT_CULL_MARGIN		64.0f
+
+// Length of player's orbit raycast
+#define ORBIT_CAST_LENGTH		2000.0f
+
+// Most entities updated by a single job
+#define ENT_UPDATE_CHUNK		64
+
+// Update batches needed for n entities: chunks of each type, plus a partial chunk per type
+#define ENT_UPDATE_MAX_BATCHES(n)	((n) / ENT_UPDATE_CHUNK + ENT_TYPE_COUNT)
+
+// Most commands an update batch can record
+#define ENT_CMD_BUFFER_CAP		64
+
+// Deferred entity commands, recorded while entities are updating
+enum ENT_CMD_TYPES {
+	ENT_CMD_DESTROY
+};
+
+typedef struct {
+	uint8_t type;
+	EntHandle handle;
+} EntCmd;
+
 typedef struct {
 	uint16_t count;
-	Entity ents[ENT_ARENA_CAP];	
+	EntCmd cmds[ENT_CMD_BUFFER_CAP];
+} EntCmdBuffer;
+
+// Closest body hit by a raycast
+typedef struct {
+	EntHandle body;			// ENT_HANDLE_NONE for no hit
+	float distance;			// Distance along ray to hit
+	Vector2 point;			// Hit point on body's capture radius
+} EntRayHit;
+
+// Range of update list updated together, all of one type
+typedef struct {
+	uint32_t begin, end;
+	uint8_t type;
+} EntUpdateBatch;
+
+// Index allocator, recycles freed slots
+typedef struct {
+	uint32_t cap;				// Most slots pool can hand out
+	uint32_t top;				// Slots handed out at least once
+	uint32_t free_count;
+	uint32_t free_cap;
+	uint32_t *free_slots;		// Stack of released slots, grows as slots are released
+} SlotPool;
+
+// Take a slot from pool, returns slot index, -1 if pool is full
+int32_t SlotAlloc(SlotPool *pool);
+void SlotFree(SlotPool *pool, uint32_t slot);
+void SlotPoolClose(SlotPool *pool);
+
+// Storage for ENT_CHUNK_SIZE entities, allocated as a whole and never moved
+typedef struct {
+	EntHot hot;								// Hot entity fields (structure of arrays)
+	Entity ents[ENT_CHUNK_SIZE];			// Cold entity fields, indexed same as hot arrays
+	uint16_t generation[ENT_CHUNK_SIZE];	// Slot generations, used to validate handles
+	uint32_t active_pos[ENT_CHUNK_SIZE];	// Position of each entity in active list
+} EntChunk;
+
+// Time spent in each entity update phase, accumulated in nanoseconds
+typedef struct {
+	uint64_t orbit_ns;			// Anchored orbit update
+	uint64_t gravity_ns;		// Body gravity on free floating entities
+	uint64_t update_ns;			// Entity update functions, grid sync and deferred destroys
+	uint64_t find_orbit_ns;		// FindPlayerOrbit
+} EntTimings;
+
+// Entities live in chunks that are allocated as the entity count grows, so pointers to entities and their data stay valid.
+// Per entity index lists (active, update list, query results) are sized to the allocated chunks and grow with them
+typedef struct {
+	uint32_t count;							// Number of live entities
+	uint32_t capacity;						// Entities storable without allocating
+	uint32_t *active;						// Packed indices of live entities, first count are valid
+
+	ChunkArena chunks;						// Entity storage, one EntChunk per arena element
+	SlotPool ent_pool;
 	
-	uint16_t type_counts[ENT_TYPE_COUNT];
+	EntHandle player;						// Handle of last player made, stale once it's destroyed
+	uint32_t type_counts[ENT_TYPE_COUNT];	// Number of live entities of each type
+	SlotPool data_pools[ENT_TYPE_COUNT];	// Slot pools for entity type data arenas
+	ChunkArena type_data[ENT_TYPE_COUNT];	// Type specific data (PlayerData, FishData, etc...)
 
-	PlayerData player_data[MAX_PLAYERS];
-	AsteroidData asteroid_data[MAX_ASTEROIDS];
-	FishData fish_data[MAX_FISH];
-	NpcData npc_data[MAX_NPCS];
+	SlotPool orbit_pool;
+	ChunkArena orbit_data;
+	OrbitBatch orbit_batch;					// Orbiting entities gathered for batched update
+
+	GravityTree gravity;					// Bodies, rebuilt each tick something is free floating
+	GravityBatch gravity_batch;				// Free floating entities pulled by bodies
+
+	// Entities update in batches that may run in parallel, while updating an entity only writes it's own state,
+	// other writes are recorded as commands and applied in batch order once all batches are done
+	bool updating;
+	float update_dt;
+	uint32_t batch_count;
+	uint32_t serial_batch_count;					// Leading batches of types updated on main thread
+	Entity **update_list;							// Active entities grouped by type, only types that update
+	EntUpdateBatch *batches;						// ENT_UPDATE_MAX_BATCHES(capacity) batches
+	EntCmdBuffer *cmd_buffers;						// Command buffer of each batch
+	EntCmdBuffer *worker_cmds[JOB_MAX_THREADS];		// Command buffer of batch each worker is running
+	JobSystem *jobs;								// Runs update batches, serial if NULL
+
+	SpatialGrid grid;					// Spatial hash of all live entities, by center
+	float max_radius;					// Largest radius of any entity in grid
+	float max_body_radius;				// Largest radius of any entity flagged ENT_IS_BODY
+	int32_t *query_ids;					// Scratch buffer for grid query results
+	Entity **draw_list;					// Visible entities grouped by type
+
+	EntTimings *timings;					// Phase timings, only recorded if set
+
+	Vector2 view_size;						// Size of camera view in pixels, used for culling
+	uint32_t drawn_count, culled_count;		// Entities drawn and culled last frame
 
 	SpriteLoader *sprite_loader;
+	RenderQueue *render_queue;
 	Camera2D *camera;
+	InputState *input;						// Input given to player entities
+	struct ParticleSystem *particles;		// Effects given to player entities
+	struct ProjectileSystem *projectiles;	// Given to player entities, part of hashes and snapshots if set
+	struct World *world;					// Streamed chunks holding entities, part of snapshots if set
 } EntHandler;
 
-void EntHandlerInit(EntHandler *handler, SpriteLoader *sl, Camera2D *camera);
+void EntHandlerInit(EntHandler *handler, SpriteLoader *sl, RenderQueue *rq, Camera2D *camera);
+void EntHandlerClose(EntHandler *handler);
+
+// Allocate storage for at least count entities up front (capacity hint from config or level),
+// handler still grows past it on demand. Returns false if out of memory or count is over ENT_MAX_ENTITIES
+bool EntHandlerReserve(EntHandler *handler, uint32_t count);
+
+// Bytes of entity, type data and orbit data chunks allocated
+size_t EntHandlerBytes(EntHandler *handler);
+
+// Hash of live entity state (ids, flags, types, positions, velocities, orbits) and projectiles, for spotting replay divergence.
+// Equal state hashes equal, bit for bit, handles are hashed by what they resolve to
+uint32_t EntHandlerHash(EntHandler *handler);
+
+// Storage chunk holding entity id, id must be below handler's capacity.
+// Chunk arena holds one EntChunk per arena chunk, so the chunk table is indexed directly
+static inline EntChunk *EntChunkOf(EntHandler *handler, uint32_t id) {
+	return handler->chunks.chunks[id >> ENT_CHUNK_BITS];
+}
+
+// Hot arrays holding entity id, index them with (id & ENT_CHUNK_MASK)
+static inline EntHot *EntHotOf(EntHandler *handler, uint32_t id) {
+	return &EntChunkOf(handler, id)->hot;
+}
+
+// Entity in slot id, live or not
+static inline Entity *EntAt(EntHandler *handler, uint32_t id) {
+	return &EntChunkOf(handler, id)->ents[id & ENT_CHUNK_MASK];
+}
+
 void EntHandlerUpdate(EntHandler *handler, float dt);
-void EntHandlerDraw(EntHandler *handler, uint8_t flags);
+void EntHandlerDraw(EntHandler *handler, float alpha, uint8_t flags);
+void EntHandlerStorePrev(EntHandler *handler);
+void EntOrbitUpdateAll(EntHandler *handler, float dt);
+
+// Move every live entity to the grid cell of it's center, grows max_radius to fit
+void EntGridSync(EntHandler *handler);
 
-// Create an entity instance, returns entity's index, -1 if instance fails
-int16_t EntMake(EntHandler *handler, uint8_t type);
+// Pull free floating entities (not bodies, not orbiting) toward every body, adds to velocity.
+// Types with an update function move themselves, others are moved here
+void EntGravityUpdate(EntHandler *handler, float dt);
+
+// Update batch function of each type, NULL for types that don't update.
+// No type updates in parallel batches yet, benchmarks register their own function to exercise them
+extern EntUpdateBatchFunc ent_update_funcs[ENT_TYPE_COUNT];
+
+void EntBuildUpdateBatches(EntHandler *handler);
+void EntRunUpdateBatch(EntHandler *handler, uint32_t batch_id);
+void EntUpdateJob(void *ctx, uint32_t begin, uint32_t end);
+
+// Create an entity instance, returns entity's handle, ENT_HANDLE_NONE if instance fails
+EntHandle EntMake(EntHandler *handler, uint8_t type);
+
+// Destroy an entity, releasing it's slot and data for reuse,
+// returns false if handle is stale or invalid
+bool EntDestroy(EntHandler *handler, EntHandle handle);
+
+// Get entity pointer from handle, NULL if handle is stale or invalid
+Entity *EntGet(EntHandler *handler, EntHandle handle);
+
+// Get current handle of entity in slot
+EntHandle EntGetHandle(EntHandler *handler, uint32_t id);
+
+// Get player entity, NULL if there is none
+Entity *EntPlayer(EntHandler *handler);
+
+// Slot index of handle, top bit set if it resolves. Hashed in place of the handle,
+// a snapshot restore advances generations of free slots, so equal states can hold different handles
+uint32_t EntHandleKey(EntHandler *handler, EntHandle handle);
 
 void ReserveDataPlayer(EntHandler *handler, Entity *ent);
 void ReserveDataFish(EntHandler *handler, Entity *ent);
 void ReserveDataNpc(EntHandler *handler, Entity *ent);
 void ReserveDataAsteroid(EntHandler *handler, Entity *ent);
+void ReserveDataOrbit(EntHandler *handler, Entity *ent);
+
+EntHandle AsteroidSpawn(EntHandler *handler, Vector2 position);
+
+// Spawn an asteroid at each position, storage is grown once up front. Returns number spawned
+uint32_t AsteroidSpawnBatch(EntHandler *handler, const Vector2 *positions, uint32_t count);
+
+// Radius asteroids are spawned with, from their spritesheet
+float AsteroidSpawnRadius(EntHandler *handler);
 
-void AsteroidSpawn(EntHandler *handler, Vector2 position);
 void FishSpawn(EntHandler *handler, Vector2 position);
 
 void FindPlayerOrbit(EntHandler *handler, float dt);
-void PlayerOrbitCast(EntHandler *handler);
+
+// Cast ray against capture radius of bodies, returns true and fills hit for closest body hit
+bool EntRaycastBodies(EntHandler *handler, Vector2 origin, Vector2 dir, float max_dist, EntHandle exclude, EntRayHit *hit);
+
+// Cast along player's orbit direction, ignores currently orbited body
+bool PlayerOrbitCast(EntHandler *handler, EntRayHit *hit);
 
 #endif
@@ -10,76 +10,89 @@ void EntInit(Entity *ent, uint8_t type) {
 
 void EntUpdatePosition(Entity *ent, float dt) {
 	// Move entity by it's velocity scaled by delta time
-	ent->position = Vector2Add(ent->position, Vector2Scale(ent->velocity, dt));	
+	ENT_POS(ent) = Vector2Add(ENT_POS(ent), Vector2Scale(ENT_VEL(ent), dt));	
+}
+
+void EntSetPosition(Entity *ent, Vector2 position) {
+	ENT_POS(ent) = position;
+	ENT_PREV_POS(ent) = position;
 }
 
 Vector2 EntCenter(Entity *ent) {
-	return Vector2Add(ent->position, ent->center_offset);
+	return Vector2Add(ENT_POS(ent), ENT_OFFSET(ent));
 }
 
 void EntOrbitStart(Entity *ent, Entity *orbit_body) {
-	ent->orbit_data = (OrbitData){0};
+	// Entity type has no orbit data reserved
+	if(!ent->orbit) return;
+
+	*ent->orbit = (OrbitData){0};
 
 	Vector2 ent_center = EntCenter(ent);
 	Vector2 orb_center = EntCenter(orbit_body);
 
 	Vector2 d = Vector2Subtract(ent_center, orb_center); 	
 	float r = Vector2Length(d);
-	float h = r - (orbit_body->radius + ent->radius);
+	float h = r - (ENT_RADIUS(orbit_body) + ENT_RADIUS(ent));
 	if(h < 0) h = 0;
 
 	Vector2 dir = Vector2Normalize(d);
-	Vector2 edge = Vector2Add(orb_center, Vector2Scale(dir, orbit_body->radius));
+	Vector2 edge = Vector2Add(orb_center, Vector2Scale(dir, ENT_RADIUS(orbit_body)));
 
 	Vector2 tangent = (Vector2){-dir.y, dir.x};
-	ent->orbit_angle = atan2f(dir.y, dir.x);
+	ent->orbit->angle = atan2f(dir.y, dir.x);
 
-	if(ent->type == ENT_PLAYER) {
+	if(ENT_TYPEOF(ent) == ENT_PLAYER) {
 		PlayerData *p = ent->data;
 		p->orbit_vel.y = 10;
 	}
 
-	ent->flags |= ENT_ORBIT;
+	// Orbit moves entity from here on, velocity picked up while free floating is dropped
+	ENT_FLAGS(ent) |= ENT_ORBIT;
+	ENT_VEL(ent) = Vector2Zero();
 
-	ent->orbit_data.initial_pos = ent_center;
-	ent->orbit_height = h;
-	ent->orbit_data.body_radius = orbit_body->radius;
-	ent->orbit_data.edge = edge;
-	ent->orbit_data.orbit_center = orb_center;
+	ent->orbit->initial_pos = ent_center;
+	ent->orbit->height = h;
+	ent->orbit->body_radius = ENT_RADIUS(orbit_body);
+	ent->orbit->edge = edge;
+	ent->orbit->orbit_center = orb_center;
 }
 
 void EntOrbitUpdate(Entity *ent, Entity *orbit_body, float dt) {
+	if(!ent->orbit) return;
+
+	ent->orbit->angle += ent->orbit->angular_vel * dt;
+
 	Vector2 ent_center = EntCenter(ent), orb_center = EntCenter(orbit_body);
 
-	Vector2 dir = (Vector2){cosf(ent->orbit_angle), sinf(ent->orbit_angle)};
-	ent_center = Vector2Add(orb_center, Vector2Scale(dir, orbit_body->radius + ent->orbit_height));	
+	Vector2 dir = (Vector2){cosf(ent->orbit->angle), sinf(ent->orbit->angle)};
+	ent_center = Vector2Add(orb_center, Vector2Scale(dir, ENT_RADIUS(orbit_body) + ent->orbit->height));	
 
-	ent->position = Vector2Add(ent_center, Vector2Scale(ent->center_offset, -1));
+	ENT_POS(ent) = Vector2Add(ent_center, Vector2Scale(ENT_OFFSET(ent), -1));
 
 	Vector2 tangent = {-dir.y, dir.x};
 
 	float targ_spr_angle = atan2f(tangent.y, tangent.x) * RAD2DEG; 
 	ent->sprite_angle = AngleLerp(ent->sprite_angle, targ_spr_angle, 0.1f * dt);
 
-	if(ent->orbit_height <= ent->radius) {
-		ent->orbit_height = ent->radius;
-		ent->flags |= ENT_GROUNDED;
+	if(ent->orbit->height <= ENT_RADIUS(ent)) {
+		ent->orbit->height = ENT_RADIUS(ent);
+		ENT_FLAGS(ent) |= ENT_GROUNDED;
 	}
 
-	if(ent->type == ENT_PLAYER) {
+	if(ENT_TYPEOF(ent) == ENT_PLAYER) {
 		PlayerData *p = ent->data;
 		p->orbit_dir = dir;
 	}
 	
 	// Limit orbit angle
-	if(ent->orbit_angle > PI2) ent->orbit_angle -= PI2;
-	else if(ent->orbit_angle < 0) ent->orbit_angle += PI2;
-
-	ent->orbit_data.orbit_center = orb_center;
-	ent->orbit_data.dir = dir;
-	ent->orbit_data.height = ent->orbit_height;
-	ent->orbit_data.edge = Vector2Add(orb_center, Vector2Scale(dir, orbit_body->radius));
-	ent->orbit_data.curr_pos = EntCenter(ent);
+	if(ent->orbit->angle > PI2) ent->orbit->angle -= PI2;
+	else if(ent->orbit->angle < 0) ent->orbit->angle += PI2;
+
+	ent->orbit->orbit_center = orb_center;
+	ent->orbit->dir = dir;
+	ent->orbit->edge = Vector2Add(orb_center, Vector2Scale(dir, ENT_RADIUS(orbit_body)));
+	ent->orbit->curr_pos = EntCenter(ent);
 }
 
 void OrbitDataDrawDebug(OrbitData *data) {
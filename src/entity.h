@@ -1,6 +1,7 @@
 #include <stdint.h>
 #include "raylib.h"
 #include "sprites.h"
+#include "render_queue.h"
 #include "input.h"
 
 #ifndef ENTITY_H_
@@ -14,6 +15,27 @@
 
 #define ENT_TYPE_COUNT	4
 
+// Entities per storage chunk, entity handler allocates chunks as the entity count grows
+#define ENT_CHUNK_BITS	8
+#define ENT_CHUNK_SIZE	(1 << ENT_CHUNK_BITS)
+#define ENT_CHUNK_MASK	(ENT_CHUNK_SIZE - 1)
+
+// Generational entity handle:
+// low ENT_INDEX_BITS hold the entity's slot index, high bits hold the slot's generation,
+// slot generations are bumped on destroy so handles to destroyed entities go stale
+typedef uint32_t EntHandle;
+
+#define ENT_HANDLE_NONE	0
+#define ENT_INDEX_BITS	20
+#define ENT_INDEX_MASK	((1u << ENT_INDEX_BITS) - 1)
+#define ENT_GEN_MASK	((1u << (32 - ENT_INDEX_BITS)) - 1)
+
+// Most entities a handler can hold, every index must fit a handle
+#define ENT_MAX_ENTITIES	(1u << ENT_INDEX_BITS)
+
+#define EntHandleIndex(h)	((h) & ENT_INDEX_MASK)
+#define EntHandleGen(h)		((h) >> ENT_INDEX_BITS)
+
 enum ENT_TYPE {
 	ENT_PLAYER,		
 	ENT_ASTEROID,
@@ -22,10 +44,11 @@ enum ENT_TYPE {
 };
 
 typedef struct  {
-	float angle;
-	float height;
+	EntHandle anchor;			// Handle of orbited body, ENT_HANDLE_NONE for none
+	float angle;				// Angle around orbited body in radians
+	float height;				// Distance from orbited body's surface
 	float body_radius;
-	float angular_vel;
+	float angular_vel;			// Radians per second, applied by orbit update
 	float next_angle;
 	float tang_vel;
 	float rad_vel;
@@ -37,44 +60,77 @@ typedef struct  {
 	Vector2 curr_pos;
 } OrbitData;
 
+// *** HOT ENTITY DATA ***
+//
+// Fields read by most per-entity loops (update, grid sync, body searches),
+// stored as parallel arrays so those loops only pull in the data they use.
+// Each storage chunk has it's own hot arrays, indexed by the low ENT_CHUNK_BITS of the entity id
+typedef struct EntHot {
+	uint8_t flags[ENT_CHUNK_SIZE];			// Bit flags: active, anchored, alive, etc...
+	uint8_t type[ENT_CHUNK_SIZE];			// Entity type
+	float radius[ENT_CHUNK_SIZE];
+
+	Vector2 position[ENT_CHUNK_SIZE];
+	Vector2 velocity[ENT_CHUNK_SIZE];
+	Vector2 center_offset[ENT_CHUNK_SIZE];
+
+	Vector2 prev_position[ENT_CHUNK_SIZE];	// Position at start of current tick, for interpolation
+} EntHot;
+
 // *** BASE ENTITY STRUCT ***	
 //
+// Cold entity fields, also acts as a view onto the entity's hot fields,
+// use the accessor macros below to read or write them
 typedef struct Entity {
-	uint8_t flags;			// Bit flags: active, anchored, alive, etc...
-	uint8_t type;			// Entity type
-	uint8_t sprite_id;		// Spritesheet index
+	struct EntHot *hot;		// Hot data arrays of entity's storage chunk
+	uint32_t id;			// Entity index, low bits index chunk's hot arrays
+	uint32_t data_id;		// Index into entity type's data arena
+	uint32_t orbit_id;		// Index into orbit data arena, only valid if orbit is set
 
-	float radius;
-	float orbit_height;
-	float orbit_angle;		// Angle used for physics calculations in radians
+	uint8_t sprite_id;		// Spritesheet index
 	float sprite_angle;		// Angle used for sprite rotation in degrees
+	float prev_sprite_angle;	// Sprite angle at start of current tick
 
-	Vector2 position;
-	Vector2 velocity;
-	Vector2 center_offset;
+	// Interpolated render state, set by entity handler before draw
+	Vector2 draw_pos;
+	float draw_angle;
 
-	OrbitData orbit_data;
-	
-	// Primary entity function pointers:
-	// functions specified on EntInit() 
-	void (*update)(struct Entity *self, float dt);
-	void (*draw)(struct Entity *self, SpriteLoader *sl);
+	// Pointer to orbit data side table entry, NULL for types that can't orbit
+	OrbitData *orbit;
 
 	// Pointer to entity type specific data
 	void *data;
 } Entity;
 
+// Typed batch functions, entity handler calls them once per run of entities of the same type,
+// types without a batch function are skipped entirely
+typedef void (*EntUpdateBatchFunc)(Entity **ents, uint32_t count, float dt);
+typedef void (*EntDrawBatchFunc)(Entity **ents, uint32_t count, RenderQueue *rq, SpriteLoader *sl);
+
+// Hot field accessors, these are lvalues (ie. ENT_POS(ent) = position;)
+#define ENT_FLAGS(e)	((e)->hot->flags[(e)->id & ENT_CHUNK_MASK])
+#define ENT_TYPEOF(e)	((e)->hot->type[(e)->id & ENT_CHUNK_MASK])
+#define ENT_RADIUS(e)	((e)->hot->radius[(e)->id & ENT_CHUNK_MASK])
+#define ENT_POS(e)		((e)->hot->position[(e)->id & ENT_CHUNK_MASK])
+#define ENT_VEL(e)		((e)->hot->velocity[(e)->id & ENT_CHUNK_MASK])
+#define ENT_OFFSET(e)	((e)->hot->center_offset[(e)->id & ENT_CHUNK_MASK])
+#define ENT_PREV_POS(e)	((e)->hot->prev_position[(e)->id & ENT_CHUNK_MASK])
+
 // *** SHARED ENTITY FUNCTIONS ***
 //
-// Initialize entity, set function pointers, data, etc.
+// Initialize entity, set data, etc.
 void EntInit(Entity *ent, uint8_t type);
 
 // Add current velocity of entity to entity's position
 void EntUpdatePosition(Entity *ent, float dt);
 
+// Place entity at position, without interpolating from it's previous position
+void EntSetPosition(Entity *ent, Vector2 position);
+
 Vector2 EntCenter(Entity *ent);
 
 void EntOrbitStart(Entity *ent, Entity *orbit_body);
+// Single entity orbit update, reference for the batched update in EntHandlerUpdate
 void EntOrbitUpdate(Entity *ent, Entity *orbit_body, float dt);
 void OrbitDataDrawDebug(OrbitData *data);
 
@@ -89,10 +145,11 @@ typedef struct {
 	short sprite_dir;			// Sprite direction
 	short active_anim;		    // Index of current animation, -1 for none
 	
-	int16_t anchor_id;			// Index of anchored body, -1 for none
-	int16_t prev_anchor_id;		// Index of previous anchored body
+	EntHandle anchor;			// Handle of anchored body, ENT_HANDLE_NONE for none
+	EntHandle prev_anchor;		// Handle of previous anchored body
 
-	int16_t raycast_id;	
+	EntHandle raycast_hit;		// Handle of body hit by orbit raycast
+	Vector2 raycast_point;		// Where orbit raycast hit body's capture radius
 
 	float orbit_height;			// How far away entity should be from orbited body
 	float grav_force;
@@ -104,6 +161,13 @@ typedef struct {
 
 	Camera2D *camera;			// Pointer to camera instance
 	InputState *input;			// Pointer to input state instance
+	struct ParticleSystem *particles;	// Effects spawned by player, NULL for none
+	struct ProjectileSystem *projectiles;	// Shots fired by player, NULL for none
+
+	float shot_charge;			// Seconds shoot has been held, up to PLR_CHARGE_TIME
+	float shot_timer;			// Seconds left in shoot state
+
+	Vector2 grav_pull;			// Body gravity on player, set while free floating
 	
 	SpriteAnimation *run_anim;
 } PlayerData;
@@ -124,11 +188,27 @@ enum PLAYER_STATES {
 #define PLR_JUMP_GRAV	   1000.0f		
 #define PLR_FALL_GRAV	    900.0f
 #define PLR_CUT_GRAV	   1850.0f
+#define PLR_FLOAT_SPEED		600.0f		// Most speed body gravity gives a free floating player
+
+// Shooting, shot speed goes from min to max over charge time
+#define PLR_CHARGE_TIME		1.0f
+#define PLR_SHOT_SPEED_MIN	900.0f
+#define PLR_SHOT_SPEED_MAX	2400.0f
+#define PLR_SHOT_RADIUS		4.0f
+#define PLR_SHOT_LIFE		2.0f
+#define PLR_SHOOT_TIME		0.15f		// Time spent in shoot state after firing
+#define PLR_SHOT_SPARKS		12
+
+// Effects
+#define PLR_THRUST_RATE		240.0f		// Thrust particles per second while jumping
+#define PLR_LAND_DUST		24			// Dust particles kicked up on landing
 
 void PlayerInit(Entity *player, SpriteLoader *sl, Camera2D *camera);
 void PlayerSpawn(Entity *player, Vector2 position);
 void PlayerUpdate(Entity *player, float dt);
-void PlayerDraw(Entity *player, SpriteLoader *sl);
+void PlayerDraw(Entity *player, RenderQueue *rq, SpriteLoader *sl);
+void PlayerUpdateBatch(Entity **players, uint32_t count, float dt);
+void PlayerDrawBatch(Entity **players, uint32_t count, RenderQueue *rq, SpriteLoader *sl);
 void PlayerInput(Entity *player, float dt);
 
 void PlayerPhysicsFreeFloat(Entity *player, float dt);
@@ -137,6 +217,8 @@ void PlayerSwitchOrbit(Entity *player, Entity *body_a, Entity *body_b);
 
 void PlayerStartJump(Entity *player);
 void PlayerEndJump(Entity *player, bool cut);
+void PlayerLand(Entity *player);
+void PlayerFire(Entity *player);
 
 // *** ASTEROID ***
 //
@@ -145,8 +227,8 @@ typedef struct {
 	uint8_t state;
 } AsteroidData;
 
-void AsteroidUpdate(Entity *asteroid, float dt);
-void AsteroidDraw(Entity *asteroid, SpriteLoader *sl);
+// Asteroids don't update, they only have a draw batch
+void AsteroidDrawBatch(Entity **asteroids, uint32_t count, RenderQueue *rq, SpriteLoader *sl);
 
 // *** FISH ***
 //
@@ -156,7 +238,7 @@ typedef struct {
 } FishData;
 
 void FishUpdate(Entity *fish, float dt);
-void FishDraw(Entity *fish, SpriteLoader *sl);
+void FishDraw(Entity *fish, RenderQueue *rq, SpriteLoader *sl);
 
 // *** NPC ***
 //
@@ -166,6 +248,6 @@ typedef struct {
 } NpcData;
 
 void NpcUpdate(Entity *npc, float dt);
-void NpcDraw(Entity *npc, SpriteLoader *sl);
+void NpcDraw(Entity *npc, RenderQueue *rq, SpriteLoader *sl);
 
 #endif // !ENTITY_H_
@@ -0,0 +1,284 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "raylib.h"
+#include "field_gen.h"
+#include "kmath.h"
+
+#define FIELD_TILE_POINTS	(FIELD_TILE_CELLS * FIELD_TILE_CELLS)
+
+typedef struct {
+	const FieldParams *params;
+	float cell;						// Cell side, spacing / sqrt(2) so a cell can't hold two points
+	float min_dist_sq;
+	int32_t cols, rows;
+	int32_t tiles_x, tiles_y;
+
+	int32_t *grid;					// Point index of each cell, -1 for empty
+	Vector2 *points;				// FIELD_TILE_POINTS slots per tile, indexed by tile then order placed, then exclusions
+	uint32_t *tile_counts;
+
+	// Exclusions can't be spaced, several may share a cell. The cell holds the first, the rest are chained
+	int32_t exclude_base;			// Point index of first exclusion
+	int32_t *exclude_next;			// Point index of next exclusion in cell, -1 for last
+
+	uint8_t colour;					// Colour being filled, x parity in bit 0, y parity in bit 1
+	int32_t colour_cols;			// Tiles of current colour per row
+} FieldGen;
+
+// No placed point closer than spacing, checks the 5x5 cells around point's cell
+static bool FieldPointFree(FieldGen *gen, Vector2 p, int32_t gx, int32_t gy) {
+	int32_t x0 = (gx > 2) ? gx - 2 : 0, x1 = (gx + 2 < gen->cols - 1) ? gx + 2 : gen->cols - 1;
+	int32_t y0 = (gy > 2) ? gy - 2 : 0, y1 = (gy + 2 < gen->rows - 1) ? gy + 2 : gen->rows - 1;
+
+	for(int32_t y = y0; y <= y1; y++) {
+		const int32_t *row = &gen->grid[y * gen->cols];
+
+		for(int32_t x = x0; x <= x1; x++) {
+			for(int32_t i = row[x]; i >= 0; i = (i >= gen->exclude_base) ? gen->exclude_next[i - gen->exclude_base] : -1) {
+				Vector2 q = gen->points[i];
+				float dx = q.x - p.x, dy = q.y - p.y;
+				if(dx * dx + dy * dy < gen->min_dist_sq) return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// Bridson's algorithm inside one tile, points grow new points around them until no more fit.
+// Candidates sit on a circle just past spacing at evenly stepped angles from a random start,
+// which fills as densely as random ring samples with far fewer attempts. Only cells inside the tile are written
+static void FieldFillTile(FieldGen *gen, int32_t tx, int32_t ty) {
+	const FieldParams *params = gen->params;
+	uint32_t tile = ty * gen->tiles_x + tx;
+	Vector2 *tile_points = &gen->points[(size_t)tile * FIELD_TILE_POINTS];
+
+	int32_t cx0 = tx * FIELD_TILE_CELLS, cy0 = ty * FIELD_TILE_CELLS;
+	int32_t cx1 = (cx0 + FIELD_TILE_CELLS < gen->cols) ? cx0 + FIELD_TILE_CELLS : gen->cols;
+	int32_t cy1 = (cy0 + FIELD_TILE_CELLS < gen->rows) ? cy0 + FIELD_TILE_CELLS : gen->rows;
+
+	// Tile area, last row and column of tiles stop at bounds
+	float x0 = params->bounds.x + cx0 * gen->cell, y0 = params->bounds.y + cy0 * gen->cell;
+	float x1 = fminf(params->bounds.x + cx1 * gen->cell, params->bounds.x + params->bounds.width);
+	float y1 = fminf(params->bounds.y + cy1 * gen->cell, params->bounds.y + params->bounds.height);
+
+	uint32_t rng = RandCellSeed(params->seed, tx, ty);
+	uint16_t active[FIELD_TILE_POINTS];
+	uint32_t active_count = 0, count = 0;
+	float ring = params->spacing * FIELD_RING_SCALE;
+
+	// Rotation between neighbouring candidates
+	float step_c = cosf(2 * PI / FIELD_ATTEMPTS), step_s = sinf(2 * PI / FIELD_ATTEMPTS);
+
+	for(uint32_t s = 0; s < FIELD_SEED_TRIES; s++) {
+		// Start from a random spot, later tries fill gaps left between earlier growth and neighbouring tiles
+		Vector2 p = { RandRange(&rng, x0, x1), RandRange(&rng, y0, y1) };
+		int32_t gx = (p.x - params->bounds.x) / gen->cell, gy = (p.y - params->bounds.y) / gen->cell;
+
+		if(gx < cx0 || gx >= cx1 || gy < cy0 || gy >= cy1 || !FieldPointFree(gen, p, gx, gy)) continue;
+
+		gen->grid[gy * gen->cols + gx] = tile * FIELD_TILE_POINTS + count;
+		tile_points[count] = p;
+		active[active_count++] = count++;
+
+		while(active_count > 0) {
+			uint32_t a = RandNext(&rng) % active_count;
+			Vector2 origin = tile_points[active[a]];
+			bool placed = false;
+
+			float angle = RandRange(&rng, 0, 2 * PI);
+			Vector2 dir = { cosf(angle), sinf(angle) };
+
+			for(uint32_t k = 0; k < FIELD_ATTEMPTS; k++) {
+				Vector2 c = { origin.x + dir.x * ring, origin.y + dir.y * ring };
+				dir = (Vector2){ dir.x * step_c - dir.y * step_s, dir.x * step_s + dir.y * step_c };
+
+				if(c.x < x0 || c.x >= x1 || c.y < y0 || c.y >= y1) continue;
+
+				int32_t cx = (c.x - params->bounds.x) / gen->cell, cy = (c.y - params->bounds.y) / gen->cell;
+				if(cx < cx0 || cx >= cx1 || cy < cy0 || cy >= cy1 || gen->grid[cy * gen->cols + cx] >= 0) continue;
+				if(!FieldPointFree(gen, c, cx, cy)) continue;
+
+				gen->grid[cy * gen->cols + cx] = tile * FIELD_TILE_POINTS + count;
+				tile_points[count] = c;
+				active[active_count++] = count++;
+				placed = true;
+				break;
+			}
+
+			// Point is surrounded, stop growing from it
+			if(!placed) active[a] = active[--active_count];
+		}
+	}
+
+	gen->tile_counts[tile] = count;
+}
+
+// Put exclusions in the grid before any tile is filled. Ones off the grid go in the nearest edge cell,
+// which is no further in cells from any point they're within spacing of. Ones further than that are left out
+static void FieldExclude(FieldGen *gen) {
+	const FieldParams *params = gen->params;
+	Rectangle b = params->bounds;
+
+	for(uint32_t i = 0; i < params->exclude_count; i++) {
+		Vector2 p = params->exclude[i];
+		gen->exclude_next[i] = -1;
+
+		if(p.x < b.x - params->spacing || p.x > b.x + b.width + params->spacing) continue;
+		if(p.y < b.y - params->spacing || p.y > b.y + b.height + params->spacing) continue;
+
+		int32_t gx = (int32_t)floorf((p.x - b.x) / gen->cell), gy = (int32_t)floorf((p.y - b.y) / gen->cell);
+		gx = (gx < 0) ? 0 : (gx >= gen->cols) ? gen->cols - 1 : gx;
+		gy = (gy < 0) ? 0 : (gy >= gen->rows) ? gen->rows - 1 : gy;
+
+		int32_t *cell = &gen->grid[gy * gen->cols + gx];
+		gen->points[gen->exclude_base + i] = p;
+		gen->exclude_next[i] = *cell;
+		*cell = gen->exclude_base + i;
+	}
+}
+
+// Job over the tiles of the current colour
+static void FieldFillJob(void *ctx, uint32_t begin, uint32_t end) {
+	FieldGen *gen = ctx;
+
+	for(uint32_t i = begin; i < end; i++) {
+		int32_t tx = (i % gen->colour_cols) * 2 + (gen->colour & 1);
+		int32_t ty = (i / gen->colour_cols) * 2 + (gen->colour >> 1);
+		FieldFillTile(gen, tx, ty);
+	}
+}
+
+bool FieldGenerate(const FieldParams *params, JobSystem *jobs, FieldPoints *out) {
+	*out = (FieldPoints){0};
+	if(params->spacing <= 0 || params->bounds.width <= 0 || params->bounds.height <= 0) return true;
+
+	FieldGen gen = { .params = params };
+	gen.cell = params->spacing / sqrtf(2);
+	gen.min_dist_sq = params->spacing * params->spacing;
+	gen.cols = (int32_t)ceilf(params->bounds.width / gen.cell);
+	gen.rows = (int32_t)ceilf(params->bounds.height / gen.cell);
+	gen.tiles_x = (gen.cols + FIELD_TILE_CELLS - 1) / FIELD_TILE_CELLS;
+	gen.tiles_y = (gen.rows + FIELD_TILE_CELLS - 1) / FIELD_TILE_CELLS;
+
+	size_t cells = (size_t)gen.cols * gen.rows;
+	size_t tiles = (size_t)gen.tiles_x * gen.tiles_y;
+
+	gen.exclude_base = tiles * FIELD_TILE_POINTS;
+
+	gen.grid = malloc(sizeof(int32_t) * cells);
+	gen.points = malloc(sizeof(Vector2) * (tiles * FIELD_TILE_POINTS + params->exclude_count));
+	gen.tile_counts = calloc(tiles, sizeof(uint32_t));
+	gen.exclude_next = malloc(sizeof(int32_t) * (params->exclude_count ? params->exclude_count : 1));
+
+	if(!gen.grid || !gen.points || !gen.tile_counts || !gen.exclude_next) {
+		free(gen.grid);
+		free(gen.points);
+		free(gen.tile_counts);
+		free(gen.exclude_next);
+		return false;
+	}
+
+	memset(gen.grid, 0xFF, sizeof(int32_t) * cells);
+	FieldExclude(&gen);
+
+	// Colours in fixed order, each one only starts once every tile of the previous one is done
+	for(uint8_t colour = 0; colour < 4; colour++) {
+		gen.colour = colour;
+		gen.colour_cols = (gen.tiles_x - (colour & 1) + 1) / 2;
+		int32_t colour_rows = (gen.tiles_y - (colour >> 1) + 1) / 2;
+
+		if(gen.colour_cols > 0 && colour_rows > 0)
+			JobParallelFor(jobs, FieldFillJob, &gen, gen.colour_cols * colour_rows, 1);
+	}
+
+	// Gather tiles in tile order
+	uint32_t total = 0;
+	for(size_t t = 0; t < tiles; t++) total += gen.tile_counts[t];
+
+	out->points = malloc(sizeof(Vector2) * (total ? total : 1));
+	if(!out->points) {
+		free(gen.grid);
+		free(gen.points);
+		free(gen.tile_counts);
+		free(gen.exclude_next);
+		return false;
+	}
+
+	for(size_t t = 0; t < tiles; t++) {
+		memcpy(&out->points[out->count], &gen.points[t * FIELD_TILE_POINTS], sizeof(Vector2) * gen.tile_counts[t]);
+		out->count += gen.tile_counts[t];
+	}
+
+	// Thin to max_points with a seeded partial shuffle, any subset of a Poisson-disk set keeps it's spacing
+	if(params->max_points && out->count > params->max_points) {
+		uint32_t rng = RandCellSeed(params->seed, -1, -1);
+
+		for(uint32_t i = 0; i < params->max_points; i++) {
+			uint32_t j = i + RandNext(&rng) % (out->count - i);
+			Vector2 tmp = out->points[i];
+			out->points[i] = out->points[j];
+			out->points[j] = tmp;
+		}
+
+		out->count = params->max_points;
+	}
+
+	free(gen.grid);
+	free(gen.points);
+	free(gen.tile_counts);
+	free(gen.exclude_next);
+	return true;
+}
+
+void FieldPointsFree(FieldPoints *points) {
+	free(points->points);
+	*points = (FieldPoints){0};
+}
+
+Rectangle FieldBoundsFor(uint32_t count, float spacing) {
+	float side = sqrtf(count / FIELD_FILL_DENSITY) * spacing;
+	return (Rectangle){ -side * 0.5f, -side * 0.5f, side, side };
+}
+
+uint32_t FieldSpawnAsteroids(EntHandler *handler, JobSystem *jobs, uint32_t seed, uint32_t count) {
+	float spacing = FieldBodySpacing(AsteroidSpawnRadius(handler));
+
+	// Start scene (player, first bodies) stays clear. Points are body positions, centers sit radius further along both axes
+	float radius = AsteroidSpawnRadius(handler);
+	Vector2 *exclude = malloc(sizeof(Vector2) * (handler->count ? handler->count : 1));
+	if(!exclude) {
+		printf("ERROR: Could not generate asteroid field of %u bodies\n", count);
+		return 0;
+	}
+
+	for(uint32_t i = 0; i < handler->count; i++) {
+		Vector2 center = EntCenter(EntAt(handler, handler->active[i]));
+		exclude[i] = (Vector2){ center.x - radius, center.y - radius };
+	}
+
+	FieldParams params = {
+		.seed = seed,
+		.bounds = FieldBoundsFor(count, spacing),
+		.spacing = spacing,
+		.max_points = count,
+		.exclude = exclude,
+		.exclude_count = handler->count
+	};
+
+	FieldPoints field;
+	bool ok = FieldGenerate(&params, jobs, &field);
+	free(exclude);
+
+	if(!ok) {
+		printf("ERROR: Could not generate asteroid field of %u bodies\n", count);
+		return 0;
+	}
+
+	uint32_t spawned = AsteroidSpawnBatch(handler, field.points, field.count);
+	FieldPointsFree(&field);
+
+	return spawned;
+}
@@ -0,0 +1,57 @@
+#ifndef FIELD_GEN_H_
+#define FIELD_GEN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "raylib.h"
+#include "jobs.h"
+#include "ent_handler.h"
+
+// Asteroid field generator:
+// Poisson-disk sampling (every pair of points at least spacing apart) over a grid of square tiles.
+// Tiles are split into four colours by tile coordinate parity, tiles of one colour are at least a tile apart
+// so they are filled in parallel, colours run one after another and each sees what earlier colours placed.
+// Every tile has it's own random stream from seed and tile coordinate, so results depend on seed only, never on thread count
+
+// Capture radius of a body is it's radius times this, see FindPlayerOrbit
+#define FIELD_CAPTURE_SCALE		3.0f
+
+#define FIELD_TILE_CELLS		16		// Tile side in grid cells, each cell holds at most one point
+#define FIELD_ATTEMPTS			12		// Candidates tried around a point before it stops growing, evenly spaced in angle
+#define FIELD_RING_SCALE		1.001f	// Candidates are placed just past spacing, packs tighter than a random distance
+#define FIELD_SEED_TRIES		16		// Random positions tried when a tile has nothing growing
+#define FIELD_FILL_DENSITY		0.75f	// Rough points per spacing squared area of a full fill
+
+typedef struct {
+	uint32_t seed;
+	Rectangle bounds;			// Points are kept inside
+	float spacing;				// Least distance between any two points
+	uint32_t max_points;		// Full fill is thinned to this many at random, 0 to keep all
+
+	// Points already there, generated points keep spacing from them. Not part of output, may lie outside bounds
+	const Vector2 *exclude;
+	uint32_t exclude_count;
+} FieldParams;
+
+typedef struct {
+	Vector2 *points;
+	uint32_t count;
+} FieldPoints;
+
+// Generate points, jobs may be NULL to run on calling thread. False if out of memory
+bool FieldGenerate(const FieldParams *params, JobSystem *jobs, FieldPoints *out);
+void FieldPointsFree(FieldPoints *points);
+
+// Spacing that keeps capture zones of bodies with radius from overlapping
+static inline float FieldBodySpacing(float radius) {
+	return radius * FIELD_CAPTURE_SCALE * 2;
+}
+
+// Square centered on origin that a full fill at spacing gives at least count points in
+Rectangle FieldBoundsFor(uint32_t count, float spacing);
+
+// Generate count asteroids spaced by their capture zones over bounds sized for count, and add them to handler.
+// Entities already in handler are kept clear of like bodies are. Returns number spawned
+uint32_t FieldSpawnAsteroids(EntHandler *handler, JobSystem *jobs, uint32_t seed, uint32_t count);
+
+#endif // !FIELD_GEN_H_
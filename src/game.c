@@ -1,12 +1,14 @@
+#include <stdio.h>
 #include <stdint.h>
+#include <math.h>
 #include "raylib.h"
 #include "raymath.h"
+#include "rlgl.h"
 #include "game.h"
 #include "config.h"
+#include "profiler.h"
 #include "sprites.h"
-
-// Buffer texture game draws to, used for scaling graphics to desired resolution 
-RenderTexture2D render_target;
+#include "clock.h"
 
 // Game state update and draw function type defines
 typedef void(*UpdateFunc)(Game *game, float dt);
@@ -31,31 +33,99 @@ void GameInit(Game *game) {
 		.zoom = 1.0f
 	};
 
+	game->stream_offset = Vector2Zero();
+
 	// Initialize input 
 	game->input_state = (InputState){0};
 
+	// Initialize sprite render queue
+	RenderQueueInit(&game->render_queue, RQ_DEFAULT_CAPACITY);
+
+	// Start worker threads
+	JobSystemInit(&game->jobs, game->conf.threadCount);
+
 	// Initialize entity handler
-	EntHandlerInit(&game->ent_handler, &game->sprite_loader, &game->cam);
+	EntHandlerInit(&game->ent_handler, &game->sprite_loader, &game->render_queue, &game->cam);
+	game->ent_handler.input = &game->input_state;
+	game->ent_handler.view_size = (Vector2){VIRTUAL_WIDTH, VIRTUAL_HEIGHT};
+	game->ent_handler.jobs = &game->jobs;
+
+	// Effects are cosmetic, gameplay runs without them if pools can't be allocated
+	if(ParticleSystemInit(&game->particles, &game->ent_handler, PARTICLE_POOL_CAPACITY))
+		game->ent_handler.particles = &game->particles;
+	else
+		printf("ERROR: Could not allocate particle pools\n");
+
+	// Without a pool players just can't shoot
+	if(ProjectileSystemInit(&game->projectiles, &game->ent_handler, PROJECTILE_CAPACITY))
+		game->ent_handler.projectiles = &game->projectiles;
+	else
+		printf("ERROR: Could not allocate projectile pool\n");
+
+	// Field is only streamed once gameplay starts, seed can still be changed until then
+	WorldInit(&game->world, &game->ent_handler, WORLD_DEFAULT_SEED);
+	game->ent_handler.world = &game->world;
+
+	// Allocate typical scene's entity storage now instead of during play
+	if(!EntHandlerReserve(&game->ent_handler, game->conf.entityReserve))
+		printf("ERROR: Could not reserve storage for %d entities\n", game->conf.entityReserve);
 }
 
 // Initialize necessary data for rendering the game 
 void GameRenderInit(Game *game) {
-	// Load empty texture, used as buffer for scaling
-	render_target = LoadRenderTexture(VIRTUAL_WIDTH, VIRTUAL_HEIGHT);
-	SetTextureFilter(render_target.texture, TEXTURE_FILTER_POINT);
+	// Load empty textures at each resolution scale, used as buffers for scaling
+	DynResInit(&game->dyn_res, VIRTUAL_WIDTH, VIRTUAL_HEIGHT, 
+		game->conf.windowWidth, game->conf.windowHeight, game->conf.refreshRate, game->conf.dynamicRes);
 
 	// Set source and destination rectangle values for window scaling
-	game->render_src_rec  = (Rectangle) { 0, 0, VIRTUAL_WIDTH, -VIRTUAL_HEIGHT };
+	game->render_src_rec  = game->dyn_res.src_recs[game->dyn_res.level];
 	game->render_dest_rec = (Rectangle) { 0, 0, game->conf.windowWidth, game->conf.windowHeight };
 }
 
-// Initialize sprite loader struct, load assets
+// Initialize sprite and sound loaders, start streaming assets
 void GameContentInit(Game *game) {
 	game->sprite_loader = (SpriteLoader){0};
-	LoadSpritesAll(&game->sprite_loader);
+	game->sound_loader = (SoundLoader){0};
+
+	// Only load frame layouts if running without a GL context
+	if(game->flags & GAME_HEADLESS) 
+		game->sprite_loader.flags |= SPR_LOADER_HEADLESS;
+
+	if(game->flags & GAME_LOOSE_ASSETS)
+		game->sprite_loader.flags |= SPR_LOADER_NO_PACK;
+
+	ContentBlocksInit();
+	StreamerInit(&game->streamer, &game->sprite_loader, &game->sound_loader);
+
+	// Title screen draws no sprites, gameplay content streams in while it's shown
+	GameLoadSpriteBlock(game, SPR_BLOCK_PLAYER);
+	GameLoadSpriteBlock(game, SPR_BLOCK_BODIES);
+	GameLoadAudioBlock(game, AUDIO_BLOCK_MAIN);
+}
+
+void GameLoadSpriteBlock(Game *game, uint8_t block_id) {
+	if(!StreamerRequest(&game->streamer, STREAM_SPRITES, block_id))
+		printf("ERROR: Could not request sprite block[%d]\n", block_id);
+}
+
+void GameLoadAudioBlock(Game *game, uint8_t block_id) {
+	if(!StreamerRequest(&game->streamer, STREAM_AUDIO, block_id))
+		printf("ERROR: Could not request audio block[%d]\n", block_id);
+}
+
+// Everything gameplay needs is uploaded
+bool GameContentReady(Game *game) {
+	Streamer *st = &game->streamer;
+
+	return (StreamerState(st, STREAM_SPRITES, SPR_BLOCK_PLAYER) == BLOCK_READY &&
+			StreamerState(st, STREAM_SPRITES, SPR_BLOCK_BODIES) == BLOCK_READY &&
+			StreamerState(st, STREAM_AUDIO, AUDIO_BLOCK_MAIN) == BLOCK_READY);
 }
 
 void GameUpdate(Game *game) {
+	PROF_BEGIN("GameUpdate");
+	game->frame_start_ns = ClockNowNs();
+
 	// Get delta time once only, pass to other update functions
 	float delta_time = GetFrameTime();
 
@@ -67,42 +137,151 @@ void GameUpdate(Game *game) {
 	if((game->flags & INPUT_SPECIFIED) == 0) 
 		if(IsGamepadAvailable(0)) game->input_method = GAMEPAD; 
 
+	// Upload whatever the loader thread has decoded, within frame budget
+	PROF_BEGIN("StreamerUpdate");
+	StreamerUpdate(&game->streamer, STREAM_UPLOAD_BUDGET_NS);
+	PROF_END();
+
 	// Poll input
+	PROF_BEGIN("ProcessInput");
 	ProcessInput(&game->input_state, delta_time);
-	
+	PROF_END();
+
+	// Menus and screens update once per frame, only gameplay runs on fixed ticks
+	if(game->state != GAME_MAIN) {
+		GameStep(game, delta_time);
+		PROF_END();
+		return;
+	}
+
+	// Run as many fixed ticks as frame time has accumulated 
+	float tick_dt = 1.0f / game->conf.tickRate;
+	game->tick_accum += delta_time;
+
+	int ticks = 0;
+	while(game->tick_accum >= tick_dt && ticks < game->conf.maxTicksPerFrame) {
+		GameStep(game, tick_dt);
+		game->tick_accum -= tick_dt;
+		ticks++;
+	}
+
+	// Drop whole ticks that couldn't be caught up on, prevents slow frames from queueing ever more ticks.
+	// Partial tick is kept so alpha stays below 1 and the next frame doesn't owe a tick straight away
+	if(game->tick_accum >= tick_dt) game->tick_accum = fmodf(game->tick_accum, tick_dt);
+
+	// Fraction of a tick left over, used to interpolate rendering
+	game->tick_alpha = Clamp(game->tick_accum / tick_dt, 0, 1);
+
+	PROF_END();
+}
+
+// Advance game state, input state should already be up to date
+void GameStep(Game *game, float delta_time) {
+	uint8_t state = game->state;
+
 	// Call state appropriate update function
 	game_update_funcs[game->state](game, delta_time);
+
+	// Gameplay ticks are logged with the input they ran on and the state they left
+	if(state == GAME_MAIN && game->replay.mode == REPLAY_RECORD)
+		ReplayRecordTick(&game->replay, &game->input_state, delta_time, EntHandlerHash(&game->ent_handler));
+}
+
+// Finish frame, cost is measured up to the buffer swap and picks the next frame's resolution
+static void GameEndDrawing(Game *game) {
+	uint64_t work_ns = ClockNowNs() - game->frame_start_ns;
+	EndDrawing();
+
+	if(DynResUpdate(&game->dyn_res, work_ns, GetFrameTime()))
+		game->render_src_rec = game->dyn_res.src_recs[game->dyn_res.level];
 }
 
-// Render game to buffer texture
+// Screen space drawing is laid out at virtual resolution, scale it to current render target.
+// Camera transforms replace this, so it's set again after leaving 2D mode
+static void ScreenSpaceScale(Game *game) {
+	float scale = DynResScale(&game->dyn_res);
+	rlScalef(scale, scale, 1);
+}
+
+// Call state appropriate draw function at current resolution scale.
+// Camera is scaled around the view center for the draw only, world coordinates stay the same at every scale
+static void GameDrawState(Game *game, uint8_t flags) {
+	float scale = DynResScale(&game->dyn_res);
+	Camera2D cam = game->cam;
+	Vector2 view_size = game->ent_handler.view_size;
+
+	game->cam.zoom *= scale;
+	game->cam.offset = Vector2Scale(cam.offset, scale);
+	game->ent_handler.view_size = Vector2Scale(view_size, scale);
+
+	rlPushMatrix();
+	ScreenSpaceScale(game);
+	game_draw_funcs[game->state](game, flags);
+	rlPopMatrix();
+
+	game->cam = cam;
+	game->ent_handler.view_size = view_size;
+}
+
+void GameDraw(Game *game, uint8_t flags) {
+	if(!DynResDirect(&game->dyn_res)) {
+		GameDrawToBuffer(game, flags);
+		GameDrawToWindow(game);
+		return;
+	}
+
+	// Window is the same size as the buffer would be, skip it
+	PROF_BEGIN("GameDrawDirect");
+	BeginDrawing();
+	ClearBackground(BLACK);
+	GameDrawState(game, flags);
+	GameEndDrawing(game);
+	PROF_END();
+}
+
+// Render game to current buffer texture
 void GameDrawToBuffer(Game *game, uint8_t flags) {
-	BeginTextureMode(render_target);
+	PROF_BEGIN("GameDrawToBuffer");
+	BeginTextureMode(*DynResTarget(&game->dyn_res));
 	ClearBackground(BLACK);
 
-	// Call state appropriate draw function
-	game_draw_funcs[game->state](game, flags);
+	GameDrawState(game, flags);
 
 	EndTextureMode();
+	PROF_END();
 }
 
 // Render buffer onto window
 void GameDrawToWindow(Game *game) {
+	PROF_BEGIN("GameDrawToWindow");
 	BeginDrawing();
 	ClearBackground(BLACK);
 	
-	// Draw scaled render_target texture to window 
-	DrawTexturePro(render_target.texture, game->render_src_rec, game->render_dest_rec, Vector2Zero(), 0, WHITE);
-	EndDrawing();
+	// Draw current buffer texture scaled to window
+	DrawTexturePro(DynResTarget(&game->dyn_res)->texture, game->render_src_rec, game->render_dest_rec, Vector2Zero(), 0, WHITE);
+	GameEndDrawing(game);
+	PROF_END();
 }
 
 // Free allocated memory for buffer texture and assets 
 void GameClose(Game *game) {
-	UnloadRenderTexture(render_target);
+	if(!(game->flags & GAME_HEADLESS)) DynResClose(&game->dyn_res);
+	ReplayClose(&game->replay);
+	StreamerClose(&game->streamer);
 	SpriteLoaderClose(&game->sprite_loader);
+	SoundLoaderClose(&game->sound_loader);
+	WorldClose(&game->world);
+	ParticleSystemClose(&game->particles);
+	ProjectileSystemClose(&game->projectiles);
+	EntHandlerClose(&game->ent_handler);
+	RenderQueueClose(&game->render_queue);
+	JobSystemClose(&game->jobs);
 }
 
-// Update title screen UI elements, start gameplay on user input
+// Update title screen UI elements, start gameplay on user input once content is in
 void TitleUpdate(Game *game, float delta_time) {
+	if(!GameContentReady(game)) return;
+
 	if(IsKeyPressed(KEY_SPACE) || IsGamepadButtonPressed(0, GAMEPAD_BUTTON_RIGHT_FACE_DOWN))
 		MainStart(game);
 }
@@ -111,14 +290,45 @@ void TitleUpdate(Game *game, float delta_time) {
 void TitleDraw(Game *game, uint8_t flags) {
 	Vector2 screen_center = Vector2Scale((Vector2){VIRTUAL_WIDTH, VIRTUAL_HEIGHT}, 0.5f);
 	char *prompt_text = (game->input_method == KEYBOARD) ? "press space to play" : "press A to play";
+	if(!GameContentReady(game)) prompt_text = "loading...";
 
 	DrawText("Fish game Demo", screen_center.x - 380, screen_center.y - 100, 100, RAYWHITE);
 	DrawText(prompt_text, screen_center.x - 160, screen_center.y + 100, 32, RAYWHITE);
 }
 
+// React to projectile hits of last update, in the order the pool reported them
+static void MainApplyProjectileHits(Game *game) {
+	ProjectileSystem *ps = &game->projectiles;
+
+	for(uint32_t i = 0; i < ps->hit_count; i++) {
+		ProjectileHit *hit = &ps->hits[i];
+		ParticleBurst(&game->particles, PFX_IMPACT, hit->point, atan2f(hit->normal.y, hit->normal.x) * RAD2DEG, PLR_SHOT_SPARKS);
+
+		// Fish go down in one shot, a second hit in the same tick finds the handle stale
+		if(hit->target_type == ENT_FISH) EntDestroy(&game->ent_handler, hit->target);
+	}
+}
+
 // Main gameplay loop logic
 void MainUpdate(Game *game, float delta_time) {
 	EntHandlerUpdate(&game->ent_handler, delta_time);
+
+	// Sweeps use the grid as entities left it, before streaming adds or removes bodies
+	if(game->ent_handler.projectiles) {
+		ProjectileSystemUpdate(&game->projectiles, delta_time);
+		MainApplyProjectileHits(game);
+	}
+
+	// Runs on the tick, so replays see the same chunks come and go. Chunks stream around the player, camera without one
+	if(game->flags & GAME_WORLD_STREAM) {
+		Entity *player = EntPlayer(&game->ent_handler);
+		Vector2 center = (player) ? EntCenter(player) : game->cam.target;
+		WorldUpdate(&game->world, Vector2Add(center, game->stream_offset));
+	}
+
+	PROF_BEGIN("ParticleSystemUpdate");
+	ParticleSystemUpdate(&game->particles, delta_time);
+	PROF_END();
 }
 
 // Render objects to buffer texture
@@ -127,10 +337,34 @@ void MainDraw(Game *game, uint8_t flags) {
 
 	// With camera transformations:
 	BeginMode2D(game->cam);
-	EntHandlerDraw(&game->ent_handler, (SHOW_DEBUG));
+	PROF_BEGIN("EntHandlerDraw");
+	EntHandlerDraw(&game->ent_handler, game->tick_alpha, (SHOW_DEBUG));
+	PROF_END();
+
+	PROF_BEGIN("ParticleSystemDraw");
+	ParticleSystemDraw(&game->particles);
+	PROF_END();
+
+	ProjectileSystemDraw(&game->projectiles, game->tick_alpha);
 	EndMode2D();
 	
 	// No camera transformations:
+	ScreenSpaceScale(game);
+	if(flags & SHOW_DEBUG) {
+		RenderStats *stats = &game->render_queue.stats;
+		DrawText(TextFormat("sprites: %d draw calls: %d batch flushes: %d", stats->sprites, stats->draw_calls, stats->batch_flushes), 10, 10, 20, GREEN);
+		DrawText(TextFormat("entities drawn: %d culled: %d", game->ent_handler.drawn_count, game->ent_handler.culled_count), 10, 34, 20, GREEN);
+		DrawText(TextFormat("world chunks resident: %d changed: %d (%d KiB)", game->world.resident_count, game->world.record_count, (int)(game->world.record_bytes / 1024)), 10, 58, 20, GREEN);
+
+		ParticleStats *pstats = &game->particles.stats;
+		DrawText(TextFormat("particles: %d draw calls: %d batch flushes: %d dropped: %d", pstats->live, pstats->draw_calls, pstats->batch_flushes, pstats->dropped), 10, 82, 20, GREEN);
+
+		ProjectileStats *jstats = &game->projectiles.stats;
+		DrawText(TextFormat("projectiles: %d fired: %d dropped: %d candidates: %d", jstats->live, jstats->fired, jstats->dropped, jstats->candidates), 10, 106, 20, GREEN);
+
+		// Zone tree of last frame, empty when built without profiler
+		PROF_DRAW_OVERLAY(10, 130);
+	}
 }
 
 void OverScreenUpdate(Game *game, float delta_time) {
@@ -147,12 +381,19 @@ void OptionsScreenDraw(Game *game, uint8_t flags) {
 
 // Start gameplay
 void MainStart(Game *game) {
-	EntMake(&game->ent_handler, ENT_PLAYER);
-	game->ent_handler.ents[0].position = (Vector2){-90, 100};
+	// Blocks are normally streamed in by now, this only waits if play starts before they finish
+	StreamerFinish(&game->streamer, STREAM_SPRITES, SPR_BLOCK_PLAYER);
+	StreamerFinish(&game->streamer, STREAM_SPRITES, SPR_BLOCK_BODIES);
+	StreamerFinish(&game->streamer, STREAM_AUDIO, AUDIO_BLOCK_MAIN);
+
+	// Effects from a previous run would point at stale entities
+	ParticleSystemClear(&game->particles);
+	ProjectileSystemClear(&game->projectiles);
+
+	// Handler keeps the player's handle for orbit search and debug draw
+	Entity *player = EntGet(&game->ent_handler, EntMake(&game->ent_handler, ENT_PLAYER));
+	EntSetPosition(player, (Vector2){-90, 100});
 
-	PlayerData *p = game->ent_handler.ents[0].data;
-	p->input = &game->input_state;
-	
 	//game->ent_handler.ents[0].position = (Vector2){0, 0};
 
 	AsteroidSpawn(&game->ent_handler, (Vector2){0, 0});
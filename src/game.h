@@ -2,9 +2,19 @@
 #include "raylib.h"
 #include "config.h"
 #include "sprites.h"
+#include "sounds.h"
+#include "content.h"
+#include "streamer.h"
+#include "render_queue.h"
 #include "entity.h"
 #include "ent_handler.h"
 #include "input.h"
+#include "replay.h"
+#include "jobs.h"
+#include "dyn_res.h"
+#include "world.h"
+#include "particles.h"
+#include "projectiles.h"
 
 #ifndef GAME_H_
 #define GAME_H_
@@ -20,6 +30,9 @@
 #define GAME_PAUSED			0x02
 #define GAME_QUIT_REQUEST   0x04
 #define INPUT_SPECIFIED	    0x08
+#define GAME_HEADLESS		0x10	// No window, GL context or textures
+#define GAME_LOOSE_ASSETS	0x20	// Load loose pngs even if an asset pack exists
+#define GAME_WORLD_STREAM	0x40	// Stream asteroid field chunks around player during gameplay
 
 enum GAME_STATES {
 	GAME_TITLE,
@@ -39,12 +52,26 @@ typedef struct {
 	uint8_t input_method;
 
 	Rectangle render_src_rec, render_dest_rec;
+	DynRes dyn_res;			// Render targets at each resolution scale, picks one from frame cost
+	uint64_t frame_start_ns;	// Start of current frame's update, for measuring frame cost
+
+	float tick_accum;		// Frame time not yet simulated
+	float tick_alpha;		// Fraction of a tick between last and next simulation state
+	Vector2 stream_offset;	// Added to player position to get world stream center
 
 	Config conf;
 	Camera2D cam;
 	InputState input_state;
+	Replay replay;
 	SpriteLoader sprite_loader;
+	SoundLoader sound_loader;
+	Streamer streamer;
+	RenderQueue render_queue;
+	JobSystem jobs;
 	EntHandler ent_handler;
+	World world;
+	ParticleSystem particles;
+	ProjectileSystem projectiles;
 } Game;
 
 void GameInit(Game *game);
@@ -52,7 +79,10 @@ void GameRenderInit(Game *game);
 void GameContentInit(Game *game);
 
 void GameUpdate(Game *game);
+void GameStep(Game *game, float delta_time);
 
+// Draw frame, through current render target or straight to window if it matches virtual resolution
+void GameDraw(Game *game, uint8_t flags);
 void GameDrawToBuffer(Game *game, uint8_t flags);
 void GameDrawToWindow(Game *game);
 
@@ -72,7 +102,9 @@ void OptionsScreenDraw(Game *game, uint8_t flags);
 
 void MainStart(Game *game);
 
+// Request content blocks, they stream in over the next frames, check progress with StreamerState
 void GameLoadSpriteBlock(Game *game, uint8_t block_id);
 void GameLoadAudioBlock(Game *game, uint8_t block_id);
+bool GameContentReady(Game *game);
 
 #endif
@@ -0,0 +1,321 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raylib.h"
+#include "gravity.h"
+
+// Radix sort digit width, keys are sorted on their upper 32 bits
+#define GRAVITY_RADIX_BITS	8
+#define GRAVITY_RADIX		(1 << GRAVITY_RADIX_BITS)
+
+void GravityTreeInit(GravityTree *tree) {
+	*tree = (GravityTree){0};
+	tree->theta = GRAVITY_THETA;
+}
+
+void GravityTreeClose(GravityTree *tree) {
+	free(tree->x);
+	free(tree->keys);
+	free(tree->com_x);
+	free(tree->next);
+
+	float theta = tree->theta;
+	*tree = (GravityTree){0};
+	tree->theta = theta;
+}
+
+// Tree is rebuilt once it's grown, so old contents are dropped instead of copied
+bool GravityTreeReserve(GravityTree *tree, uint32_t capacity) {
+	if(capacity <= tree->capacity) return true;
+
+	// Every internal node splits, so there are fewer internal nodes than leaves and no more leaves than bodies
+	uint32_t node_cap = capacity * 2;
+	GravityTreeClose(tree);
+
+	// Body and node fields each share one allocation
+	float *bodies = malloc(sizeof(float) * capacity * 9);
+	uint64_t *keys = malloc(sizeof(uint64_t) * capacity * 2);
+	float *nodes = malloc(sizeof(float) * node_cap * 4);
+	uint32_t *links = malloc(sizeof(uint32_t) * node_cap * 3);
+
+	if(!bodies || !keys || !nodes || !links) {
+		free(bodies);
+		free(keys);
+		free(nodes);
+		free(links);
+		return false;
+	}
+
+	tree->capacity = capacity;
+	tree->x = bodies;
+	tree->y = bodies + capacity;
+	tree->mass = bodies + capacity * 2;
+	tree->body_x = bodies + capacity * 3;
+	tree->body_y = bodies + capacity * 4;
+	tree->body_mass = bodies + capacity * 5;
+	tree->last = bodies + capacity * 6;
+	tree->keys = keys;
+
+	tree->com_x = nodes;
+	tree->com_y = nodes + node_cap;
+	tree->node_mass = nodes + node_cap * 2;
+	tree->size2 = nodes + node_cap * 3;
+
+	tree->next = links;
+	tree->first = links + node_cap;
+	tree->leaf_count = links + node_cap * 2;
+
+	return true;
+}
+
+// Spread low 16 bits of v to even bits
+static inline uint32_t MortonSpread(uint32_t v) {
+	v &= 0xFFFF;
+	v = (v | (v << 8)) & 0x00FF00FF;
+	v = (v | (v << 4)) & 0x0F0F0F0F;
+	v = (v | (v << 2)) & 0x33333333;
+	v = (v | (v << 1)) & 0x55555555;
+	return v;
+}
+
+static inline uint32_t GravityCode(const GravityTree *tree, uint32_t i) {
+	return (uint32_t)(tree->keys[i] >> 32);
+}
+
+// Stable LSD radix sort of keys on their Morton half, equal codes keep the order bodies were added in
+static void GravitySortKeys(uint64_t *keys, uint64_t *buffer, uint32_t count) {
+	uint64_t *src = keys, *dst = buffer;
+
+	for(uint32_t shift = 32; shift < 64; shift += GRAVITY_RADIX_BITS) {
+		uint32_t offsets[GRAVITY_RADIX] = {0};
+		for(uint32_t i = 0; i < count; i++) offsets[(src[i] >> shift) & (GRAVITY_RADIX - 1)]++;
+
+		uint32_t sum = 0;
+		for(uint32_t d = 0; d < GRAVITY_RADIX; d++) {
+			uint32_t n = offsets[d];
+			offsets[d] = sum;
+			sum += n;
+		}
+
+		for(uint32_t i = 0; i < count; i++) dst[offsets[(src[i] >> shift) & (GRAVITY_RADIX - 1)]++] = src[i];
+
+		uint64_t *swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	// Even pass count, sorted keys end up back in keys
+}
+
+// Add node over bodies [begin, end), all sharing their top level cells. Returns node index
+static uint32_t GravityBuildNode(GravityTree *tree, uint32_t begin, uint32_t end, uint32_t level, float size) {
+	// Descend through cells holding all of the range, the node only needs the smallest one
+	while(end - begin > GRAVITY_LEAF_SIZE && level < GRAVITY_DEPTH) {
+		uint32_t shift = 2 * (GRAVITY_DEPTH - 1 - level);
+		if(((GravityCode(tree, begin) >> shift) & 3) != ((GravityCode(tree, end - 1) >> shift) & 3)) break;
+
+		level++;
+		size *= 0.5f;
+	}
+
+	uint32_t n = tree->node_count++;
+	tree->size2[n] = size * size;
+
+	float mass = 0, mx = 0, my = 0;
+
+	if(end - begin <= GRAVITY_LEAF_SIZE || level == GRAVITY_DEPTH) {
+		tree->first[n] = begin;
+		tree->leaf_count[n] = end - begin;
+
+		for(uint32_t i = begin; i < end; i++) {
+			mass += tree->body_mass[i];
+			mx += tree->body_x[i] * tree->body_mass[i];
+			my += tree->body_y[i] * tree->body_mass[i];
+		}
+	} else {
+		tree->first[n] = 0;
+		tree->leaf_count[n] = 0;
+
+		// Range is sorted, so each quadrant's bodies follow the previous quadrant's
+		uint32_t shift = 2 * (GRAVITY_DEPTH - 1 - level);
+		uint32_t child_begin = begin;
+
+		while(child_begin < end) {
+			uint32_t quadrant = (GravityCode(tree, child_begin) >> shift) & 3;
+			uint32_t child_end = child_begin + 1;
+			while(child_end < end && ((GravityCode(tree, child_end) >> shift) & 3) == quadrant) child_end++;
+
+			uint32_t child = GravityBuildNode(tree, child_begin, child_end, level + 1, size * 0.5f);
+			mass += tree->node_mass[child];
+			mx += tree->com_x[child] * tree->node_mass[child];
+			my += tree->com_y[child] * tree->node_mass[child];
+
+			child_begin = child_end;
+		}
+	}
+
+	float inv_mass = (mass > 0) ? 1.0f / mass : 0;
+	tree->node_mass[n] = mass;
+	tree->com_x[n] = mx * inv_mass;
+	tree->com_y[n] = my * inv_mass;
+	tree->next[n] = tree->node_count;
+
+	return n;
+}
+
+// Inputs bit for bit equal to last build's
+static bool GravitySameBodies(const GravityTree *tree) {
+	uint32_t count = tree->count, cap = tree->capacity;
+	if(count != tree->built_count) return false;
+
+	return memcmp(tree->last, tree->x, count * sizeof(float)) == 0 &&
+		memcmp(tree->last + cap, tree->y, count * sizeof(float)) == 0 &&
+		memcmp(tree->last + cap * 2, tree->mass, count * sizeof(float)) == 0;
+}
+
+bool GravityTreeBuild(GravityTree *tree) {
+	if(GravitySameBodies(tree)) return false;
+
+	uint32_t count = tree->count, cap = tree->capacity;
+	tree->node_count = 0;
+	tree->built_count = count;
+	if(!count) return true;
+
+	memcpy(tree->last, tree->x, count * sizeof(float));
+	memcpy(tree->last + cap, tree->y, count * sizeof(float));
+	memcpy(tree->last + cap * 2, tree->mass, count * sizeof(float));
+
+	float min_x = tree->x[0], min_y = tree->y[0], max_x = min_x, max_y = min_y;
+	for(uint32_t i = 1; i < count; i++) {
+		min_x = fminf(min_x, tree->x[i]);
+		min_y = fminf(min_y, tree->y[i]);
+		max_x = fmaxf(max_x, tree->x[i]);
+		max_y = fmaxf(max_y, tree->y[i]);
+	}
+
+	// Root cell is a square over all bodies, padded so the far edge quantizes inside it
+	float size = fmaxf(fmaxf(max_x - min_x, max_y - min_y), 1.0f) * 1.001f;
+	float scale = (1 << GRAVITY_DEPTH) / size;
+
+	for(uint32_t i = 0; i < count; i++) {
+		uint32_t qx = (uint32_t)((tree->x[i] - min_x) * scale);
+		uint32_t qy = (uint32_t)((tree->y[i] - min_y) * scale);
+		uint32_t code = MortonSpread(qx) | (MortonSpread(qy) << 1);
+		tree->keys[i] = ((uint64_t)code << 32) | i;
+	}
+
+	GravitySortKeys(tree->keys, tree->keys + cap, count);
+
+	for(uint32_t i = 0; i < count; i++) {
+		uint32_t src = (uint32_t)tree->keys[i];
+		tree->body_x[i] = tree->x[src];
+		tree->body_y[i] = tree->y[src];
+		tree->body_mass[i] = tree->mass[src];
+	}
+
+	GravityBuildNode(tree, 0, count, 0, size);
+	return true;
+}
+
+// Add pull of mass at offset d from point
+static inline void GravityPull(float dx, float dy, float mass, float *ax, float *ay) {
+	float inv = 1.0f / sqrtf(dx * dx + dy * dy + GRAVITY_SOFTENING * GRAVITY_SOFTENING);
+	float s = mass * inv * inv * inv;
+	*ax += dx * s;
+	*ay += dy * s;
+}
+
+Vector2 GravityAccel(const GravityTree *tree, Vector2 position) {
+	float ax = 0, ay = 0;
+	float theta2 = tree->theta * tree->theta;
+
+	uint32_t n = 0;
+	while(n < tree->node_count) {
+		float dx = tree->com_x[n] - position.x;
+		float dy = tree->com_y[n] - position.y;
+
+		if(tree->size2[n] < theta2 * (dx * dx + dy * dy)) {
+			// Far enough to count as one mass
+			GravityPull(dx, dy, tree->node_mass[n], &ax, &ay);
+			n = tree->next[n];
+		} else if(tree->leaf_count[n]) {
+			uint32_t end = tree->first[n] + tree->leaf_count[n];
+			for(uint32_t i = tree->first[n]; i < end; i++)
+				GravityPull(tree->body_x[i] - position.x, tree->body_y[i] - position.y, tree->body_mass[i], &ax, &ay);
+
+			n = tree->next[n];
+		} else {
+			// Children follow their parent
+			n++;
+		}
+	}
+
+	return (Vector2){ ax * GRAVITY_STRENGTH, ay * GRAVITY_STRENGTH };
+}
+
+Vector2 GravityAccelDirect(const GravityTree *tree, Vector2 position) {
+	float ax = 0, ay = 0;
+
+	for(uint32_t i = 0; i < tree->built_count; i++)
+		GravityPull(tree->body_x[i] - position.x, tree->body_y[i] - position.y, tree->body_mass[i], &ax, &ay);
+
+	return (Vector2){ ax * GRAVITY_STRENGTH, ay * GRAVITY_STRENGTH };
+}
+
+void GravityBatchInit(GravityBatch *batch) {
+	*batch = (GravityBatch){0};
+}
+
+void GravityBatchClose(GravityBatch *batch) {
+	free(batch->ids);
+	free(batch->x);
+	*batch = (GravityBatch){0};
+}
+
+// Batch is refilled every update, so old contents are dropped instead of copied
+bool GravityBatchReserve(GravityBatch *batch, uint32_t capacity) {
+	if(capacity <= batch->capacity) return true;
+	GravityBatchClose(batch);
+
+	uint32_t *ids = malloc(sizeof(uint32_t) * capacity);
+	float *block = malloc(sizeof(float) * capacity * 4);
+
+	if(!ids || !block) {
+		free(ids);
+		free(block);
+		return false;
+	}
+
+	batch->capacity = capacity;
+	batch->ids = ids;
+	batch->x = block;
+	batch->y = block + capacity;
+	batch->ax = block + capacity * 2;
+	batch->ay = block + capacity * 3;
+
+	return true;
+}
+
+typedef struct {
+	GravityBatch *batch;
+	const GravityTree *tree;
+} GravitySolveCtx;
+
+static void GravitySolveJob(void *ctx, uint32_t begin, uint32_t end) {
+	GravitySolveCtx *solve = ctx;
+	GravityBatch *batch = solve->batch;
+
+	for(uint32_t i = begin; i < end; i++) {
+		Vector2 accel = GravityAccel(solve->tree, (Vector2){ batch->x[i], batch->y[i] });
+		batch->ax[i] = accel.x;
+		batch->ay[i] = accel.y;
+	}
+}
+
+void GravityBatchSolve(GravityBatch *batch, const GravityTree *tree, JobSystem *jobs) {
+	if(!batch->count) return;
+
+	GravitySolveCtx solve = { batch, tree };
+	JobParallelFor(jobs, GravitySolveJob, &solve, batch->count, GRAVITY_JOB_CHUNK);
+}
@@ -0,0 +1,91 @@
+#ifndef GRAVITY_H_
+#define GRAVITY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "raylib.h"
+#include "jobs.h"
+
+// Barnes-Hut gravity:
+// bodies are sorted along a Morton curve and a quadtree is built over the sorted order. Nodes are stored depth first
+// with the index just past their subtree, so evaluation walks the tree without a stack: a node small enough for it's
+// distance (side / distance under the opening angle) pulls as one mass at it's center of mass, otherwise it's children,
+// or a leaf's bodies, are visited. Quadrants with a single occupied child are skipped, so every internal node splits.
+// The tree only depends on the bodies and the order they were added in, evaluation of one point never affects another.
+// Bodies rarely move, so a build over bodies equal to the last build's keeps the tree it has
+
+#define GRAVITY_THETA		0.5f		// Default opening angle, 0 visits every body
+#define GRAVITY_LEAF_SIZE	8			// Most bodies in a leaf, unless they share a cell at full depth
+#define GRAVITY_DEPTH		16			// Morton bits per axis, cells at full depth are bounds / 65536
+
+// Body mass is radius squared, so pull at a body's surface is this many units per second squared
+#define GRAVITY_STRENGTH	600.0f
+
+// Distance added to keep pull finite close to a body's center
+#define GRAVITY_SOFTENING	32.0f
+
+// Most points evaluated by a single job
+#define GRAVITY_JOB_CHUNK	64
+
+typedef struct {
+	uint32_t capacity;
+	uint32_t count;
+
+	// Bodies, filled by caller in any order
+	float *x, *y;
+	float *mass;
+
+	// Bodies of last build, in Morton order
+	uint32_t built_count;		// Zero to force next build
+	float *body_x, *body_y;
+	float *body_mass;
+	float *last;				// Inputs of last build as given, x then y then mass
+	uint64_t *keys;				// Morton code << 32 | input index, capacity * 2 with sort buffer
+
+	uint32_t node_count;
+	float *com_x, *com_y;		// Center of mass
+	float *node_mass;
+	float *size2;				// Side length of node's cell, squared
+	uint32_t *next;				// Node after subtree, node_count for the last
+	uint32_t *first;			// Leaves, first body
+	uint32_t *leaf_count;		// Leaves, body count. 0 for internal nodes
+
+	float theta;				// Opening angle, tunable between builds and evaluations
+} GravityTree;
+
+// Points pulled by a tree, stored as parallel arrays. Filled by the entity handler, solved, then written back
+typedef struct {
+	uint32_t capacity;
+	uint32_t count;
+
+	uint32_t *ids;				// Entity id of each point
+	float *x, *y;				// Inputs, entity center
+	float *ax, *ay;				// Outputs, acceleration
+} GravityBatch;
+
+void GravityTreeInit(GravityTree *tree);
+void GravityTreeClose(GravityTree *tree);
+
+// Make room for at least capacity bodies, tree contents are lost if it grows. Returns false if out of memory
+bool GravityTreeReserve(GravityTree *tree, uint32_t capacity);
+
+// Sort bodies and build nodes over them, nothing is done if bodies are bit for bit the ones of last build.
+// Returns true if tree was rebuilt
+bool GravityTreeBuild(GravityTree *tree);
+
+// Acceleration at position from bodies of last build
+Vector2 GravityAccel(const GravityTree *tree, Vector2 position);
+
+// Acceleration at position summed over every body of last build, reference for the tree walk
+Vector2 GravityAccelDirect(const GravityTree *tree, Vector2 position);
+
+void GravityBatchInit(GravityBatch *batch);
+void GravityBatchClose(GravityBatch *batch);
+
+// Make room for at least capacity points, batch contents are lost if it grows. Returns false if out of memory
+bool GravityBatchReserve(GravityBatch *batch, uint32_t capacity);
+
+// Evaluate every point in batch against tree, split over jobs (NULL to run on calling thread)
+void GravityBatchSolve(GravityBatch *batch, const GravityTree *tree, JobSystem *jobs);
+
+#endif // !GRAVITY_H_
@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <math.h>
+#include <sys/stat.h>
+#include "raylib.h"
+#include "game.h"
+#include "headless.h"
+#include "ent_handler.h"
+#include "kmath.h"
+#include "snapshot.h"
+#include "clock.h"
+#include "profiler.h"
+#include "field_gen.h"
+
+// Ticks run between snapshots of the round trip check
+#define HEADLESS_SNAPSHOT_TICKS	60
+
+// Streamed runs circle the stream center around the player, far enough that chunks are stored and come back each lap
+#define HEADLESS_TOUR_RADIUS	(3 * WORLD_CHUNK_SIZE)
+#define HEADLESS_TOUR_TICKS		480
+
+// Scripted stand in for device input:
+// hold a random move direction and jump state for a random number of ticks
+static void HeadlessInput(InputState *state, uint32_t *rng, uint32_t *hold_ticks) {
+	if(*hold_ticks > 0) {
+		(*hold_ticks)--;
+		return;
+	}
+
+	state->move_x = (int)(RandNext(rng) % 3) - 1;
+	state->jump = (RandNext(rng) % 4) == 0;
+	state->shoot = (RandNext(rng) % 3) == 0;
+
+	*hold_ticks = 15 + RandNext(rng) % 90;
+}
+
+static void PrintPhase(char *name, uint64_t ns, uint32_t ticks) {
+	printf("%-12s %10.3f ms %10.3f us/tick\n", name, ns * 1e-6, (ticks) ? (ns * 1e-3) / ticks : 0.0);
+}
+
+// Offset only depends on tick index, so replays of toured runs stream the same chunks.
+// Recordings without the tour (windowed play) keep the stream centered on the player
+static void HeadlessTour(Game *game, bool tour, uint32_t tick) {
+	if(!tour) return;
+
+	float a = (float)(tick % HEADLESS_TOUR_TICKS) / HEADLESS_TOUR_TICKS * 2 * PI;
+	game->stream_offset = (Vector2){ (cosf(a) - 1) * HEADLESS_TOUR_RADIUS, sinf(a) * HEADLESS_TOUR_RADIUS };
+}
+
+// Run ticks starting at tick index first
+static void RunTicks(Game *game, bool tour, uint32_t first, uint32_t ticks, float dt) {
+	for(uint32_t i = 0; i < ticks; i++) {
+		HeadlessTour(game, tour, first + i);
+		GameStep(game, dt);
+	}
+}
+
+// Save world to a full snapshot, run on and save a delta against it, then load both back:
+// each load must reproduce the saved state hash, and ticking on from it must match the original run.
+// Returns false on any mismatch
+static bool HeadlessSnapshotCheck(Game *game, const char *path, bool tour, uint32_t tick, float dt) {
+	EntHandler *handler = &game->ent_handler;
+	Snapshot base = {0}, next = {0}, loaded = {0}, full = {0};
+	bool ok = true;
+
+	char delta_path[512];
+	snprintf(delta_path, sizeof(delta_path), "%s.delta", path);
+
+	uint64_t t0 = ClockNowNs();
+	ok &= SnapshotSave(handler, &base);
+	uint64_t save_ns = ClockNowNs() - t0;
+
+	t0 = ClockNowNs();
+	ok &= SnapshotWrite(&base, NULL, path);
+	uint64_t write_ns = ClockNowNs() - t0;
+
+	uint32_t base_hash = EntHandlerHash(handler);
+	RunTicks(game, tour, tick, HEADLESS_SNAPSHOT_TICKS, dt);
+	uint32_t next_hash = EntHandlerHash(handler);
+
+	ok &= SnapshotSave(handler, &next);
+	t0 = ClockNowNs();
+	ok &= SnapshotWrite(&next, &base, delta_path);
+	uint64_t delta_ns = ClockNowNs() - t0;
+
+	// Move world on so loading has something to replace
+	RunTicks(game, tour, tick + HEADLESS_SNAPSHOT_TICKS, HEADLESS_SNAPSHOT_TICKS, dt);
+
+	t0 = ClockNowNs();
+	ok &= SnapshotRead(&full, NULL, path);
+	uint64_t read_ns = ClockNowNs() - t0;
+
+	t0 = ClockNowNs();
+	ok &= SnapshotRestore(handler, full.data, full.size);
+	uint64_t restore_ns = ClockNowNs() - t0;
+
+	uint32_t hash = EntHandlerHash(handler);
+	if(hash != base_hash) {
+		printf("snapshot MISMATCH after load: hash %08x, saved %08x\n", hash, base_hash);
+		ok = false;
+	}
+
+	RunTicks(game, tour, tick, HEADLESS_SNAPSHOT_TICKS, dt);
+	hash = EntHandlerHash(handler);
+	if(hash != next_hash) {
+		printf("snapshot MISMATCH ticking on from load: hash %08x, original %08x\n", hash, next_hash);
+		ok = false;
+	}
+
+	// Delta decodes against the full snapshot read back from disk
+	ok &= SnapshotRead(&loaded, &full, delta_path) && SnapshotRestore(handler, loaded.data, loaded.size);
+	hash = EntHandlerHash(handler);
+	if(hash != next_hash) {
+		printf("snapshot MISMATCH after delta load: hash %08x, saved %08x\n", hash, next_hash);
+		ok = false;
+	}
+
+	struct stat st;
+	long delta_size = (stat(delta_path, &st) == 0) ? (long)st.st_size : -1;
+
+	printf("snapshot: %u entities, %.1f KiB, delta %.1f KiB\n", handler->count, base.size / 1024.0, delta_size / 1024.0);
+	printf("snapshot save %.3f ms, write %.3f ms, delta write %.3f ms, read %.3f ms, restore %.3f ms\n",
+		save_ns * 1e-6, write_ns * 1e-6, delta_ns * 1e-6, read_ns * 1e-6, restore_ns * 1e-6);
+	printf("snapshot round trip %s\n", (ok) ? "matched" : "FAILED");
+
+	SnapshotFree(&base);
+	SnapshotFree(&next);
+	SnapshotFree(&loaded);
+	SnapshotFree(&full);
+
+	return ok;
+}
+
+int HeadlessRun(Game *game, HeadlessOptions *opts) {
+	game->flags |= GAME_HEADLESS;
+
+	Replay *replay = &game->replay;
+	uint32_t seed = opts->seed;
+	uint32_t bodies = (opts->bodies) ? opts->bodies : HEADLESS_DEFAULT_BODIES;
+	bool world = opts->world;
+	bool tour = world;
+
+	// Replays rebuild the recorded scene and take input from the log
+	if(opts->replay_path) {
+		if(!ReplayPlayStart(replay, opts->replay_path)) return 1;
+
+		seed = replay->header.seed;
+		bodies = replay->header.bodies;
+		world = (replay->header.flags & REPLAY_WORLD_STREAM);
+		tour = (replay->header.flags & REPLAY_STREAM_TOUR);
+		game->input_state.replay = replay;
+	}
+
+	if(world) {
+		game->flags |= GAME_WORLD_STREAM;
+		game->world.seed = (seed) ? seed : WORLD_DEFAULT_SEED;
+	}
+
+	// Load frame layouts only, then start gameplay as normal
+	GameContentInit(game);
+	MainStart(game);
+
+	// Xorshift state can't be zero
+	uint32_t rng = (seed) ? seed : 0x9e3779b9;
+
+	EntHandler *handler = &game->ent_handler;
+
+	// Poisson-disk field around the start scene, storage is reserved for all bodies at once.
+	// Streamed runs get their bodies from world chunks instead
+	if(!world) {
+		uint64_t field_start = ClockNowNs();
+		uint32_t spawned = FieldSpawnAsteroids(handler, &game->jobs, rng, bodies);
+		printf("field: %u bodies in %.3f ms\n", spawned, (ClockNowNs() - field_start) * 1e-6);
+	}
+
+	EntTimings timings = {0};
+	handler->timings = &timings;
+
+	float dt = 1.0f / game->conf.tickRate;
+	uint32_t hold_ticks = 0;
+	uint64_t input_ns = 0, hash_ns = 0;
+
+	// Every tick is logged by GameStep once recording
+	if(opts->record_path && !opts->replay_path) {
+		ReplayHeader header = { .seed = seed, .bodies = bodies, .flags = (world) ? REPLAY_WORLD_STREAM | REPLAY_STREAM_TOUR : 0, .tick_rate = game->conf.tickRate };
+		ReplayRecordStart(replay, opts->record_path, header);
+	}
+
+	bool playing = (replay->mode == REPLAY_PLAY);
+	printf("headless: %u ticks, seed %u, %u entities, dt %f\n", (playing) ? replay->header.tick_count : opts->ticks, seed, handler->count, dt);
+	printf("entity storage: %u slots, %.1f KiB\n", handler->capacity, EntHandlerBytes(handler) / 1024.0);
+
+	uint64_t start = ClockNowNs();
+	uint32_t ticks = 0;
+
+	for(;; ticks++) {
+		uint64_t t0 = ClockNowNs();
+
+		if(playing) {
+			if(!ReplayNextTick(replay)) break;
+
+			dt = replay->current.dt;
+			ProcessInput(&game->input_state, dt);
+		} else {
+			if(ticks >= opts->ticks) break;
+			HeadlessInput(&game->input_state, &rng, &hold_ticks);
+		}
+
+		input_ns += ClockNowNs() - t0;
+
+		HeadlessTour(game, tour, ticks);
+		GameStep(game, dt);
+
+		// State hash after each tick must match recording
+		if(playing) {
+			t0 = ClockNowNs();
+			ReplayCheckTick(replay, EntHandlerHash(handler));
+			hash_ns += ClockNowNs() - t0;
+		}
+
+		PROF_FRAME();
+	}
+
+	uint64_t total_ns = ClockNowNs() - start;
+	handler->timings = NULL;
+
+	if(world) printf("world: %u chunks resident, %u changed chunks stored in %.1f KiB\n", 
+		game->world.resident_count, game->world.record_count, game->world.record_bytes / 1024.0);
+
+	ProjectileStats *pstats = &game->projectiles.stats;
+	printf("projectiles: %u fired, %u live, %u dropped\n", pstats->fired, pstats->live, pstats->dropped);
+
+	PrintPhase("input", input_ns, ticks);
+	PrintPhase("orbit", timings.orbit_ns, ticks);
+	PrintPhase("gravity", timings.gravity_ns, ticks);
+	PrintPhase("update", timings.update_ns, ticks);
+	PrintPhase("find_orbit", timings.find_orbit_ns, ticks);
+	if(playing) PrintPhase("replay_hash", hash_ns, ticks);
+	PrintPhase("total", total_ns, ticks);
+	printf("%.1f ticks/sec\n", (total_ns) ? ticks / (total_ns * 1e-9) : 0.0);
+
+	bool diverged = (playing && replay->mismatches > 0);
+
+	// Check ticks aren't part of the run, recording ends first
+	if(opts->snapshot_path) {
+		ReplayClose(replay);
+		if(!HeadlessSnapshotCheck(game, opts->snapshot_path, tour, ticks, dt)) diverged = true;
+	}
+
+	GameClose(game);
+
+	return (diverged) ? 1 : 0;
+}
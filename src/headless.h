@@ -0,0 +1,26 @@
+#ifndef HEADLESS_H_
+#define HEADLESS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "game.h"
+
+// Asteroids spawned when no count is given
+#define HEADLESS_DEFAULT_BODIES	500
+
+typedef struct {
+	uint32_t ticks;			// Number of simulation ticks to run
+	uint32_t seed;			// Seed for asteroid field and scripted input
+	uint32_t bodies;		// Number of asteroids to spawn, 0 for HEADLESS_DEFAULT_BODIES. Unused when world streams
+	bool world;				// Stream asteroid field as windowed play does, seeded with seed, center circles the player
+
+	const char *record_path;	// Log every tick to this replay file, NULL for none
+	const char *replay_path;	// Play this replay instead of scripted input, scene and tick count come from it
+	const char *snapshot_path;	// Round trip world through snapshot files at this path after the run, NULL to skip
+} HeadlessOptions;
+
+// Run simulation without window, GL context or textures,
+// prints per phase timings on exit, returns process exit code (1 if a replay diverged or a snapshot round trip failed)
+int HeadlessRun(Game *game, HeadlessOptions *opts);
+
+#endif // !HEADLESS_H_
@@ -1,7 +1,14 @@
 #include "raylib.h"
 #include "input.h"
+#include "replay.h"
 
 void ProcessInput(InputState *state, float delta_time) {
+	// Replayed input, devices are ignored
+	if(state->replay && state->replay->mode == REPLAY_PLAY) {
+		ReplayApplyInput(state->replay, state);
+		return;
+	}
+
 	// Poll input
 	if(IsGamepadAvailable(0))
 		PollInputGamepad(state);
@@ -22,6 +29,7 @@ void PollInputKeyboard(InputState *state) {
 	if(IsKeyDown(KEY_S)) state->move_y =  1;
 
 	state->jump = IsKeyDown(KEY_SPACE);
+	state->shoot = IsKeyDown(KEY_J);
 }
 
 void PollInputGamepad(InputState *state) {
@@ -28,8 +28,11 @@ typedef struct {
 	float shoot_timer;
 	float interact_timer;
 	float pause_timer;
+
+	struct Replay *replay;		// Playing replay to read input from instead of devices, NULL to poll
 } InputState;
 
+// Poll devices into state, or take the current tick of a playing replay
 void ProcessInput(InputState *state, float delta_time);
 void PollInputGamepad(InputState *state);
 void PollInputKeyboard(InputState *state);
@@ -0,0 +1,163 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sched.h>
+#include "jobs.h"
+
+// Push job to tail of worker's deque, false if full
+static bool JobPush(JobWorker *w, Job job) {
+	pthread_mutex_lock(&w->lock);
+
+	bool pushed = (w->tail - w->head < JOB_DEQUE_CAP);
+	if(pushed) w->jobs[w->tail++ & (JOB_DEQUE_CAP - 1)] = job;
+
+	pthread_mutex_unlock(&w->lock);
+	return pushed;
+}
+
+// Owner takes newest job, thieves take oldest
+static bool JobPop(JobWorker *w, Job *job, bool steal) {
+	pthread_mutex_lock(&w->lock);
+
+	bool found = (w->tail != w->head);
+	if(found) *job = (steal) ? w->jobs[w->head++ & (JOB_DEQUE_CAP - 1)] : w->jobs[--w->tail & (JOB_DEQUE_CAP - 1)];
+
+	pthread_mutex_unlock(&w->lock);
+	return found;
+}
+
+// Get a job from own deque, or steal one from another worker
+static bool JobTake(JobSystem *js, int self, Job *job) {
+	if(JobPop(&js->workers[self], job, false)) goto found;
+
+	for(int i = 1; i < js->thread_count; i++) {
+		int victim = (self + i) % js->thread_count;
+		if(JobPop(&js->workers[victim], job, true)) goto found;
+	}
+
+	return false;
+
+	found:
+	__atomic_sub_fetch(&js->queued, 1, __ATOMIC_ACQ_REL);
+	return true;
+}
+
+static void JobRun(Job *job) {
+	job->func(job->ctx, job->begin, job->end);
+	__atomic_sub_fetch(job->pending, 1, __ATOMIC_RELEASE);
+}
+
+static void *JobWorkerLoop(void *arg) {
+	JobWorker *w = arg;
+	JobSystem *js = w->js;
+	pthread_setspecific(js->worker_key, (void*)(intptr_t)w->index);
+
+	Job job;
+	while(__atomic_load_n(&js->running, __ATOMIC_ACQUIRE)) {
+		if(JobTake(js, w->index, &job)) {
+			JobRun(&job);
+			continue;
+		}
+
+		// Nothing to do, sleep until more jobs are queued
+		pthread_mutex_lock(&js->sleep_lock);
+		while(js->running && __atomic_load_n(&js->queued, __ATOMIC_ACQUIRE) == 0)
+			pthread_cond_wait(&js->wake, &js->sleep_lock);
+		pthread_mutex_unlock(&js->sleep_lock);
+	}
+
+	return NULL;
+}
+
+void JobSystemInit(JobSystem *js, int thread_count) {
+	if(thread_count < 1) thread_count = 1;
+	if(thread_count > JOB_MAX_THREADS) thread_count = JOB_MAX_THREADS;
+
+	js->thread_count = thread_count;
+	js->running = true;
+	js->queued = 0;
+
+	pthread_key_create(&js->worker_key, NULL);
+	pthread_mutex_init(&js->sleep_lock, NULL);
+	pthread_cond_init(&js->wake, NULL);
+
+	for(int i = 0; i < thread_count; i++) {
+		JobWorker *w = &js->workers[i];
+		w->js = js;
+		w->index = i;
+		w->head = w->tail = 0;
+		pthread_mutex_init(&w->lock, NULL);
+	}
+
+	// Worker 0 is the main thread, start the others
+	for(int i = 1; i < thread_count; i++) {
+		if(pthread_create(&js->workers[i].thread, NULL, JobWorkerLoop, &js->workers[i]) != 0) {
+			printf("ERROR: Could not start job worker %d, running with %d threads\n", i, i);
+			js->thread_count = i;
+			break;
+		}
+	}
+
+	printf("job system started with %d threads\n", js->thread_count);
+}
+
+void JobSystemClose(JobSystem *js) {
+	pthread_mutex_lock(&js->sleep_lock);
+	__atomic_store_n(&js->running, false, __ATOMIC_RELEASE);
+	pthread_cond_broadcast(&js->wake);
+	pthread_mutex_unlock(&js->sleep_lock);
+
+	for(int i = 1; i < js->thread_count; i++) pthread_join(js->workers[i].thread, NULL);
+	for(int i = 0; i < js->thread_count; i++) pthread_mutex_destroy(&js->workers[i].lock);
+
+	pthread_cond_destroy(&js->wake);
+	pthread_mutex_destroy(&js->sleep_lock);
+	pthread_key_delete(js->worker_key);
+
+	js->thread_count = 0;
+}
+
+void JobParallelFor(JobSystem *js, JobFunc func, void *ctx, uint32_t count, uint32_t per_job) {
+	if(count == 0) return;
+	if(per_job == 0) per_job = 1;
+
+	// Single thread, run the same jobs in order
+	if(!js || js->thread_count <= 1) {
+		for(uint32_t begin = 0; begin < count; begin += per_job) 
+			func(ctx, begin, (begin + per_job < count) ? begin + per_job : count);
+		return;
+	}
+
+	uint32_t job_count = (count + per_job - 1) / per_job;
+	uint32_t pending = job_count;
+
+	// Spread jobs over all deques, workers steal from each other once their own is empty
+	for(uint32_t j = 0; j < job_count; j++) {
+		uint32_t begin = j * per_job;
+		Job job = { func, ctx, begin, (begin + per_job < count) ? begin + per_job : count, &pending };
+
+		__atomic_add_fetch(&js->queued, 1, __ATOMIC_ACQ_REL);
+		if(!JobPush(&js->workers[j % js->thread_count], job)) {
+			// Deque full, run it here instead
+			__atomic_sub_fetch(&js->queued, 1, __ATOMIC_ACQ_REL);
+			JobRun(&job);
+		}
+	}
+
+	pthread_mutex_lock(&js->sleep_lock);
+	pthread_cond_broadcast(&js->wake);
+	pthread_mutex_unlock(&js->sleep_lock);
+
+	// Main thread works too, until every job has finished
+	Job job;
+	while(__atomic_load_n(&pending, __ATOMIC_ACQUIRE) > 0) {
+		if(JobTake(js, 0, &job)) JobRun(&job);
+		else sched_yield();
+	}
+}
+
+int JobWorkerIndex(JobSystem *js) {
+	if(!js) return 0;
+	return (int)(intptr_t)pthread_getspecific(js->worker_key);
+}
@@ -0,0 +1,61 @@
+#ifndef JOBS_H_
+#define JOBS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+// Most threads a job system can run, main thread included
+#define JOB_MAX_THREADS		16
+
+// Jobs each worker deque can hold, must be a power of 2
+#define JOB_DEQUE_CAP		256
+
+// Job function, called with a range of work item indices [begin, end)
+typedef void (*JobFunc)(void *ctx, uint32_t begin, uint32_t end);
+
+typedef struct {
+	JobFunc func;
+	void *ctx;
+	uint32_t begin, end;
+	uint32_t *pending;			// Decremented once job is done
+} Job;
+
+// Worker with it's own double ended job queue, owner pushes and pops at the tail,
+// other workers steal from the head
+typedef struct {
+	struct JobSystem *js;
+	int index;
+	pthread_t thread;					// Unused for worker 0, the main thread
+
+	pthread_mutex_t lock;
+	uint32_t head, tail;
+	Job jobs[JOB_DEQUE_CAP];
+} JobWorker;
+
+typedef struct JobSystem {
+	int thread_count;					// Worker threads plus main thread
+	bool running;
+
+	JobWorker workers[JOB_MAX_THREADS];
+	pthread_key_t worker_key;
+
+	// Idle workers sleep until jobs are queued
+	pthread_mutex_t sleep_lock;
+	pthread_cond_t wake;
+	uint32_t queued;
+} JobSystem;
+
+// Start job system with provided thread count (main thread included),
+// a count of 1 runs every job on the calling thread
+void JobSystemInit(JobSystem *js, int thread_count);
+void JobSystemClose(JobSystem *js);
+
+// Split count items into jobs of up to per_job items, run them on all threads,
+// returns once every job is done. Safe to call with js NULL (runs serially)
+void JobParallelFor(JobSystem *js, JobFunc func, void *ctx, uint32_t count, uint32_t per_job);
+
+// Index of calling worker, 0 for main thread or when js is NULL
+int JobWorkerIndex(JobSystem *js);
+
+#endif // !JOBS_H_
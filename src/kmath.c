@@ -13,6 +13,60 @@ float AngleLerp(float a, float b, float t) {
 	return a + (d * t);
 }
 
+float AngleInterp(float a, float b, float t) {
+	float d = b - a;
+
+	while(d >  180) d -= 360;
+	while(d < -180) d += 360;
+
+	return a + (d * t);
+}
+
 float ILerp(float a, float b, float t, float delta_time) {
 	return 1 - Lerp(a, b, pow(t, delta_time));
 }
+
+Rectangle CameraViewRect(Camera2D *camera, Vector2 view_size) {
+	// Transform view corners to world space, handles rotation and zoom
+	Vector2 corners[4] = {
+		GetScreenToWorld2D((Vector2){0, 0}, *camera),
+		GetScreenToWorld2D((Vector2){view_size.x, 0}, *camera),
+		GetScreenToWorld2D((Vector2){0, view_size.y}, *camera),
+		GetScreenToWorld2D(view_size, *camera)
+	};
+
+	Vector2 min = corners[0], max = corners[0];
+	for(int i = 1; i < 4; i++) {
+		min = Vector2Min(min, corners[i]);
+		max = Vector2Max(max, corners[i]);
+	}
+
+	return (Rectangle){ min.x, min.y, max.x - min.x, max.y - min.y };
+}
+
+uint32_t RandNext(uint32_t *state) {
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+
+	return *state = x;
+}
+
+// Random float in range [min, max)
+float RandRange(uint32_t *state, float min, float max) {
+	return min + (RandNext(state) >> 8) * (1.0f / 16777216.0f) * (max - min);
+}
+
+// Cell coordinates mixed into seed with a 32 bit finalizer
+uint32_t RandCellSeed(uint32_t seed, int32_t x, int32_t y) {
+	uint32_t h = seed ^ ((uint32_t)x * 0x9E3779B1u) ^ ((uint32_t)y * 0x85EBCA77u);
+	h ^= h >> 16;
+	h *= 0x7FEB352Du;
+	h ^= h >> 15;
+	h *= 0x846CA68Bu;
+	h ^= h >> 16;
+
+	// Xorshift state can't be zero
+	return (h) ? h : 0x9e3779b9;
+}
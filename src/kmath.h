@@ -1,9 +1,25 @@
 #ifndef KMATH_H_
 #define KMATH_H_
 
+#include <stdint.h>
+#include "raylib.h"
+
 #define PI2 (PI*2)
 
 float AngleLerp(float a, float b, float t);
 float ILerp(float a, float b, float t, float delta_time);
 
+// Interpolate between angles in degrees, along the shortest arc
+float AngleInterp(float a, float b, float t);
+
+// World space bounds of what a camera sees, for a view of provided size in pixels
+Rectangle CameraViewRect(Camera2D *camera, Vector2 view_size);
+
+// Seeded pseudo random numbers (xorshift32), state must be non-zero
+uint32_t RandNext(uint32_t *state);
+float RandRange(uint32_t *state, float min, float max);
+
+// Random state for grid cell x, y of seed, neighbouring cells get unrelated streams. Never zero
+uint32_t RandCellSeed(uint32_t seed, int32_t x, int32_t y);
+
 #endif // KMATH_H_
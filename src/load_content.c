@@ -1,16 +1,84 @@
 #include <stdio.h>
 #include "raylib.h"
 #include "sprites.h"
+#include "content.h"
 
-//typedef void(*SpriteLoadFunc)(Game *game);
-//typedef void(*AudioLoadFunc)(Game *game);
+// Sprite blocks, also what the asset packer bakes into the pack
+SpriteBlock sprite_blocks[SPR_BLOCK_COUNT] = {
+	[SPR_BLOCK_PLAYER] = {
+		.sheet_count = 1,
+		.sheets = { { "resources/player_sheet.png", 64, 64 } },
 
-void LoadSpritesAll(SpriteLoader *sl) {
-	puts("loading sprites...");
+		// Run cycle
+		.anim_count = 1,
+		.anims = { { .sheet = 0, .col = 0, .row = 1, .frame_count = 4, .speed = 1 } }
+	},
+
+	[SPR_BLOCK_BODIES] = {
+		.sheet_count = 1,
+		.sheets = { { "resources/asteroid00.png", 128, 128 } }
+	}
+};
+
+// Audio blocks, no sound effects yet
+AudioBlock audio_blocks[AUDIO_BLOCK_COUNT] = {
+	[AUDIO_BLOCK_MAIN] = { .sound_count = 0 }
+};
+
+void ContentBlocksInit(void) {
+	uint8_t sheets = 0, anims = 0, sounds = 0;
 
-	LoadSpritesheet("resources/player_sheet.png", (Vector2){64, 64}, sl);
-	AddSpriteAnim(&sl->spr_pool[0], FrameIndex(&sl->spr_pool[0], 0, 1), 4, 1, sl);
+	for(uint8_t b = 0; b < SPR_BLOCK_COUNT; b++) {
+		sprite_blocks[b].sheet_base = sheets;
+		sprite_blocks[b].anim_base = anims;
+		sheets += sprite_blocks[b].sheet_count;
+		anims += sprite_blocks[b].anim_count;
+	}
 
-	LoadSpritesheet("resources/asteroid00.png", (Vector2){128, 128}, sl);
+	for(uint8_t b = 0; b < AUDIO_BLOCK_COUNT; b++) {
+		audio_blocks[b].sound_base = sounds;
+		sounds += audio_blocks[b].sound_count;
+	}
 }
 
+uint8_t SpriteBlockOfSheet(uint8_t slot) {
+	for(uint8_t b = 0; b < SPR_BLOCK_COUNT; b++) {
+		SpriteBlock *block = &sprite_blocks[b];
+		if(slot >= block->sheet_base && slot < block->sheet_base + block->sheet_count) return b;
+	}
+
+	return SPR_BLOCK_COUNT;
+}
+
+void LoadSpriteBlock(SpriteLoader *sl, uint8_t block_id) {
+	SpriteBlock *block = &sprite_blocks[block_id];
+	uint8_t spr_count = sl->spr_count, anim_count = sl->anim_count;
+
+	// Sheets and animations are pushed onto the pools, point pool tops at block's slots first
+	for(uint8_t i = 0; i < block->sheet_count; i++) {
+		BlockSheet *sheet = &block->sheets[i];
+		sl->spr_count = block->sheet_base + i;
+		LoadSpritesheet((char*)sheet->path, (Vector2){sheet->frame_w, sheet->frame_h}, sl);
+	}
+
+	for(uint8_t i = 0; i < block->anim_count; i++) {
+		BlockAnim *anim = &block->anims[i];
+		Spritesheet *ss = &sl->spr_pool[block->sheet_base + anim->sheet];
+
+		sl->anim_count = block->anim_base + i;
+		AddSpriteAnim(ss, FrameIndex(ss, anim->col, anim->row), anim->frame_count, anim->speed, sl);
+	}
+
+	if(spr_count > sl->spr_count) sl->spr_count = spr_count;
+	if(anim_count > sl->anim_count) sl->anim_count = anim_count;
+
+	// Block fills free space of pages packed before it
+	SpriteLoaderPackAtlas(sl);
+}
+
+void LoadSpritesAll(SpriteLoader *sl) {
+	puts("loading sprites...");
+	ContentBlocksInit();
+
+	for(uint8_t b = 0; b < SPR_BLOCK_COUNT; b++) LoadSpriteBlock(sl, b);
+}
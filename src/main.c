@@ -1,52 +1,121 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "raylib.h"
 #include "game.h"
 #include "config.h"
+#include "headless.h"
+#include "profiler.h"
 
-#define ARG_NONE	0x00
-#define ARG_DEBUG 	0x01
+#define ARG_NONE	 0x00
+#define ARG_DEBUG 	 0x01
+#define ARG_HEADLESS 0x02
+#define ARG_LOOSE_ASSETS 0x04
  
-int main() {
+int main(int argc, char **argv) {
+	// Parse command line arguments
+	uint8_t arg_flags = ARG_NONE;
+	HeadlessOptions headless_opts = { .ticks = 1000, .seed = 1 };
+
+	for(int i = 1; i < argc; i++) {
+		if(streq(argv[i], "--headless")) 
+			arg_flags |= ARG_HEADLESS;
+		else if(streq(argv[i], "--loose-assets")) 
+			arg_flags |= ARG_LOOSE_ASSETS;
+		else if(streq(argv[i], "--ticks") && i + 1 < argc) 
+			headless_opts.ticks = strtoul(argv[++i], NULL, 10);
+		else if(streq(argv[i], "--seed") && i + 1 < argc) 
+			headless_opts.seed = strtoul(argv[++i], NULL, 10);
+		else if(streq(argv[i], "--bodies") && i + 1 < argc) 
+			headless_opts.bodies = strtoul(argv[++i], NULL, 10);
+		else if(streq(argv[i], "--world")) 
+			headless_opts.world = true;
+		else if(streq(argv[i], "--record") && i + 1 < argc) 
+			headless_opts.record_path = argv[++i];
+		else if(streq(argv[i], "--snapshot") && i + 1 < argc) {
+			// Snapshot check runs after a headless run
+			headless_opts.snapshot_path = argv[++i];
+			arg_flags |= ARG_HEADLESS;
+		}
+		else if(streq(argv[i], "--replay") && i + 1 < argc) {
+			// Replays run without a window
+			headless_opts.replay_path = argv[++i];
+			arg_flags |= ARG_HEADLESS;
+		}
+		else 
+			printf("unknown argument: %s\n", argv[i]);
+	}
+
 	SetTraceLogLevel(LOG_ERROR);
+	PROF_INIT();
+
 	// Initialize game
 	// Set window options, instantiate objects, allocate memory, etc.
-	Game game = {0};
-	GameInit(&game);
+	// Game is too large for the stack
+	Game *game = calloc(1, sizeof(Game));
+	if(!game) {
+		puts("ERROR: Could not allocate game state");
+		return 1;
+	}
+
+	if(arg_flags & ARG_LOOSE_ASSETS) game->flags |= GAME_LOOSE_ASSETS;
+	GameInit(game);
+
+	// Run simulation only, no window
+	if(arg_flags & ARG_HEADLESS) {
+		int result = HeadlessRun(game, &headless_opts);
+		PROF_CLOSE(PROF_TRACE_PATH);
+		free(game);
+		return result;
+	}
+
+	// Windowed play takes place in the streamed field
+	game->flags |= GAME_WORLD_STREAM;
+
+	// Log gameplay ticks, replayed with --replay
+	if(headless_opts.record_path) {
+		ReplayHeader header = { .seed = game->world.seed, .flags = REPLAY_WORLD_STREAM, .tick_rate = game->conf.tickRate };
+		ReplayRecordStart(&game->replay, headless_opts.record_path, header);
+	}
 
 	// Open window, use values from config file
 	SetConfigFlags(0);
-	InitWindow(game.conf.windowWidth, game.conf.windowHeight, "Fish Game Demo");
-	SetTargetFPS(game.conf.refreshRate);
+	InitWindow(game->conf.windowWidth, game->conf.windowHeight, "Fish Game Demo");
+	InitAudioDevice();
+	SetTargetFPS(game->conf.refreshRate);
 	
 	// Load empty texture for use as a buffer
 	// Buffer is drawn and scaled to window resolution
-	GameRenderInit(&game);
+	GameRenderInit(game);
 
-	// Load game assets(spritesheets, sound effects, music, etc)
-	GameContentInit(&game);
+	// Start streaming game assets(spritesheets, sound effects, music, etc)
+	GameContentInit(game);
 
 	SetExitKey(KEY_F10);	
 	bool exit = false;
 
 	// Main loop:
 	while(!exit) {
-		exit = (WindowShouldClose() || (game.flags & GAME_QUIT_REQUEST));	
+		PROF_FRAME();
+		exit = (WindowShouldClose() || (game->flags & GAME_QUIT_REQUEST));	
 
 		// Update game logic
-		GameUpdate(&game);
+		GameUpdate(game);
 
-		// Render to buffer
-		GameDrawToBuffer(&game, (SHOW_DEBUG));
-
-		// Render to screen
-		GameDrawToWindow(&game);
+		// Render to buffer at current resolution scale and then to screen,
+		// or straight to screen if window matches virtual resolution
+		GameDraw(game, (SHOW_DEBUG));
 	}
 
 	// Cleanup:
 	// Free allocated memory, close application
-	GameClose(&game);
+	GameClose(game);
+	CloseAudioDevice();
 	CloseWindow();
 
+	// Worker threads are joined by now, safe to read their zones
+	PROF_CLOSE(PROF_TRACE_PATH);
+	free(game);
+
 	return 0;
 }
-
@@ -0,0 +1,208 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "raylib.h"
+#include "kmath.h"
+#include "orbit.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Sine/cosine approximation constants (cephes minimax polynomials on [-pi/4, pi/4]),
+// pi/2 split in three parts so range reduction stays exact for large angles
+#define SC_2_OVER_PI	0.63661977236758134f
+#define SC_DP1			1.5703125f
+#define SC_DP2			4.837512969970703125e-4f
+#define SC_DP3			7.54978995489188216e-8f
+#define SC_S0			-1.6666654611e-1f
+#define SC_S1			8.3321608736e-3f
+#define SC_S2			-1.9515295891e-4f
+#define SC_C0			4.166664568298827e-2f
+#define SC_C1			-1.388731625493765e-3f
+#define SC_C2			2.443315711809948e-5f
+
+bool OrbitBatchInit(OrbitBatch *batch, uint32_t capacity) {
+	*batch = (OrbitBatch){0};
+	return OrbitBatchReserve(batch, capacity);
+}
+
+void OrbitBatchClose(OrbitBatch *batch) {
+	free(batch->ids);
+	free(batch->grounded);
+	free(batch->angle);
+	*batch = (OrbitBatch){0};
+}
+
+// Batch is refilled every update, so old contents are dropped instead of copied
+bool OrbitBatchReserve(OrbitBatch *batch, uint32_t capacity) {
+	if(capacity <= batch->capacity) return true;
+	OrbitBatchClose(batch);
+
+	// Round up so the kernel never needs a scalar tail
+	capacity = (capacity + ORBIT_LANES - 1) & ~(uint32_t)(ORBIT_LANES - 1);
+
+	// Float arrays share one allocation
+	float **fields[] = {
+		&batch->angle, &batch->height, &batch->angular_vel,
+		&batch->body_x, &batch->body_y, &batch->body_radius, &batch->ent_radius,
+		&batch->dir_x, &batch->dir_y, &batch->center_x, &batch->center_y,
+		&batch->edge_x, &batch->edge_y, &batch->target_angle
+	};
+	uint32_t field_count = sizeof(fields) / sizeof(fields[0]);
+
+	uint32_t *ids = calloc(capacity, sizeof(uint32_t));
+	uint8_t *grounded = calloc(capacity, sizeof(uint8_t));
+	float *block = calloc((size_t)capacity * field_count, sizeof(float));
+
+	if(!ids || !grounded || !block) {
+		free(ids);
+		free(grounded);
+		free(block);
+		return false;
+	}
+
+	batch->capacity = capacity;
+	batch->ids = ids;
+	batch->grounded = grounded;
+	for(uint32_t i = 0; i < field_count; i++) *fields[i] = block + (size_t)i * capacity;
+
+	return true;
+}
+
+void OrbitSinCos(float x, float *s, float *c) {
+	// Reduce to [-pi/4, pi/4] and quadrant
+	float k = (float)lrintf(x * SC_2_OVER_PI);
+	int32_t q = (int32_t)k;
+
+	float r = ((x - k * SC_DP1) - k * SC_DP2) - k * SC_DP3;
+	float r2 = r * r;
+
+	float ps = r + r * r2 * (SC_S0 + r2 * (SC_S1 + r2 * SC_S2));
+	float pc = (1.0f - 0.5f * r2) + r2 * r2 * (SC_C0 + r2 * (SC_C1 + r2 * SC_C2));
+
+	// Odd quadrants swap sine and cosine, then fix signs
+	float sv = (q & 1) ? pc : ps;
+	float cv = (q & 1) ? ps : pc;
+	if(q & 2) sv = -sv;
+	if((q + 1) & 2) cv = -cv;
+
+	*s = sv;
+	*c = cv;
+}
+
+void OrbitBatchSolveScalar(OrbitBatch *batch, float dt) {
+	uint32_t n = (batch->count + ORBIT_LANES - 1) & ~(uint32_t)(ORBIT_LANES - 1);
+
+	for(uint32_t i = 0; i < n; i++) {
+		float angle = batch->angle[i] + batch->angular_vel[i] * dt;
+
+		float s, c;
+		OrbitSinCos(angle, &s, &c);
+
+		// Place orbiter above body surface, height is applied before grounding clamps it
+		float dist = batch->body_radius[i] + batch->height[i];
+		batch->center_x[i] = batch->body_x[i] + c * dist;
+		batch->center_y[i] = batch->body_y[i] + s * dist;
+		batch->edge_x[i] = batch->body_x[i] + c * batch->body_radius[i];
+		batch->edge_y[i] = batch->body_y[i] + s * batch->body_radius[i];
+		batch->dir_x[i] = c;
+		batch->dir_y[i] = s;
+
+		// Tangent (-dir.y, dir.x) points 90 degrees ahead of dir
+		batch->target_angle[i] = angle * RAD2DEG + 90.0f;
+
+		batch->grounded[i] = (batch->height[i] <= batch->ent_radius[i]);
+		if(batch->grounded[i]) batch->height[i] = batch->ent_radius[i];
+
+		// Limit orbit angle
+		if(angle > PI2) angle -= PI2;
+		else if(angle < 0) angle += PI2;
+		batch->angle[i] = angle;
+	}
+}
+
+#ifdef __SSE2__
+static inline __m128 SinCos4(__m128 x, __m128 *cos_out) {
+	__m128 k = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(SC_2_OVER_PI))));
+	__m128i q = _mm_cvtps_epi32(k);
+
+	__m128 r = _mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(SC_DP1)));
+	r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(SC_DP2)));
+	r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(SC_DP3)));
+	__m128 r2 = _mm_mul_ps(r, r);
+
+	__m128 ps = _mm_add_ps(_mm_set1_ps(SC_S1), _mm_mul_ps(r2, _mm_set1_ps(SC_S2)));
+	ps = _mm_add_ps(_mm_set1_ps(SC_S0), _mm_mul_ps(r2, ps));
+	ps = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), ps));
+
+	__m128 pc = _mm_add_ps(_mm_set1_ps(SC_C1), _mm_mul_ps(r2, _mm_set1_ps(SC_C2)));
+	pc = _mm_add_ps(_mm_set1_ps(SC_C0), _mm_mul_ps(r2, pc));
+	pc = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), r2)), _mm_mul_ps(_mm_mul_ps(r2, r2), pc));
+
+	// Odd quadrants swap sine and cosine, then fix signs
+	__m128i one = _mm_set1_epi32(1), two = _mm_set1_epi32(2);
+	__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+	__m128 sv = _mm_or_ps(_mm_and_ps(swap, pc), _mm_andnot_ps(swap, ps));
+	__m128 cv = _mm_or_ps(_mm_and_ps(swap, ps), _mm_andnot_ps(swap, pc));
+
+	__m128 sign_s = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, two), 30));
+	__m128 sign_c = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, one), two), 30));
+
+	*cos_out = _mm_xor_ps(cv, sign_c);
+	return _mm_xor_ps(sv, sign_s);
+}
+
+void OrbitBatchSolve(OrbitBatch *batch, float dt) {
+	uint32_t n = (batch->count + ORBIT_LANES - 1) & ~(uint32_t)(ORBIT_LANES - 1);
+
+	__m128 v_dt = _mm_set1_ps(dt);
+	__m128 v_pi2 = _mm_set1_ps(PI2);
+	__m128 v_zero = _mm_setzero_ps();
+	__m128 v_rad2deg = _mm_set1_ps(RAD2DEG);
+	__m128 v_quarter = _mm_set1_ps(90.0f);
+
+	for(uint32_t i = 0; i < n; i += ORBIT_LANES) {
+		__m128 angle = _mm_add_ps(_mm_loadu_ps(&batch->angle[i]), _mm_mul_ps(_mm_loadu_ps(&batch->angular_vel[i]), v_dt));
+
+		__m128 c;
+		__m128 s = SinCos4(angle, &c);
+
+		__m128 body_x = _mm_loadu_ps(&batch->body_x[i]);
+		__m128 body_y = _mm_loadu_ps(&batch->body_y[i]);
+		__m128 body_r = _mm_loadu_ps(&batch->body_radius[i]);
+		__m128 height = _mm_loadu_ps(&batch->height[i]);
+		__m128 ent_r = _mm_loadu_ps(&batch->ent_radius[i]);
+
+		// Place orbiter above body surface, height is applied before grounding clamps it
+		__m128 dist = _mm_add_ps(body_r, height);
+		_mm_storeu_ps(&batch->center_x[i], _mm_add_ps(body_x, _mm_mul_ps(c, dist)));
+		_mm_storeu_ps(&batch->center_y[i], _mm_add_ps(body_y, _mm_mul_ps(s, dist)));
+		_mm_storeu_ps(&batch->edge_x[i], _mm_add_ps(body_x, _mm_mul_ps(c, body_r)));
+		_mm_storeu_ps(&batch->edge_y[i], _mm_add_ps(body_y, _mm_mul_ps(s, body_r)));
+		_mm_storeu_ps(&batch->dir_x[i], c);
+		_mm_storeu_ps(&batch->dir_y[i], s);
+
+		// Tangent (-dir.y, dir.x) points 90 degrees ahead of dir
+		_mm_storeu_ps(&batch->target_angle[i], _mm_add_ps(_mm_mul_ps(angle, v_rad2deg), v_quarter));
+
+		__m128 ground = _mm_cmple_ps(height, ent_r);
+		height = _mm_or_ps(_mm_and_ps(ground, ent_r), _mm_andnot_ps(ground, height));
+		_mm_storeu_ps(&batch->height[i], height);
+
+		int mask = _mm_movemask_ps(ground);
+		for(int l = 0; l < ORBIT_LANES; l++) batch->grounded[i + l] = (mask >> l) & 1;
+
+		// Limit orbit angle, both masks can't be set at once
+		__m128 over = _mm_cmpgt_ps(angle, v_pi2);
+		__m128 under = _mm_cmplt_ps(angle, v_zero);
+		angle = _mm_sub_ps(angle, _mm_and_ps(over, v_pi2));
+		angle = _mm_add_ps(angle, _mm_and_ps(under, v_pi2));
+		_mm_storeu_ps(&batch->angle[i], angle);
+	}
+}
+#else
+void OrbitBatchSolve(OrbitBatch *batch, float dt) {
+	OrbitBatchSolveScalar(batch, dt);
+}
+#endif
@@ -0,0 +1,52 @@
+#ifndef ORBIT_H_
+#define ORBIT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Orbiters processed together by the vector kernel, capacity is padded to a multiple of this
+#define ORBIT_LANES	4
+
+// All orbiting entities of a tick, stored as parallel arrays so the kernel
+// can work on several orbiters at once. Filled by the entity handler,
+// solved, then written back to each entity's OrbitData
+typedef struct {
+	uint32_t capacity;
+	uint32_t count;
+
+	uint32_t *ids;				// Entity id of each orbiter
+
+	// Inputs, angle and height are also outputs
+	float *angle;				// Angle around orbited body in radians
+	float *height;				// Distance from orbited body's surface
+	float *angular_vel;			// Radians per second added to angle before solving
+	float *body_x, *body_y;		// Orbited body center
+	float *body_radius;
+	float *ent_radius;
+
+	// Outputs
+	float *dir_x, *dir_y;			// Direction from body center to orbiter
+	float *center_x, *center_y;		// Orbiter center
+	float *edge_x, *edge_y;			// Point on body surface under orbiter
+	float *target_angle;			// Sprite angle along orbit tangent, in degrees
+	uint8_t *grounded;				// Set if orbiter was resting on surface
+} OrbitBatch;
+
+// Returns false if out of memory, batch is left empty then
+bool OrbitBatchInit(OrbitBatch *batch, uint32_t capacity);
+void OrbitBatchClose(OrbitBatch *batch);
+
+// Make room for at least capacity orbiters, batch contents are lost if it grows.
+// Returns false if out of memory, batch is left empty then
+bool OrbitBatchReserve(OrbitBatch *batch, uint32_t capacity);
+
+// Solve all orbiters in batch, uses SSE2 when available
+void OrbitBatchSolve(OrbitBatch *batch, float dt);
+
+// Plain C version of the kernel, gives the same results as the SSE2 path
+void OrbitBatchSolveScalar(OrbitBatch *batch, float dt);
+
+// Sine and cosine of x, polynomial approximation shared by both kernel paths
+void OrbitSinCos(float x, float *s, float *c);
+
+#endif // !ORBIT_H_
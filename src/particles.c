@@ -0,0 +1,323 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raylib.h"
+#include "rlgl.h"
+#include "particles.h"
+#include "kmath.h"
+#include "orbit.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Blend mode and drag of each pool
+static const struct { uint8_t blend; float drag; } pool_defs[PFX_POOL_COUNT] = {
+	[PFX_POOL_SPARK] = { BLEND_ADDITIVE, 2.0f },
+	[PFX_POOL_DUST] = { BLEND_ALPHA, 4.0f }
+};
+
+static const ParticleEffect effects[PFX_EFFECT_COUNT] = {
+	[PFX_SHOT] = { PFX_POOL_SPARK, 300.0f, 600.0f, 15.0f, 0.15f, 0.35f, 3.0f, { 255, 220, 120, 255 } },
+	[PFX_THRUST] = { PFX_POOL_SPARK, 120.0f, 240.0f, 25.0f, 0.25f, 0.5f, 4.0f, { 120, 180, 255, 255 } },
+	[PFX_IMPACT] = { PFX_POOL_DUST, 40.0f, 160.0f, 70.0f, 0.4f, 0.9f, 6.0f, { 200, 190, 170, 255 } }
+};
+
+static bool ParticlePoolInit(ParticlePool *pool, uint32_t capacity, uint8_t blend, float drag) {
+	*pool = (ParticlePool){0};
+
+	// Round up so the kernel never needs a scalar tail
+	capacity = (capacity + PARTICLE_LANES - 1) & ~(uint32_t)(PARTICLE_LANES - 1);
+	pool->capacity = capacity;
+	pool->blend = blend;
+	pool->drag = drag;
+
+	// Float arrays share one allocation
+	float **fields[] = { &pool->pos_x, &pool->pos_y, &pool->vel_x, &pool->vel_y, &pool->life, &pool->inv_life, &pool->size };
+	uint32_t field_count = sizeof(fields) / sizeof(fields[0]);
+
+	float *block = calloc((size_t)capacity * field_count, sizeof(float));
+	pool->color = calloc(capacity, sizeof(Color));
+
+	if(!block || !pool->color) {
+		free(block);
+		free(pool->color);
+		*pool = (ParticlePool){0};
+		return false;
+	}
+
+	for(uint32_t i = 0; i < field_count; i++) *fields[i] = block + (size_t)i * capacity;
+	return true;
+}
+
+static void ParticlePoolClose(ParticlePool *pool) {
+	free(pool->pos_x);
+	free(pool->color);
+	*pool = (ParticlePool){0};
+}
+
+bool ParticleSystemInit(ParticleSystem *ps, EntHandler *handler, uint32_t capacity) {
+	*ps = (ParticleSystem){0};
+	ps->handler = handler;
+	ps->rng = 0x9e3779b9;
+
+	for(uint8_t i = 0; i < PFX_POOL_COUNT; i++) {
+		if(ParticlePoolInit(&ps->pools[i], capacity, pool_defs[i].blend, pool_defs[i].drag)) continue;
+
+		ParticleSystemClose(ps);
+		return false;
+	}
+
+	return true;
+}
+
+void ParticleSystemClose(ParticleSystem *ps) {
+	for(uint8_t i = 0; i < PFX_POOL_COUNT; i++) ParticlePoolClose(&ps->pools[i]);
+	ps->emitter_count = 0;
+}
+
+void ParticleSystemClear(ParticleSystem *ps) {
+	for(uint8_t i = 0; i < PFX_POOL_COUNT; i++) ps->pools[i].count = 0;
+	ps->emitter_count = 0;
+	ps->stats = (ParticleStats){0};
+}
+
+uint32_t ParticleBurst(ParticleSystem *ps, uint8_t effect, Vector2 position, float angle, uint32_t count) {
+	const ParticleEffect *fx = &effects[effect];
+	ParticlePool *pool = &ps->pools[fx->pool];
+
+	uint32_t room = pool->capacity - pool->count;
+	if(count > room) {
+		ps->stats.dropped += count - room;
+		count = room;
+	}
+
+	for(uint32_t n = 0; n < count; n++) {
+		uint32_t i = pool->count++;
+
+		float a = (angle + RandRange(&ps->rng, -fx->spread, fx->spread)) * DEG2RAD;
+		float speed = RandRange(&ps->rng, fx->speed_min, fx->speed_max);
+		float life = RandRange(&ps->rng, fx->life_min, fx->life_max);
+
+		float s, c;
+		OrbitSinCos(a, &s, &c);
+
+		pool->pos_x[i] = position.x;
+		pool->pos_y[i] = position.y;
+		pool->vel_x[i] = c * speed;
+		pool->vel_y[i] = s * speed;
+		pool->life[i] = life;
+		pool->inv_life[i] = 1.0f / life;
+		pool->size[i] = fx->size;
+		pool->color[i] = fx->color;
+	}
+
+	ps->stats.spawned += count;
+	return count;
+}
+
+bool ParticleEmitterAttach(ParticleSystem *ps, Entity *ent, uint8_t effect, float angle, float distance, float rate, float duration) {
+	EntHandle handle = EntGetHandle(ps->handler, ent->id);
+
+	// Entity already emits effect, restart that emitter
+	ParticleEmitter *em = NULL;
+	for(uint32_t i = 0; i < ps->emitter_count && !em; i++)
+		if(ps->emitters[i].ent == handle && ps->emitters[i].effect == effect) em = &ps->emitters[i];
+
+	if(!em) {
+		if(ps->emitter_count >= PARTICLE_MAX_EMITTERS) return false;
+		em = &ps->emitters[ps->emitter_count++];
+	}
+
+	*em = (ParticleEmitter) {
+		.ent = handle,
+		.effect = effect,
+		.angle = angle,
+		.distance = distance,
+		.rate = rate,
+		.time_left = duration
+	};
+
+	return true;
+}
+
+void ParticleEmitterDetach(ParticleSystem *ps, Entity *ent, uint8_t effect) {
+	EntHandle handle = EntGetHandle(ps->handler, ent->id);
+
+	for(uint32_t i = 0; i < ps->emitter_count;) {
+		ParticleEmitter *em = &ps->emitters[i];
+
+		if(em->ent == handle && em->effect == effect) *em = ps->emitters[--ps->emitter_count];
+		else i++;
+	}
+}
+
+// Spawn what each emitter has accumulated, emitters whose entity is gone or whose time ran out are swap removed
+static void ParticleEmittersUpdate(ParticleSystem *ps, float dt) {
+	for(uint32_t i = 0; i < ps->emitter_count;) {
+		ParticleEmitter *em = &ps->emitters[i];
+		Entity *ent = EntGet(ps->handler, em->ent);
+
+		if(!ent || (em->time_left >= 0 && (em->time_left -= dt) < 0)) {
+			*em = ps->emitters[--ps->emitter_count];
+			continue;
+		}
+
+		em->accum += em->rate * dt;
+		uint32_t count = (uint32_t)em->accum;
+		em->accum -= count;
+
+		if(count) {
+			float angle = ent->sprite_angle + em->angle;
+			float s, c;
+			OrbitSinCos(angle * DEG2RAD, &s, &c);
+
+			Vector2 center = EntCenter(ent);
+			Vector2 position = { center.x + c * em->distance, center.y + s * em->distance };
+			ParticleBurst(ps, em->effect, position, angle, count);
+		}
+
+		i++;
+	}
+}
+
+// Fill slot i with the last particle
+static inline void ParticleRemove(ParticlePool *pool, uint32_t i) {
+	uint32_t last = --pool->count;
+
+	pool->pos_x[i] = pool->pos_x[last];
+	pool->pos_y[i] = pool->pos_y[last];
+	pool->vel_x[i] = pool->vel_x[last];
+	pool->vel_y[i] = pool->vel_y[last];
+	pool->life[i] = pool->life[last];
+	pool->inv_life[i] = pool->inv_life[last];
+	pool->size[i] = pool->size[last];
+	pool->color[i] = pool->color[last];
+}
+
+// Swap remove dead particles from first onward, moved in particles are checked again
+static void ParticlePoolCompact(ParticlePool *pool, uint32_t first) {
+	for(uint32_t i = first; i < pool->count;) {
+		if(pool->life[i] > 0) i++;
+		else ParticleRemove(pool, i);
+	}
+}
+
+void ParticlePoolUpdateScalar(ParticlePool *pool, float dt) {
+	uint32_t n = (pool->count + PARTICLE_LANES - 1) & ~(uint32_t)(PARTICLE_LANES - 1);
+	float damp = (pool->drag * dt < 1.0f) ? 1.0f - pool->drag * dt : 0.0f;
+	uint32_t first_dead = pool->count;
+
+	for(uint32_t i = 0; i < n; i++) {
+		pool->vel_x[i] *= damp;
+		pool->vel_y[i] *= damp;
+		pool->pos_x[i] += pool->vel_x[i] * dt;
+		pool->pos_y[i] += pool->vel_y[i] * dt;
+		pool->life[i] -= dt;
+
+		if(pool->life[i] <= 0 && i < first_dead) first_dead = i;
+	}
+
+	ParticlePoolCompact(pool, first_dead);
+}
+
+#ifdef __SSE2__
+void ParticlePoolUpdate(ParticlePool *pool, float dt) {
+	uint32_t n = (pool->count + PARTICLE_LANES - 1) & ~(uint32_t)(PARTICLE_LANES - 1);
+	float damp = (pool->drag * dt < 1.0f) ? 1.0f - pool->drag * dt : 0.0f;
+	uint32_t first_dead = pool->count;
+
+	__m128 v_dt = _mm_set1_ps(dt);
+	__m128 v_damp = _mm_set1_ps(damp);
+	__m128 v_zero = _mm_setzero_ps();
+
+	for(uint32_t i = 0; i < n; i += PARTICLE_LANES) {
+		__m128 vel_x = _mm_mul_ps(_mm_loadu_ps(&pool->vel_x[i]), v_damp);
+		__m128 vel_y = _mm_mul_ps(_mm_loadu_ps(&pool->vel_y[i]), v_damp);
+		_mm_storeu_ps(&pool->vel_x[i], vel_x);
+		_mm_storeu_ps(&pool->vel_y[i], vel_y);
+
+		_mm_storeu_ps(&pool->pos_x[i], _mm_add_ps(_mm_loadu_ps(&pool->pos_x[i]), _mm_mul_ps(vel_x, v_dt)));
+		_mm_storeu_ps(&pool->pos_y[i], _mm_add_ps(_mm_loadu_ps(&pool->pos_y[i]), _mm_mul_ps(vel_y, v_dt)));
+
+		__m128 life = _mm_sub_ps(_mm_loadu_ps(&pool->life[i]), v_dt);
+		_mm_storeu_ps(&pool->life[i], life);
+
+		// Only the first death matters, everything before it stays put
+		if(first_dead == pool->count) {
+			int mask = _mm_movemask_ps(_mm_cmple_ps(life, v_zero));
+			if(mask) first_dead = i + __builtin_ctz(mask);
+		}
+	}
+
+	// Padding lanes past count can look dead too
+	if(first_dead > pool->count) first_dead = pool->count;
+	ParticlePoolCompact(pool, first_dead);
+}
+#else
+void ParticlePoolUpdate(ParticlePool *pool, float dt) {
+	ParticlePoolUpdateScalar(pool, dt);
+}
+#endif
+
+void ParticleSystemUpdate(ParticleSystem *ps, float dt) {
+	ps->stats.spawned = 0;
+	ps->stats.dropped = 0;
+
+	if(ps->handler) ParticleEmittersUpdate(ps, dt);
+
+	ps->stats.live = 0;
+	for(uint8_t i = 0; i < PFX_POOL_COUNT; i++) {
+		ParticlePoolUpdate(&ps->pools[i], dt);
+		ps->stats.live += ps->pools[i].count;
+	}
+}
+
+// Axis aligned quads on default white texture, size shrinks to half and alpha fades to 0 over life
+static void ParticlePoolDraw(ParticlePool *pool, ParticleStats *stats) {
+	BeginBlendMode(pool->blend);
+	rlSetTexture(rlGetTextureIdDefault());
+	rlBegin(RL_QUADS);
+	rlNormal3f(0.0f, 0.0f, 1.0f);
+
+	for(uint32_t i = 0; i < pool->count; i++) {
+		float t = pool->life[i] * pool->inv_life[i];
+		float h = pool->size[i] * (0.25f + 0.25f * t);
+		float x = pool->pos_x[i], y = pool->pos_y[i];
+		Color col = pool->color[i];
+
+		// Vertex buffer full, rlgl draws what it has and keeps texture and mode
+		if(rlCheckRenderBatchLimit(4)) stats->batch_flushes++;
+
+		rlColor4ub(col.r, col.g, col.b, (unsigned char)(col.a * t));
+
+		rlTexCoord2f(0, 0);
+		rlVertex2f(x - h, y - h);
+
+		rlTexCoord2f(0, 1);
+		rlVertex2f(x - h, y + h);
+
+		rlTexCoord2f(1, 1);
+		rlVertex2f(x + h, y + h);
+
+		rlTexCoord2f(1, 0);
+		rlVertex2f(x + h, y - h);
+	}
+
+	rlEnd();
+	rlSetTexture(0);
+	EndBlendMode();
+}
+
+void ParticleSystemDraw(ParticleSystem *ps) {
+	ps->stats.draw_calls = 0;
+	ps->stats.batch_flushes = 0;
+
+	for(uint8_t i = 0; i < PFX_POOL_COUNT; i++) {
+		if(!ps->pools[i].count) continue;
+
+		ParticlePoolDraw(&ps->pools[i], &ps->stats);
+		ps->stats.draw_calls++;
+	}
+}
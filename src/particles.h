@@ -0,0 +1,123 @@
+#ifndef PARTICLES_H_
+#define PARTICLES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "raylib.h"
+#include "entity.h"
+#include "ent_handler.h"
+
+// Particle effects:
+// particles live in fixed capacity pools, one per texture and blend mode, stored as parallel arrays
+// so integration runs several particles at once. Dead particles are swap removed, pools stay packed.
+// Each pool is drawn as a single batch. Particles are cosmetic, they never touch entity state or replay hashes
+
+// Particles integrated together by the vector kernel, capacity is padded to a multiple of this
+#define PARTICLE_LANES				4
+
+// Particles each pool holds, spawns past this are dropped
+#define PARTICLE_POOL_CAPACITY		65536
+
+#define PARTICLE_MAX_EMITTERS		64
+
+// Pools, each one is a draw call
+enum PARTICLE_POOLS {
+	PFX_POOL_SPARK,			// Additive glow
+	PFX_POOL_DUST,			// Alpha blended
+	PFX_POOL_COUNT
+};
+
+enum PARTICLE_EFFECTS {
+	PFX_SHOT,
+	PFX_THRUST,
+	PFX_IMPACT,
+	PFX_EFFECT_COUNT
+};
+
+// How an effect spawns it's particles
+typedef struct {
+	uint8_t pool;
+	float speed_min, speed_max;		// Units per second
+	float spread;					// Degrees either side of emit angle
+	float life_min, life_max;		// Seconds
+	float size;						// Starting side length, shrinks to half over life
+	Color color;					// Starting color, alpha fades out over life
+} ParticleEffect;
+
+typedef struct {
+	uint32_t capacity;
+	uint32_t count;
+
+	uint8_t blend;				// BLEND_ALPHA, BLEND_ADDITIVE, etc.
+	float drag;					// Fraction of velocity lost per second
+
+	float *pos_x, *pos_y;
+	float *vel_x, *vel_y;
+	float *life;				// Seconds left, dead at 0
+	float *inv_life;			// 1 / starting life, for fading
+	float *size;
+	Color *color;
+} ParticlePool;
+
+// Spawns an effect from an entity every tick it's alive
+typedef struct {
+	EntHandle ent;
+	uint8_t effect;
+	float angle;				// Emit angle in degrees, added to entity's sprite angle
+	float distance;				// Distance from entity center along emit angle
+	float rate;					// Particles per second
+	float time_left;			// Seconds until emitter stops, negative for until detached
+	float accum;				// Fraction of a particle carried to next tick
+} ParticleEmitter;
+
+// Counters from last update and draw
+typedef struct {
+	uint32_t live;
+	uint32_t spawned;			// Since last update
+	uint32_t dropped;			// Spawns that didn't fit in their pool, since last update
+	uint32_t draw_calls;
+	uint32_t batch_flushes;		// Extra draws caused by filling rlgl's vertex buffer
+} ParticleStats;
+
+typedef struct ParticleSystem {
+	ParticlePool pools[PFX_POOL_COUNT];
+
+	uint32_t emitter_count;
+	ParticleEmitter emitters[PARTICLE_MAX_EMITTERS];
+
+	EntHandler *handler;		// Looks up emitter entities, may be NULL if no emitters are used
+	uint32_t rng;
+	ParticleStats stats;
+} ParticleSystem;
+
+// Allocate every pool at capacity, returns false if out of memory
+bool ParticleSystemInit(ParticleSystem *ps, EntHandler *handler, uint32_t capacity);
+void ParticleSystemClose(ParticleSystem *ps);
+
+// Remove all particles and emitters
+void ParticleSystemClear(ParticleSystem *ps);
+
+// Spawn count particles of effect at position, heading around angle in degrees. Returns number that fit
+uint32_t ParticleBurst(ParticleSystem *ps, uint8_t effect, Vector2 position, float angle, uint32_t count);
+
+// Emit effect from entity at rate per second for duration seconds (negative for until detached or entity is gone).
+// Angle and distance are relative to entity's center and sprite angle. An emitter of the same effect already on entity is restarted.
+// Returns false if all emitter slots are taken
+bool ParticleEmitterAttach(ParticleSystem *ps, Entity *ent, uint8_t effect, float angle, float distance, float rate, float duration);
+
+// Stop entity's emitter of effect, if it has one
+void ParticleEmitterDetach(ParticleSystem *ps, Entity *ent, uint8_t effect);
+
+// Run emitters, integrate all pools and remove dead particles
+void ParticleSystemUpdate(ParticleSystem *ps, float dt);
+
+// Integrate pool and swap remove dead particles, uses SSE2 when available
+void ParticlePoolUpdate(ParticlePool *pool, float dt);
+
+// Plain C version of pool update, gives the same results as the SSE2 path
+void ParticlePoolUpdateScalar(ParticlePool *pool, float dt);
+
+// Draw each pool in one batch, call inside camera mode
+void ParticleSystemDraw(ParticleSystem *ps);
+
+#endif // !PARTICLES_H_
@@ -4,21 +4,24 @@
 #include "raylib.h"
 #include "raymath.h"
 #include "entity.h"
+#include "kmath.h"
 #include "sprites.h"
+#include "particles.h"
+#include "projectiles.h"
 
 // Initialize player, set data, pointers, references, etc.
 void PlayerInit(Entity *player, SpriteLoader *sl, Camera2D *camera) {
 	PlayerData *p = player->data;
 	*p = (PlayerData){0};
 
-	p->anchor_id = -1;
+	p->anchor = ENT_HANDLE_NONE;
 	p->active_anim = 0;
 	p->grav_force = PLR_FALL_GRAV;
 	p->run_anim = &sl->anims[0];
 	p->camera = camera;
 
-	player->center_offset = (Vector2){sl->spr_pool[0].frame_w * 0.5f, sl->spr_pool[0].frame_h * 0.5f};
-	player->radius = player->center_offset.y;
+	ENT_OFFSET(player) = (Vector2){sl->spr_pool[0].frame_w * 0.5f, sl->spr_pool[0].frame_h * 0.5f};
+	ENT_RADIUS(player) = ENT_OFFSET(player).y;
 }
 
 void PlayerSpawn(Entity *player, Vector2 position) {
@@ -49,20 +52,29 @@ void PlayerUpdate(Entity *player, float dt) {
 			break;
 		
 		case PLR_CHARGE_SHOT:
+			p->shot_charge = fminf(p->shot_charge + dt, PLR_CHARGE_TIME);
+			if(!p->input->shoot) PlayerFire(player);
 			break;
 
 		case PLR_SHOOT:
+			p->shot_timer -= dt;
+			if(p->shot_timer <= 0) p->state = PLR_IDLE;
 			break;
 
 		case PLR_DEAD:
 			break;
 	}
 
-	if(p->anchor_id > -1) { 
+	if(p->anchor != ENT_HANDLE_NONE) { 
 		PlayerPhysicsOrbit(player, dt);
 
-		if(player->flags & ENT_GROUNDED) 
-			p->state = (p->input->move_x != 0) ? PLR_RUN : PLR_IDLE;
+		if(ENT_FLAGS(player) & ENT_GROUNDED) {
+			if(p->state == PLR_JUMP || p->state == PLR_FALL) PlayerLand(player);
+
+			// Shooting states end on their own
+			if(p->state != PLR_CHARGE_SHOT && p->state != PLR_SHOOT)
+				p->state = (p->input->move_x != 0) ? PLR_RUN : PLR_IDLE;
+		}
 
 	} else { 
 		PlayerPhysicsFreeFloat(player, dt);
@@ -70,53 +82,50 @@ void PlayerUpdate(Entity *player, float dt) {
 
 }
 
-void PlayerDraw(Entity *player, SpriteLoader *sl) {
+void PlayerDraw(Entity *player, RenderQueue *rq, SpriteLoader *sl) {
 	PlayerData *p = player->data;
 
-	if(player->flags & ENT_ORBIT) OrbitDataDrawDebug(&player->orbit_data);
-
 	uint8_t draw_flags = 0;
 	if(p->sprite_dir == -1) draw_flags |= SPR_FLIP_X;
 
 	switch(p->state) {
 		case PLR_IDLE:
-			DrawSpritePro(&sl->spr_pool[player->sprite_id], 0, player->position, player->sprite_angle, draw_flags);
+			RenderQueueSprite(rq, &sl->spr_pool[player->sprite_id], 0, player->draw_pos, player->draw_angle, draw_flags, LAYER_PLAYER);
 			break;
 		
 		case PLR_RUN:
-			AnimDrawPro(p->run_anim, player->position, player->sprite_angle, draw_flags);
+			RenderQueueAnim(rq, p->run_anim, player->draw_pos, player->draw_angle, draw_flags, LAYER_PLAYER);
 			break;
 
 		case PLR_JUMP:
-			DrawSpritePro(&sl->spr_pool[player->sprite_id], 2, player->position, player->sprite_angle, draw_flags);
+			RenderQueueSprite(rq, &sl->spr_pool[player->sprite_id], 2, player->draw_pos, player->draw_angle, draw_flags, LAYER_PLAYER);
 			break;
 
 		case PLR_FALL:
-			DrawSpritePro(&sl->spr_pool[player->sprite_id], 3, player->position, player->sprite_angle, draw_flags);
+			RenderQueueSprite(rq, &sl->spr_pool[player->sprite_id], 3, player->draw_pos, player->draw_angle, draw_flags, LAYER_PLAYER);
 			break;
 		
 		case PLR_CHARGE_SHOT:
-			break;
-
 		case PLR_SHOOT:
+			RenderQueueSprite(rq, &sl->spr_pool[player->sprite_id], 0, player->draw_pos, player->draw_angle, draw_flags, LAYER_PLAYER);
 			break;
 
 		case PLR_DEAD:
 			break;
 	}
 
-	//DrawText(TextFormat("%d", p->anchor_id), 0, 0, 16, GREEN);
-	//DrawText(TextFormat("%f", player->orbit_height), 0, 16, 16, GREEN);
+	//DrawText(TextFormat("%d", EntHandleIndex(p->anchor)), 0, 0, 16, GREEN);
+	//DrawText(TextFormat("%f", player->orbit->height), 0, 16, 16, GREEN);
 
-	//DrawCircleLinesV(EntCenter(player), player->radius, RAYWHITE);
+	//DrawCircleLinesV(EntCenter(player), ENT_RADIUS(player), RAYWHITE);
 
-	//bool grounded = (player->flags & ENT_GROUNDED);
-	//DrawText(TextFormat("grounded: %d", grounded), player->position.x, player->position.y, 16, RAYWHITE);
+	//bool grounded = (ENT_FLAGS(player) & ENT_GROUNDED);
+	//DrawText(TextFormat("grounded: %d", grounded), ENT_POS(player).x, ENT_POS(player).y, 16, RAYWHITE);
 }
 
 void PlayerInput(Entity *player, float dt) {
 	PlayerData *p = player->data;
-	if(player->flags & ENT_ORBIT) {
+	if(ENT_FLAGS(player) & ENT_ORBIT) {
 		bool run_held = p->input->move_x != 0;
 
 		if(run_held) {
@@ -124,8 +133,12 @@ void PlayerInput(Entity *player, float dt) {
 			p->sprite_dir = p->input->move_x;
 		}
 
-		if(player->flags & ENT_GROUNDED) {
-			if(p->input->jump) PlayerStartJump(player);
+		if(ENT_FLAGS(player) & ENT_GROUNDED) {
+			if(p->input->jump) {
+				// Jumping lets a charging shot go
+				if(p->state == PLR_CHARGE_SHOT) PlayerFire(player);
+				PlayerStartJump(player);
+			}
 		} else {
 			if(p->jump_timer > 0 && !p->input->jump) PlayerEndJump(player, true);
 		}
@@ -135,15 +148,21 @@ void PlayerInput(Entity *player, float dt) {
 
 		p->orbit_vel.x = Clamp(p->orbit_vel.x, -2.0f, 2.0f);
 	}
+
+	// Charge while shoot is held, shot goes off on release. Not in the middle of a jump or fall
+	if(p->input->shoot && p->projectiles && (p->state == PLR_IDLE || p->state == PLR_RUN)) {
+		p->state = PLR_CHARGE_SHOT;
+		p->shot_charge = 0;
+	}
 }
 
 void PlayerPhysicsOrbit(Entity *player, float dt) {
 	PlayerData *p = player->data; 
 
-	player->orbit_angle += p->orbit_vel.x * dt;	
-	player->orbit_height += p->orbit_vel.y * dt;
+	player->orbit->angle += p->orbit_vel.x * dt;	
+	player->orbit->height += p->orbit_vel.y * dt;
 
-	if(!(player->flags & ENT_GROUNDED))
+	if(!(ENT_FLAGS(player) & ENT_GROUNDED))
 		p->orbit_vel.y -= p->grav_force * dt;
 	else 
 		p->orbit_vel.y = 0;
@@ -154,8 +173,18 @@ void PlayerPhysicsOrbit(Entity *player, float dt) {
 	p->orbit_vel.x = Clamp(p->orbit_vel.x, -2.0f, 2.0f);
 }
 
+// Body gravity was added to velocity by the entity handler, limit it and turn feet toward the pull
 void PlayerPhysicsFreeFloat(Entity *player, float dt) {
+	PlayerData *p = player->data;
+
+	float speed = Vector2Length(ENT_VEL(player));
+	if(speed > PLR_FLOAT_SPEED) ENT_VEL(player) = Vector2Scale(ENT_VEL(player), PLR_FLOAT_SPEED / speed);
 
+	// Same angle an orbit would give, up is away from the pull
+	if(p->grav_pull.x != 0 || p->grav_pull.y != 0) {
+		float target = atan2f(-p->grav_pull.y, -p->grav_pull.x) * RAD2DEG + 90.0f;
+		player->sprite_angle = AngleLerp(player->sprite_angle, target, 0.1f * dt);
+	}
 }
 
 void PlayerStartJump(Entity *player) {
@@ -167,10 +196,14 @@ void PlayerStartJump(Entity *player) {
 	p->state = PLR_JUMP;
 
 	// Request orbit raycast
-	player->flags |= ENT_CAST_ORBIT;
+	ENT_FLAGS(player) |= ENT_CAST_ORBIT;
 	
 	// Unground player
-	player->flags &= ~ENT_GROUNDED;
+	ENT_FLAGS(player) &= ~ENT_GROUNDED;
+
+	// Exhaust points back at the surface, sprite angle runs along orbit tangent
+	if(p->particles) 
+		ParticleEmitterAttach(p->particles, player, PFX_THRUST, 90.0f, ENT_RADIUS(player), PLR_THRUST_RATE, p->jump_timer);
 }
 
 void PlayerEndJump(Entity *player, bool cut) {
@@ -178,5 +211,46 @@ void PlayerEndJump(Entity *player, bool cut) {
 
 	p->grav_force = (cut) ? PLR_CUT_GRAV : PLR_FALL_GRAV;	
 	p->state = PLR_FALL;
+
+	if(p->particles) ParticleEmitterDetach(p->particles, player, PFX_THRUST);
 }
 
+// Shoot along orbit tangent in facing direction, faster the longer shot was charged
+void PlayerFire(Entity *player) {
+	PlayerData *p = player->data;
+	p->state = PLR_SHOOT;
+	p->shot_timer = PLR_SHOOT_TIME;
+
+	// Players that never orbited have no up direction yet, screen up is used instead
+	Vector2 up = p->orbit_dir;
+	if(up.x == 0 && up.y == 0) up = (Vector2){ 0, -1 };
+
+	float facing = (p->sprite_dir < 0) ? -1.0f : 1.0f;
+	Vector2 dir = { -up.y * facing, up.x * facing };
+	float speed = Lerp(PLR_SHOT_SPEED_MIN, PLR_SHOT_SPEED_MAX, p->shot_charge / PLR_CHARGE_TIME);
+
+	// Start clear of player's own radius
+	Vector2 muzzle = Vector2Add(EntCenter(player), Vector2Scale(dir, ENT_RADIUS(player) + PLR_SHOT_RADIUS));
+	ProjectileFire(p->projectiles, player, muzzle, Vector2Scale(dir, speed), PLR_SHOT_RADIUS, PLR_SHOT_LIFE);
+
+	if(p->particles) ParticleBurst(p->particles, PFX_SHOT, muzzle, atan2f(dir.y, dir.x) * RAD2DEG, PLR_SHOT_SPARKS);
+}
+
+// Kick up dust from under player's feet
+void PlayerLand(Entity *player) {
+	PlayerData *p = player->data;
+	if(!p->particles) return;
+
+	ParticleEmitterDetach(p->particles, player, PFX_THRUST);
+
+	Vector2 feet = Vector2Subtract(EntCenter(player), Vector2Scale(p->orbit_dir, ENT_RADIUS(player)));
+	ParticleBurst(p->particles, PFX_IMPACT, feet, atan2f(p->orbit_dir.y, p->orbit_dir.x) * RAD2DEG, PLR_LAND_DUST);
+}
+
+void PlayerUpdateBatch(Entity **players, uint32_t count, float dt) {
+	for(uint32_t i = 0; i < count; i++) PlayerUpdate(players[i], dt);
+}
+
+void PlayerDrawBatch(Entity **players, uint32_t count, RenderQueue *rq, SpriteLoader *sl) {
+	for(uint32_t i = 0; i < count; i++) PlayerDraw(players[i], rq, sl);
+}
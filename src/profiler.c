@@ -0,0 +1,285 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "profiler.h"
+
+#ifdef PROFILE_ENABLED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "raylib.h"
+#include "clock.h"
+
+typedef struct {
+	const char *name;
+	const char *parent;			// Name of enclosing zone, NULL at top level
+	uint64_t start_ns, end_ns;
+	uint16_t depth;
+} ProfEvent;
+
+// Zone ring of one thread, only the owning thread writes,
+// head is published after each event so other threads can read up to it
+typedef struct {
+	uint32_t head;
+	uint16_t depth;
+
+	const char *stack_names[PROF_MAX_DEPTH];
+	uint64_t stack_start[PROF_MAX_DEPTH];
+
+	ProfEvent *events;
+} ProfThread;
+
+// Zone totals of last frame, shown in overlay
+typedef struct {
+	const char *name, *parent;
+	uint16_t depth;
+	uint16_t calls;
+	uint64_t first_start;
+	uint64_t total_ns;
+} ProfZoneStat;
+
+static struct {
+	bool running;
+	uint64_t origin_ns;
+
+	pthread_key_t key;
+	uint32_t thread_count;
+	ProfThread threads[PROF_MAX_THREADS];
+
+	// Main thread frame state
+	uint64_t frame_start;
+	uint32_t frame_event_start;
+
+	float history[PROF_HISTORY];		// Frame times in milliseconds
+	uint32_t history_count, history_pos;
+	float p50, p95, p99;
+
+	uint16_t zone_count;
+	ProfZoneStat zones[PROF_OVERLAY_ZONES];
+} prof;
+
+// Get calling thread's ring, registering thread on first use.
+// Threads past PROF_MAX_THREADS, or whose ring can't be allocated, stay unregistered and their zones are dropped
+static ProfThread *ProfGetThread(void) {
+	ProfThread *t = pthread_getspecific(prof.key);
+	if(t) return t;
+
+	uint32_t idx = __atomic_load_n(&prof.thread_count, __ATOMIC_ACQUIRE);
+	if(idx >= PROF_MAX_THREADS) return NULL;
+
+	ProfEvent *events = calloc(PROF_RING_CAP, sizeof(ProfEvent));
+	if(!events) return NULL;
+
+	// Claim a slot, count never goes past PROF_MAX_THREADS
+	do {
+		if(idx >= PROF_MAX_THREADS) {
+			free(events);
+			return NULL;
+		}
+	} while(!__atomic_compare_exchange_n(&prof.thread_count, &idx, idx + 1, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+	t = &prof.threads[idx];
+	t->events = events;
+	pthread_setspecific(prof.key, t);
+
+	return t;
+}
+
+void ProfInit(void) {
+	memset(&prof, 0, sizeof(prof));
+	pthread_key_create(&prof.key, NULL);
+
+	prof.origin_ns = ClockNowNs();
+	prof.frame_start = prof.origin_ns;
+	prof.running = true;
+
+	// Calling thread becomes thread 0
+	ProfGetThread();
+}
+
+void ProfBegin(const char *name) {
+	if(!prof.running) return;
+
+	ProfThread *t = ProfGetThread();
+	if(!t || t->depth >= PROF_MAX_DEPTH) return;
+
+	t->stack_names[t->depth] = name;
+	t->stack_start[t->depth] = ClockNowNs();
+	t->depth++;
+}
+
+void ProfEnd(void) {
+	if(!prof.running) return;
+
+	ProfThread *t = ProfGetThread();
+	if(!t || t->depth == 0) return;
+
+	uint64_t end = ClockNowNs();
+	uint16_t depth = --t->depth;
+
+	ProfEvent *ev = &t->events[t->head & (PROF_RING_CAP - 1)];
+	ev->name = t->stack_names[depth];
+	ev->parent = (depth > 0) ? t->stack_names[depth - 1] : NULL;
+	ev->start_ns = t->stack_start[depth];
+	ev->end_ns = end;
+	ev->depth = depth;
+
+	__atomic_store_n(&t->head, t->head + 1, __ATOMIC_RELEASE);
+}
+
+static int CompareFloat(const void *a, const void *b) {
+	float fa = *(const float*)a, fb = *(const float*)b;
+	return (fa > fb) - (fa < fb);
+}
+
+static int CompareZoneStart(const void *a, const void *b) {
+	const ProfZoneStat *za = a, *zb = b;
+	return (za->first_start > zb->first_start) - (za->first_start < zb->first_start);
+}
+
+static bool NameEq(const char *a, const char *b) {
+	if(a == b) return true;
+	return (a && b && strcmp(a, b) == 0);
+}
+
+// Sum main thread zones of finished frame, same zone called several times is merged
+static void ProfCollectFrame(ProfThread *t, uint32_t head) {
+	prof.zone_count = 0;
+
+	uint32_t first = prof.frame_event_start;
+	if(head - first > PROF_RING_CAP) first = head - PROF_RING_CAP;
+
+	for(uint32_t i = first; i < head; i++) {
+		ProfEvent *ev = &t->events[i & (PROF_RING_CAP - 1)];
+		uint64_t dur = ev->end_ns - ev->start_ns;
+
+		ProfZoneStat *zone = NULL;
+		for(uint16_t z = 0; z < prof.zone_count; z++) {
+			ProfZoneStat *s = &prof.zones[z];
+			if(s->depth == ev->depth && NameEq(s->name, ev->name) && NameEq(s->parent, ev->parent)) {
+				zone = s;
+				break;
+			}
+		}
+
+		if(!zone) {
+			if(prof.zone_count >= PROF_OVERLAY_ZONES) continue;
+
+			zone = &prof.zones[prof.zone_count++];
+			*zone = (ProfZoneStat){ ev->name, ev->parent, ev->depth, 0, ev->start_ns, 0 };
+		}
+
+		zone->calls++;
+		zone->total_ns += dur;
+		if(ev->start_ns < zone->first_start) zone->first_start = ev->start_ns;
+	}
+
+	// Zones end before their parents, order by start so children follow parents
+	qsort(prof.zones, prof.zone_count, sizeof(ProfZoneStat), CompareZoneStart);
+}
+
+void ProfFrameMark(void) {
+	if(!prof.running) return;
+
+	ProfThread *t = ProfGetThread();
+	if(!t) return;
+
+	uint64_t now = ClockNowNs();
+	uint32_t head = t->head;
+
+	ProfCollectFrame(t, head);
+
+	// Rolling frame time percentiles
+	prof.history[prof.history_pos] = (now - prof.frame_start) * 1e-6f;
+	prof.history_pos = (prof.history_pos + 1) % PROF_HISTORY;
+	if(prof.history_count < PROF_HISTORY) prof.history_count++;
+
+	prof.frame_start = now;
+	prof.frame_event_start = head;
+}
+
+void ProfDrawOverlay(int x, int y) {
+	if(!prof.running || prof.history_count == 0) return;
+
+	// Percentiles are only needed when shown, sort a copy of frame history
+	float sorted[PROF_HISTORY];
+	memcpy(sorted, prof.history, sizeof(float) * prof.history_count);
+	qsort(sorted, prof.history_count, sizeof(float), CompareFloat);
+
+	uint32_t last = prof.history_count - 1;
+	prof.p50 = sorted[(uint32_t)(last * 0.50f)];
+	prof.p95 = sorted[(uint32_t)(last * 0.95f)];
+	prof.p99 = sorted[(uint32_t)(last * 0.99f)];
+
+	DrawText(TextFormat("frame ms  p50: %.2f  p95: %.2f  p99: %.2f", prof.p50, prof.p95, prof.p99), x, y, 20, GREEN);
+	y += 24;
+
+	for(uint16_t z = 0; z < prof.zone_count; z++) {
+		ProfZoneStat *zone = &prof.zones[z];
+		int indent = zone->depth * 16;
+
+		if(zone->calls > 1)
+			DrawText(TextFormat("%s  %.3f ms  x%d", zone->name, zone->total_ns * 1e-6, zone->calls), x + indent, y, 16, GREEN);
+		else
+			DrawText(TextFormat("%s  %.3f ms", zone->name, zone->total_ns * 1e-6), x + indent, y, 16, GREEN);
+
+		y += 18;
+	}
+}
+
+// Write every event still held in thread rings as Chrome trace events (chrome://tracing, Perfetto)
+static void ProfWriteTrace(const char *path) {
+	FILE *pF = fopen(path, "w");
+	if(!pF) {
+		printf("ERROR: Could not write profiler trace to: %s\n", path);
+		return;
+	}
+
+	fputs("{\"traceEvents\":[\n", pF);
+	bool first = true;
+
+	uint32_t thread_count = prof.thread_count;
+	if(thread_count > PROF_MAX_THREADS) thread_count = PROF_MAX_THREADS;
+
+	for(uint32_t i = 0; i < thread_count; i++) {
+		ProfThread *t = &prof.threads[i];
+		uint32_t head = __atomic_load_n(&t->head, __ATOMIC_ACQUIRE);
+		uint32_t start = (head > PROF_RING_CAP) ? head - PROF_RING_CAP : 0;
+
+		fprintf(pF, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+			(first) ? "" : ",\n", i, (i == 0) ? "main" : "thread", i);
+		first = false;
+
+		for(uint32_t e = start; e < head; e++) {
+			ProfEvent *ev = &t->events[e & (PROF_RING_CAP - 1)];
+			fprintf(pF, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				ev->name, i, (ev->start_ns - prof.origin_ns) * 1e-3, (ev->end_ns - ev->start_ns) * 1e-3);
+		}
+	}
+
+	fputs("\n]}\n", pF);
+	fclose(pF);
+
+	printf("profiler trace written to: %s\n", path);
+}
+
+void ProfClose(const char *trace_path) {
+	if(!prof.running) return;
+
+	// Other threads should be joined by now
+	if(trace_path) ProfWriteTrace(trace_path);
+
+	prof.running = false;
+
+	uint32_t thread_count = (prof.thread_count > PROF_MAX_THREADS) ? PROF_MAX_THREADS : prof.thread_count;
+	for(uint32_t i = 0; i < thread_count; i++) {
+		free(prof.threads[i].events);
+		prof.threads[i].events = NULL;
+	}
+
+	pthread_key_delete(prof.key);
+}
+
+#endif // PROFILE_ENABLED
@@ -0,0 +1,52 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <stdint.h>
+
+// Frame profiler:
+// zones are timed with the monotonic clock and recorded into a ring per thread,
+// main thread zones of last frame are shown as a tree in the debug overlay,
+// everything still in the rings is written as Chrome trace JSON on close.
+//
+// Only the PROF_* macros should be used, built without PROFILE_ENABLED they compile to nothing
+
+#define PROF_MAX_THREADS	16
+#define PROF_RING_CAP		16384	// Zones kept per thread, must be a power of 2
+#define PROF_MAX_DEPTH		32		// Deepest zone nesting
+#define PROF_HISTORY		240		// Frames used for frame time percentiles
+#define PROF_OVERLAY_ZONES	48		// Most distinct zones shown in overlay
+
+#define PROF_TRACE_PATH		"profile_trace.json"
+
+#ifdef PROFILE_ENABLED
+
+#define PROF_INIT()					ProfInit()
+#define PROF_CLOSE(path)			ProfClose(path)
+#define PROF_BEGIN(name)			ProfBegin(name)
+#define PROF_END()					ProfEnd()
+#define PROF_FRAME()				ProfFrameMark()
+#define PROF_DRAW_OVERLAY(x, y)		ProfDrawOverlay(x, y)
+
+void ProfInit(void);
+void ProfClose(const char *trace_path);
+
+// Zone names must stay valid until ProfClose, string literals are expected
+void ProfBegin(const char *name);
+void ProfEnd(void);
+
+// Mark start of a new frame, main thread only
+void ProfFrameMark(void);
+void ProfDrawOverlay(int x, int y);
+
+#else
+
+#define PROF_INIT()					((void)0)
+#define PROF_CLOSE(path)			((void)0)
+#define PROF_BEGIN(name)			((void)0)
+#define PROF_END()					((void)0)
+#define PROF_FRAME()				((void)0)
+#define PROF_DRAW_OVERLAY(x, y)		((void)0)
+
+#endif // PROFILE_ENABLED
+
+#endif // !PROFILER_H_
@@ -0,0 +1,288 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include "projectiles.h"
+#include "spatial.h"
+#include "profiler.h"
+
+// Projectiles are drawn as a streak this many ticks long behind them
+#define PROJECTILE_TRAIL_TICKS	0.5f
+
+static const Color projectile_color = { 255, 230, 150, 255 };
+
+bool ProjectileSystemInit(ProjectileSystem *ps, EntHandler *handler, uint32_t capacity) {
+	*ps = (ProjectileSystem){0};
+	ps->handler = handler;
+	ps->capacity = capacity;
+
+	// Float arrays share one allocation
+	float **fields[] = { &ps->pos_x, &ps->pos_y, &ps->vel_x, &ps->vel_y, &ps->radius, &ps->life, &ps->hit_time };
+	uint32_t field_count = sizeof(fields) / sizeof(fields[0]);
+
+	float *block = calloc((size_t)capacity * field_count, sizeof(float));
+	ps->owner = calloc(capacity, sizeof(EntHandle));
+	ps->hit_id = calloc(capacity, sizeof(int32_t));
+	ps->hits = calloc(capacity, sizeof(ProjectileHit));
+
+	if(!block || !ps->owner || !ps->hit_id || !ps->hits) {
+		free(block);
+		ProjectileSystemClose(ps);
+		return false;
+	}
+
+	for(uint32_t i = 0; i < field_count; i++) *fields[i] = block + (size_t)i * capacity;
+	return true;
+}
+
+void ProjectileSystemClose(ProjectileSystem *ps) {
+	free(ps->pos_x);
+	free(ps->owner);
+	free(ps->hit_id);
+	free(ps->hits);
+	*ps = (ProjectileSystem){0};
+}
+
+void ProjectileSystemClear(ProjectileSystem *ps) {
+	ps->count = 0;
+	ps->hit_count = 0;
+	ps->stats = (ProjectileStats){0};
+}
+
+bool ProjectileFire(ProjectileSystem *ps, Entity *owner, Vector2 position, Vector2 velocity, float radius, float life) {
+	if(ps->count >= ps->capacity) {
+		ps->stats.dropped++;
+		return false;
+	}
+
+	uint32_t i = ps->count++;
+	ps->pos_x[i] = position.x;
+	ps->pos_y[i] = position.y;
+	ps->vel_x[i] = velocity.x;
+	ps->vel_y[i] = velocity.y;
+	ps->radius[i] = radius;
+	ps->life[i] = life;
+	ps->owner[i] = (owner) ? EntGetHandle(ps->handler, owner->id) : ENT_HANDLE_NONE;
+
+	ps->stats.fired++;
+	return true;
+}
+
+// Earliest time in [0, 1] a circle at p moving by d touches a circle of radius r at c, -1 for none.
+// Circles already overlapping touch at 0
+static inline float SweepCircle(Vector2 p, Vector2 d, Vector2 c, float r) {
+	Vector2 m = { p.x - c.x, p.y - c.y };
+	float k = m.x * m.x + m.y * m.y - r * r;
+	if(k <= 0) return 0;
+
+	// Moving away, or not moving at all
+	float b = m.x * d.x + m.y * d.y;
+	if(b >= 0) return -1;
+
+	float a = d.x * d.x + d.y * d.y;
+	float disc = b * b - a * k;
+	if(disc < 0) return -1;
+
+	float t = (-b - sqrtf(disc)) / a;
+	return (t <= 1) ? t : -1;
+}
+
+typedef struct {
+	ProjectileSystem *ps;
+	float dt;
+	uint32_t candidates[JOB_MAX_THREADS];	// Per worker, summed once jobs are done
+} SweepCtx;
+
+// Sweep a range of projectiles, each one only writes it's own slots so jobs never share anything but the read only grid
+static void ProjectileSweepJob(void *ctx, uint32_t begin, uint32_t end) {
+	SweepCtx *sweep = ctx;
+	ProjectileSystem *ps = sweep->ps;
+	EntHandler *handler = ps->handler;
+	float dt = sweep->dt;
+
+	int32_t ids[PROJECTILE_QUERY_CAP];
+	uint32_t candidates = 0;
+
+	for(uint32_t i = begin; i < end; i++) {
+		Vector2 p = { ps->pos_x[i], ps->pos_y[i] };
+		Vector2 d = { ps->vel_x[i] * dt, ps->vel_y[i] * dt };
+		float r = ps->radius[i];
+		uint32_t owner_id = EntHandleIndex(ps->owner[i]);
+		bool has_owner = (ps->owner[i] != ENT_HANDLE_NONE);
+
+		// Grid holds entity centers, widen path bounds by the largest radius a target can have
+		float pad = r + handler->max_radius;
+		Rectangle rec = {
+			fminf(p.x, p.x + d.x) - pad, fminf(p.y, p.y + d.y) - pad,
+			fabsf(d.x) + pad * 2, fabsf(d.y) + pad * 2
+		};
+		int32_t n = GridQueryRect(&handler->grid, rec, ids, PROJECTILE_QUERY_CAP);
+		candidates += n;
+
+		// Earliest contact wins, lower id breaks ties so the result never depends on query order
+		int32_t best_id = GRID_NONE;
+		float best_t = 2.0f;
+
+		for(int32_t q = 0; q < n; q++) {
+			int32_t id = ids[q];
+			EntHot *hot = EntHotOf(handler, id);
+			uint32_t h = id & ENT_CHUNK_MASK;
+
+			if(!(hot->flags[h] & ENT_IS_BODY) && hot->type[h] != ENT_FISH) continue;
+			if(has_owner && (uint32_t)id == owner_id) continue;
+
+			Vector2 c = Vector2Add(hot->position[h], hot->center_offset[h]);
+			float t = SweepCircle(p, d, c, r + hot->radius[h]);
+
+			if(t >= 0 && (t < best_t || (t == best_t && id < best_id))) {
+				best_t = t;
+				best_id = id;
+			}
+		}
+
+		// Hit projectiles stop at contact
+		float move = (best_id != GRID_NONE) ? best_t : 1.0f;
+		ps->pos_x[i] = p.x + d.x * move;
+		ps->pos_y[i] = p.y + d.y * move;
+		ps->life[i] -= dt;
+		ps->hit_id[i] = best_id;
+		ps->hit_time[i] = best_t;
+	}
+
+	sweep->candidates[JobWorkerIndex(handler->jobs)] += candidates;
+}
+
+// Fill slot i with the last projectile
+static inline void ProjectileRemove(ProjectileSystem *ps, uint32_t i) {
+	uint32_t last = --ps->count;
+
+	ps->pos_x[i] = ps->pos_x[last];
+	ps->pos_y[i] = ps->pos_y[last];
+	ps->vel_x[i] = ps->vel_x[last];
+	ps->vel_y[i] = ps->vel_y[last];
+	ps->radius[i] = ps->radius[last];
+	ps->life[i] = ps->life[last];
+	ps->owner[i] = ps->owner[last];
+	ps->hit_id[i] = ps->hit_id[last];
+	ps->hit_time[i] = ps->hit_time[last];
+}
+
+void ProjectileSystemUpdate(ProjectileSystem *ps, float dt) {
+	PROF_BEGIN("ProjectileSystemUpdate");
+	EntHandler *handler = ps->handler;
+
+	ps->hit_count = 0;
+	ps->last_dt = dt;
+	ps->stats.expired = 0;
+	ps->stats.candidates = 0;
+
+	SweepCtx sweep = { .ps = ps, .dt = dt };
+	if(ps->count) JobParallelFor(handler->jobs, ProjectileSweepJob, &sweep, ps->count, PROJECTILE_JOB_CHUNK);
+	for(uint32_t w = 0; w < JOB_MAX_THREADS; w++) ps->stats.candidates += sweep.candidates[w];
+
+	// Gather hits in projectile order before removal reorders anything
+	for(uint32_t i = 0; i < ps->count; i++) {
+		int32_t id = ps->hit_id[i];
+		if(id == GRID_NONE) continue;
+
+		Entity *target = EntAt(handler, id);
+		Vector2 point = { ps->pos_x[i], ps->pos_y[i] };
+
+		ps->hits[ps->hit_count++] = (ProjectileHit) {
+			.owner = ps->owner[i],
+			.target = EntGetHandle(handler, id),
+			.target_type = ENT_TYPEOF(target),
+			.time = ps->hit_time[i],
+			.point = point,
+			.normal = Vector2Normalize(Vector2Subtract(point, EntCenter(target))),
+			.velocity = { ps->vel_x[i], ps->vel_y[i] }
+		};
+	}
+
+	// Swap remove spent projectiles, moved in projectiles are checked again
+	for(uint32_t i = 0; i < ps->count;) {
+		if(ps->hit_id[i] != GRID_NONE) {
+			ProjectileRemove(ps, i);
+		} else if(ps->life[i] <= 0) {
+			ProjectileRemove(ps, i);
+			ps->stats.expired++;
+		} else {
+			i++;
+		}
+	}
+
+	ps->stats.live = ps->count;
+	PROF_END();
+}
+
+static inline uint32_t HashWord(uint32_t hash, uint32_t word) {
+	return (hash ^ word) * 16777619u;
+}
+
+static inline uint32_t FloatBits(float f) {
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	return bits;
+}
+
+uint32_t ProjectileSystemHash(ProjectileSystem *ps, uint32_t hash) {
+	hash = HashWord(hash, ps->count);
+
+	for(uint32_t i = 0; i < ps->count; i++) {
+		hash = HashWord(hash, FloatBits(ps->pos_x[i]));
+		hash = HashWord(hash, FloatBits(ps->pos_y[i]));
+		hash = HashWord(hash, FloatBits(ps->vel_x[i]));
+		hash = HashWord(hash, FloatBits(ps->vel_y[i]));
+		hash = HashWord(hash, FloatBits(ps->life[i]));
+		hash = HashWord(hash, EntHandleKey(ps->handler, ps->owner[i]));
+	}
+
+	return hash;
+}
+
+// Streaks from a short way back along velocity to the interpolated position, additive so overlapping shots glow
+void ProjectileSystemDraw(ProjectileSystem *ps, float alpha) {
+	if(!ps->count) return;
+
+	float back = ps->last_dt * (1.0f - alpha);
+	float trail = ps->last_dt * PROJECTILE_TRAIL_TICKS;
+
+	BeginBlendMode(BLEND_ADDITIVE);
+	rlSetTexture(rlGetTextureIdDefault());
+	rlBegin(RL_QUADS);
+	rlNormal3f(0.0f, 0.0f, 1.0f);
+	rlColor4ub(projectile_color.r, projectile_color.g, projectile_color.b, projectile_color.a);
+
+	for(uint32_t i = 0; i < ps->count; i++) {
+		Vector2 vel = { ps->vel_x[i], ps->vel_y[i] };
+		Vector2 head = { ps->pos_x[i] - vel.x * back, ps->pos_y[i] - vel.y * back };
+		Vector2 tail = { head.x - vel.x * trail, head.y - vel.y * trail };
+
+		// Streak width across velocity
+		float speed = Vector2Length(vel);
+		float r = ps->radius[i];
+		Vector2 side = (speed > 0) ? (Vector2){ -vel.y / speed * r, vel.x / speed * r } : (Vector2){ r, 0 };
+
+		rlCheckRenderBatchLimit(4);
+
+		rlTexCoord2f(0, 0);
+		rlVertex2f(tail.x + side.x, tail.y + side.y);
+
+		rlTexCoord2f(0, 1);
+		rlVertex2f(tail.x - side.x, tail.y - side.y);
+
+		rlTexCoord2f(1, 1);
+		rlVertex2f(head.x - side.x, head.y - side.y);
+
+		rlTexCoord2f(1, 0);
+		rlVertex2f(head.x + side.x, head.y + side.y);
+	}
+
+	rlEnd();
+	rlSetTexture(0);
+	EndBlendMode();
+}
@@ -0,0 +1,88 @@
+#ifndef PROJECTILES_H_
+#define PROJECTILES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "raylib.h"
+#include "entity.h"
+#include "ent_handler.h"
+
+// Projectiles:
+// a fixed capacity pool of moving circles, stored as parallel arrays. Each tick every projectile sweeps it's circle
+// along the path it covers that tick and is tested against bodies and fish the entity grid finds near that path,
+// so fast projectiles can't skip over a target between ticks. Sweeps only read entity state and run in parallel,
+// hits are gathered afterwards in projectile order into a hit list the game applies once the update is done.
+// Projectiles are gameplay state, they are part of entity handler hashes and snapshots
+
+// Projectiles the game's pool holds, fires past this are dropped
+#define PROJECTILE_CAPACITY		8192
+
+// Most projectiles swept by a single job
+#define PROJECTILE_JOB_CHUNK	256
+
+// Most grid candidates tested per sweep
+#define PROJECTILE_QUERY_CAP	256
+
+// Contact of a projectile with a target during last update
+typedef struct {
+	EntHandle owner;			// Entity that fired projectile
+	EntHandle target;
+	uint8_t target_type;
+	float time;					// Fraction of the tick at contact, 0 if projectile started overlapping
+	Vector2 point;				// Projectile center at contact
+	Vector2 normal;				// From target center toward point
+	Vector2 velocity;			// Projectile velocity
+} ProjectileHit;
+
+// Counters, fired and dropped count up until pool is cleared, the rest are from last update
+typedef struct {
+	uint32_t live;
+	uint32_t fired;
+	uint32_t dropped;			// Fires that didn't fit in the pool
+	uint32_t expired;
+	uint32_t candidates;		// Targets tested by sweeps
+} ProjectileStats;
+
+typedef struct ProjectileSystem {
+	uint32_t capacity;
+	uint32_t count;
+
+	float *pos_x, *pos_y;
+	float *vel_x, *vel_y;		// Units per second
+	float *radius;
+	float *life;				// Seconds left, removed at 0
+	EntHandle *owner;			// Never hit by it's own projectiles
+
+	// Sweep results of each projectile, written by jobs
+	int32_t *hit_id;			// Entity id hit, GRID_NONE for none
+	float *hit_time;
+
+	uint32_t hit_count;
+	ProjectileHit *hits;		// Hits of last update in projectile order, one per projectile at most
+
+	float last_dt;				// Tick length of last update, for drawing between ticks
+	EntHandler *handler;		// Targets come from it's grid, sweeps run on it's job system
+	ProjectileStats stats;
+} ProjectileSystem;
+
+// Allocate pool at capacity, returns false if out of memory
+bool ProjectileSystemInit(ProjectileSystem *ps, EntHandler *handler, uint32_t capacity);
+void ProjectileSystemClose(ProjectileSystem *ps);
+
+// Remove all projectiles and hits
+void ProjectileSystemClear(ProjectileSystem *ps);
+
+// Launch a projectile from owner, returns false if pool is full
+bool ProjectileFire(ProjectileSystem *ps, Entity *owner, Vector2 position, Vector2 velocity, float radius, float life);
+
+// Sweep every projectile over dt against bodies and fish, fill hit list,
+// then remove projectiles that hit something or ran out of life. Entity grid must be up to date
+void ProjectileSystemUpdate(ProjectileSystem *ps, float dt);
+
+// Fold projectile state into hash, equal pools give equal hashes
+uint32_t ProjectileSystemHash(ProjectileSystem *ps, uint32_t hash);
+
+// Draw projectiles in one batch, alpha is the fraction of a tick since last update. Call inside camera mode
+void ProjectileSystemDraw(ProjectileSystem *ps, float alpha);
+
+#endif // !PROJECTILES_H_
@@ -0,0 +1,196 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raylib.h"
+#include "rlgl.h"
+#include "render_queue.h"
+#include "sprites.h"
+
+void RenderQueueInit(RenderQueue *rq, uint32_t capacity) {
+	*rq = (RenderQueue){0};
+	rq->capacity = capacity;
+
+	rq->cmds = malloc(sizeof(RenderCmd) * capacity);
+	rq->keys = malloc(sizeof(uint32_t) * capacity);
+	rq->order = malloc(sizeof(uint32_t) * capacity);
+	rq->tmp_keys = malloc(sizeof(uint32_t) * capacity);
+	rq->tmp_order = malloc(sizeof(uint32_t) * capacity);
+
+	// Start empty if out of memory, first sprite tries again
+	if(!rq->cmds || !rq->keys || !rq->order || !rq->tmp_keys || !rq->tmp_order) RenderQueueClose(rq);
+}
+
+void RenderQueueClose(RenderQueue *rq) {
+	free(rq->cmds);
+	free(rq->keys);
+	free(rq->order);
+	free(rq->tmp_keys);
+	free(rq->tmp_order);
+
+	*rq = (RenderQueue){0};
+}
+
+// Double queue capacity, queue only stores indices so nothing points into it.
+// Arrays that did grow are kept if a later one fails, capacity only changes once all have. Returns false if out of memory
+static bool RenderQueueGrow(RenderQueue *rq) {
+	uint32_t capacity = (rq->capacity) ? rq->capacity * 2 : RQ_DEFAULT_CAPACITY;
+
+	RenderCmd *cmds = realloc(rq->cmds, sizeof(RenderCmd) * capacity);
+	if(!cmds) return false;
+	rq->cmds = cmds;
+
+	uint32_t **arrays[] = { &rq->keys, &rq->order, &rq->tmp_keys, &rq->tmp_order };
+	for(uint32_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++) {
+		uint32_t *array = realloc(*arrays[i], sizeof(uint32_t) * capacity);
+		if(!array) return false;
+		*arrays[i] = array;
+	}
+
+	rq->capacity = capacity;
+	return true;
+}
+
+void RenderQueueSprite(RenderQueue *rq, Spritesheet *spritesheet, uint8_t frame_index, Vector2 position, float rotation, uint8_t flags, uint8_t layer) {
+	if(!(spritesheet->flags & SPR_TEX_VALID)) return;
+
+	// Sprite is dropped if queue is full and can't grow
+	if(rq->count >= rq->capacity && !RenderQueueGrow(rq)) return;
+
+	Texture2D tex = spritesheet->texture;
+	uint32_t i = rq->count++;
+
+	rq->cmds[i] = (RenderCmd) {
+		.texture_id = tex.id,
+		.tex_w = tex.width,
+		.tex_h = tex.height,
+		.src = GetFrameRec(frame_index, spritesheet),
+		.center = { position.x + spritesheet->frame_w * 0.5f, position.y + spritesheet->frame_h * 0.5f },
+		.size = { spritesheet->frame_w, spritesheet->frame_h },
+		.rotation = rotation,
+		.layer = layer,
+		.flags = flags
+	};
+
+	// Sort by layer first, then texture so sprites sharing a texture end up next to each other
+	rq->keys[i] = ((uint32_t)layer << 24) | (tex.id & 0x00ffffff);
+	rq->order[i] = i;
+}
+
+void RenderQueueAnim(RenderQueue *rq, SpriteAnimation *anim, Vector2 position, float rotation, uint8_t flags, uint8_t layer) {
+	RenderQueueSprite(rq, anim->spritesheet, anim->cur_frame, position, rotation, flags, layer);
+}
+
+// Stable LSD radix sort of command indices by key, 8 bits per pass,
+// passes where every key shares the same digit are skipped
+static void RenderQueueSort(RenderQueue *rq) {
+	uint32_t n = rq->count;
+
+	for(uint32_t shift = 0; shift < 32; shift += 8) {
+		uint32_t hist[256] = {0};
+		for(uint32_t i = 0; i < n; i++) hist[(rq->keys[i] >> shift) & 0xff]++;
+
+		// All keys fall into one bucket, order wouldn't change
+		if(hist[(rq->keys[0] >> shift) & 0xff] == n) continue;
+
+		// Prefix sum to bucket offsets
+		uint32_t sum = 0;
+		for(uint32_t b = 0; b < 256; b++) {
+			uint32_t c = hist[b];
+			hist[b] = sum;
+			sum += c;
+		}
+
+		for(uint32_t i = 0; i < n; i++) {
+			uint32_t dst = hist[(rq->keys[i] >> shift) & 0xff]++;
+			rq->tmp_keys[dst] = rq->keys[i];
+			rq->tmp_order[dst] = rq->order[i];
+		}
+
+		// Swap buffers
+		uint32_t *t = rq->keys; rq->keys = rq->tmp_keys; rq->tmp_keys = t;
+		t = rq->order; rq->order = rq->tmp_order; rq->tmp_order = t;
+	}
+}
+
+// Write one sprite's quad to current batch, same vertex layout as DrawTexturePro
+static void RenderQueueEmit(RenderCmd *cmd) {
+	float w = cmd->tex_w, h = cmd->tex_h;
+	Rectangle src = cmd->src;
+
+	bool flip_x = (cmd->flags & SPR_FLIP_X);
+	if(cmd->flags & SPR_FLIP_Y) {
+		src.y += src.height;
+		src.height *= -1;
+	}
+
+	// Corner offsets from center, rotated
+	float hw = cmd->size.x * 0.5f, hh = cmd->size.y * 0.5f;
+	float s = 0, c = 1;
+	if(cmd->rotation != 0.0f) {
+		s = sinf(cmd->rotation * DEG2RAD);
+		c = cosf(cmd->rotation * DEG2RAD);
+	}
+
+	Vector2 top_left     = { cmd->center.x + (-hw * c - -hh * s), cmd->center.y + (-hw * s + -hh * c) };
+	Vector2 top_right    = { cmd->center.x + ( hw * c - -hh * s), cmd->center.y + ( hw * s + -hh * c) };
+	Vector2 bottom_left  = { cmd->center.x + (-hw * c -  hh * s), cmd->center.y + (-hw * s +  hh * c) };
+	Vector2 bottom_right = { cmd->center.x + ( hw * c -  hh * s), cmd->center.y + ( hw * s +  hh * c) };
+
+	float u0 = src.x / w, u1 = (src.x + src.width) / w;
+	float v0 = src.y / h, v1 = (src.y + src.height) / h;
+	if(flip_x) {
+		float t = u0; u0 = u1; u1 = t;
+	}
+
+	rlTexCoord2f(u0, v0);
+	rlVertex2f(top_left.x, top_left.y);
+
+	rlTexCoord2f(u0, v1);
+	rlVertex2f(bottom_left.x, bottom_left.y);
+
+	rlTexCoord2f(u1, v1);
+	rlVertex2f(bottom_right.x, bottom_right.y);
+
+	rlTexCoord2f(u1, v0);
+	rlVertex2f(top_right.x, top_right.y);
+}
+
+void RenderQueueFlush(RenderQueue *rq) {
+	rq->stats = (RenderStats){0};
+	if(rq->count == 0) return;
+
+	RenderQueueSort(rq);
+
+	uint32_t bound_texture = 0;
+	bool drawing = false;
+
+	for(uint32_t i = 0; i < rq->count; i++) {
+		RenderCmd *cmd = &rq->cmds[rq->order[i]];
+
+		// Start a new run on texture change, rlgl submits current batch when texture switches
+		if(!drawing || cmd->texture_id != bound_texture) {
+			if(drawing) rlEnd();
+
+			bound_texture = cmd->texture_id;
+			rlSetTexture(bound_texture);
+			rlBegin(RL_QUADS);
+			rlColor4ub(255, 255, 255, 255);
+			rlNormal3f(0.0f, 0.0f, 1.0f);
+
+			drawing = true;
+			rq->stats.draw_calls++;
+		}
+
+		// Vertex buffer full, rlgl draws what it has and keeps texture and mode
+		if(rlCheckRenderBatchLimit(4)) rq->stats.batch_flushes++;
+
+		RenderQueueEmit(cmd);
+		rq->stats.sprites++;
+	}
+
+	rlEnd();
+	rlSetTexture(0);
+
+	rq->count = 0;
+}
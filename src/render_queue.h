@@ -0,0 +1,63 @@
+#ifndef RENDER_QUEUE_H_
+#define RENDER_QUEUE_H_
+
+#include <stdint.h>
+#include "raylib.h"
+#include "sprites.h"
+
+#define RQ_DEFAULT_CAPACITY	4096
+
+// Draw layers, lower layers are drawn first
+enum RENDER_LAYERS {
+	LAYER_BACKGROUND,
+	LAYER_BODIES,
+	LAYER_ACTORS,
+	LAYER_PLAYER,
+	LAYER_FX
+};
+
+// Compact sprite draw record
+typedef struct {
+	uint32_t texture_id;
+	uint16_t tex_w, tex_h;		// Texture dimensions, used for texture coordinates
+
+	Rectangle src;				// Source rectangle in texture
+	Vector2 center;				// Destination center, sprites rotate around it
+	Vector2 size;				// Destination size
+	float rotation;				// Rotation in degrees
+
+	uint8_t layer;
+	uint8_t flags;				// SPR_FLIP_X, SPR_FLIP_Y
+} RenderCmd;
+
+// Counters from last flush
+typedef struct {
+	uint32_t sprites;			// Sprites submitted
+	uint32_t draw_calls;		// Texture runs, each one ends up as a draw call
+	uint32_t batch_flushes;		// Extra draws caused by filling rlgl's vertex buffer
+} RenderStats;
+
+typedef struct {
+	uint32_t capacity;
+	uint32_t count;
+
+	RenderCmd *cmds;
+
+	// Packed sort keys and command indices, plus scratch arrays for radix sort
+	uint32_t *keys, *order;
+	uint32_t *tmp_keys, *tmp_order;
+
+	RenderStats stats;
+} RenderQueue;
+
+void RenderQueueInit(RenderQueue *rq, uint32_t capacity);
+void RenderQueueClose(RenderQueue *rq);
+
+// Add a sprite to queue, same arguments as DrawSpritePro plus a layer
+void RenderQueueSprite(RenderQueue *rq, Spritesheet *spritesheet, uint8_t frame_index, Vector2 position, float rotation, uint8_t flags, uint8_t layer);
+void RenderQueueAnim(RenderQueue *rq, SpriteAnimation *anim, Vector2 position, float rotation, uint8_t flags, uint8_t layer);
+
+// Sort queued sprites by layer and texture, submit them and clear queue
+void RenderQueueFlush(RenderQueue *rq);
+
+#endif // !RENDER_QUEUE_H_
@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdint.h>
+#include "replay.h"
+#include "input.h"
+
+static inline int8_t ClampAxis(short value) {
+	return (value < -128) ? -128 : (value > 127) ? 127 : value;
+}
+
+bool ReplayRecordStart(Replay *rp, const char *path, ReplayHeader header) {
+	*rp = (Replay){0};
+
+	rp->file = fopen(path, "wb");
+	if(!rp->file) {
+		printf("ERROR: Could not write replay: %s\n", path);
+		return false;
+	}
+
+	header.magic = REPLAY_MAGIC;
+	header.version = REPLAY_VERSION;
+	header.tick_count = 0;
+	rp->header = header;
+
+	fwrite(&rp->header, sizeof(ReplayHeader), 1, rp->file);
+	rp->mode = REPLAY_RECORD;
+
+	printf("recording replay to: %s\n", path);
+	return true;
+}
+
+bool ReplayPlayStart(Replay *rp, const char *path) {
+	*rp = (Replay){0};
+
+	rp->file = fopen(path, "rb");
+	if(!rp->file) {
+		printf("ERROR: Could not open replay: %s\n", path);
+		return false;
+	}
+
+	if(fread(&rp->header, sizeof(ReplayHeader), 1, rp->file) != 1 ||
+		rp->header.magic != REPLAY_MAGIC || rp->header.version != REPLAY_VERSION) {
+		printf("ERROR: Invalid replay: %s\n", path);
+		fclose(rp->file);
+		rp->file = NULL;
+		return false;
+	}
+
+	rp->mode = REPLAY_PLAY;
+
+	printf("playing replay: %s (%u ticks, seed %u, %u bodies)\n",
+		path, rp->header.tick_count, rp->header.seed, rp->header.bodies);
+	return true;
+}
+
+void ReplayClose(Replay *rp) {
+	if(!rp->file) return;
+
+	if(rp->mode == REPLAY_RECORD) {
+		// Tick count goes back into header
+		rp->header.tick_count = rp->tick;
+		fseek(rp->file, 0, SEEK_SET);
+		fwrite(&rp->header, sizeof(ReplayHeader), 1, rp->file);
+		printf("replay recorded: %u ticks\n", rp->tick);
+	}
+
+	if(rp->mode == REPLAY_PLAY) {
+		if(rp->mismatches)
+			printf("replay DIVERGED: %u of %u ticks mismatched, first at tick %u\n", rp->mismatches, rp->tick, rp->first_mismatch);
+		else
+			printf("replay matched: %u ticks\n", rp->tick);
+	}
+
+	fclose(rp->file);
+	rp->file = NULL;
+	rp->mode = REPLAY_OFF;
+}
+
+void ReplayRecordTick(Replay *rp, const InputState *input, float dt, uint32_t hash) {
+	if(rp->mode != REPLAY_RECORD) return;
+
+	ReplayTick tick = {
+		.dt = dt,
+		.move_x = ClampAxis(input->move_x),
+		.move_y = ClampAxis(input->move_y),
+		.look_x = ClampAxis(input->look_x),
+		.look_y = ClampAxis(input->look_y),
+		.buttons = (input->jump ? REPLAY_BTN_JUMP : 0) | (input->shoot ? REPLAY_BTN_SHOOT : 0) |
+			(input->interact ? REPLAY_BTN_INTERACT : 0) | (input->pause ? REPLAY_BTN_PAUSE : 0),
+		.hash = hash
+	};
+
+	fwrite(&tick, sizeof(ReplayTick), 1, rp->file);
+	rp->tick++;
+}
+
+bool ReplayNextTick(Replay *rp) {
+	if(rp->mode != REPLAY_PLAY) return false;
+	return (fread(&rp->current, sizeof(ReplayTick), 1, rp->file) == 1);
+}
+
+void ReplayApplyInput(Replay *rp, InputState *state) {
+	ReplayTick *tick = &rp->current;
+
+	state->move_x = tick->move_x;
+	state->move_y = tick->move_y;
+	state->look_x = tick->look_x;
+	state->look_y = tick->look_y;
+
+	state->jump = (tick->buttons & REPLAY_BTN_JUMP);
+	state->shoot = (tick->buttons & REPLAY_BTN_SHOOT);
+	state->interact = (tick->buttons & REPLAY_BTN_INTERACT);
+	state->pause = (tick->buttons & REPLAY_BTN_PAUSE);
+}
+
+bool ReplayCheckTick(Replay *rp, uint32_t hash) {
+	bool match = (hash == rp->current.hash);
+
+	if(!match) {
+		if(rp->mismatches == 0) {
+			rp->first_mismatch = rp->tick;
+			printf("replay diverged at tick %u: hash %08x, recorded %08x\n", rp->tick, hash, rp->current.hash);
+		}
+		rp->mismatches++;
+	}
+
+	rp->tick++;
+	return match;
+}
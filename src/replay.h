@@ -0,0 +1,87 @@
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "input.h"
+
+// Input replay:
+// a log of every gameplay tick's input, dt and entity state hash after the tick.
+// Playing a log back feeds it's input through ProcessInput instead of polling devices,
+// hashes are compared each tick so any divergence from the recorded run is caught on the tick it happens
+
+#define REPLAY_MAGIC	0x59504C52		// "RLPY"
+#define REPLAY_VERSION	3
+
+// Button bits of a tick
+#define REPLAY_BTN_JUMP		0x01
+#define REPLAY_BTN_SHOOT	0x02
+#define REPLAY_BTN_INTERACT	0x04
+#define REPLAY_BTN_PAUSE	0x08
+
+// Scene flags of header
+#define REPLAY_WORLD_STREAM	0x01	// Asteroid field streamed around camera, seeded with header's seed
+#define REPLAY_STREAM_TOUR	0x02	// Stream center circles the player by tick index, headless recordings only
+
+enum REPLAY_MODES {
+	REPLAY_OFF,
+	REPLAY_RECORD,
+	REPLAY_PLAY
+};
+
+// Scene setup of recorded run, playback rebuilds it before the first tick
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t seed;				// Headless asteroid field seed, also world seed if streaming
+	uint32_t bodies;			// Asteroids spawned before first tick, 0 for none
+	uint32_t flags;				// REPLAY_WORLD_STREAM, REPLAY_STREAM_TOUR
+	float tick_rate;
+	uint32_t tick_count;		// Filled in when recording is closed, playback runs to end of file
+} ReplayHeader;
+
+// One gameplay tick, 16 bytes
+typedef struct {
+	float dt;
+	int8_t move_x, move_y;
+	int8_t look_x, look_y;
+	uint8_t buttons;			// REPLAY_BTN_* bits
+	uint8_t pad[3];
+	uint32_t hash;				// EntHandlerHash after tick
+} ReplayTick;
+
+typedef struct Replay {
+	uint8_t mode;
+	FILE *file;
+	ReplayHeader header;
+
+	uint32_t tick;				// Ticks recorded, or played so far
+	ReplayTick current;			// Tick being played
+
+	uint32_t mismatches;		// Ticks whose hash didn't match recording
+	uint32_t first_mismatch;	// Tick of first mismatch, only valid if mismatches > 0
+} Replay;
+
+// Open log for writing, header's seed, bodies and tick rate describe the scene
+bool ReplayRecordStart(Replay *rp, const char *path, ReplayHeader header);
+
+// Open log for playback, header is read into rp->header
+bool ReplayPlayStart(Replay *rp, const char *path);
+
+// Finish log, recording writes final tick count, playback prints mismatch summary
+void ReplayClose(Replay *rp);
+
+// Append a tick, input is the state the tick ran with
+void ReplayRecordTick(Replay *rp, const InputState *input, float dt, uint32_t hash);
+
+// Playback, load next tick into rp->current, false at end of log
+bool ReplayNextTick(Replay *rp);
+
+// Playback, copy current tick's input into state
+void ReplayApplyInput(Replay *rp, InputState *state);
+
+// Playback, compare state hash after current tick with recorded one, false on mismatch
+bool ReplayCheckTick(Replay *rp, uint32_t hash);
+
+#endif // !REPLAY_H_
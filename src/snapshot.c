@@ -0,0 +1,758 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "snapshot.h"
+#include "ent_handler.h"
+#include "entity.h"
+#include "projectiles.h"
+#include "world.h"
+
+// Byte offsets of each state section, in the order they are stored
+typedef struct {
+	uint32_t active;						// Active list, count ids
+	uint32_t free_lists;					// Free slot stacks of entity, type data and orbit pools
+	uint32_t chunks;						// Entity chunks covering slots below ent_top
+	uint32_t type_data[ENT_TYPE_COUNT];		// data_top elements of each type
+	uint32_t orbit_data;					// orbit_top elements
+	uint32_t grid_head;						// GRID_BUCKETS bucket heads
+	uint32_t grid_links;					// ent_top links
+	uint32_t projectiles;					// SNAP_PROJECTILE_FIELDS arrays of projectile_count words
+	uint32_t world_resident;				// Resident chunks
+	uint32_t world_records;					// Records, body pointers cleared
+	uint32_t world_bodies;					// Bodies of each record in record order
+	uint32_t end;
+} SnapSections;
+
+// Projectile arrays stored, in order: pos_x, pos_y, vel_x, vel_y, radius, life, owner
+#define SNAP_PROJECTILE_FIELDS	7
+
+// Spans a delta is encoded in: header, active, free lists, chunks, type data, orbit data, grid head, grid links,
+// each projectile array and the three world sections
+#define SNAP_DELTA_SPANS		(ENT_TYPE_COUNT + SNAP_PROJECTILE_FIELDS + 10)
+
+// Pointers cleared from type data on save, and set again from the handler on restore
+typedef void (*SnapUnlinkFunc)(void *data);
+typedef void (*SnapRelinkFunc)(EntHandler *handler, Entity *ent);
+
+static void UnlinkPlayer(void *data) {
+	PlayerData *p = data;
+	p->camera = NULL;
+	p->input = NULL;
+	p->particles = NULL;
+	p->projectiles = NULL;
+	p->run_anim = NULL;
+}
+
+// Same links PlayerInit makes, input, particles and projectiles are the ones handler gives new players
+static void RelinkPlayer(EntHandler *handler, Entity *ent) {
+	PlayerData *p = ent->data;
+	p->camera = handler->camera;
+	p->input = handler->input;
+	p->particles = handler->particles;
+	p->projectiles = handler->projectiles;
+	p->run_anim = &handler->sprite_loader->anims[0];
+
+	handler->player = EntGetHandle(handler, ent->id);
+}
+
+// Types whose data holds pointers, NULL for plain data
+static SnapUnlinkFunc snap_unlink_funcs[] = { &UnlinkPlayer, NULL, NULL, NULL };
+static SnapRelinkFunc snap_relink_funcs[] = { &RelinkPlayer, NULL, NULL, NULL };
+
+static inline uint32_t HashWord(uint32_t hash, uint32_t word) {
+	return (hash ^ word) * 16777619u;
+}
+
+static inline uint64_t Align8(uint64_t n) {
+	return (n + 7) & ~(uint64_t)7;
+}
+
+// Sizes of everything copied as raw bytes, a snapshot from a build with different structs can't be read
+static uint32_t LayoutHash(EntHandler *handler) {
+	uint32_t hash = HashWord(2166136261u, sizeof(EntChunk));
+	hash = HashWord(hash, ENT_CHUNK_SIZE);
+	hash = HashWord(hash, sizeof(OrbitData));
+	hash = HashWord(hash, sizeof(GridLink));
+	hash = HashWord(hash, GRID_BUCKETS);
+	hash = HashWord(hash, sizeof(WorldChunk));
+	hash = HashWord(hash, sizeof(WorldRecord));
+	hash = HashWord(hash, sizeof(WorldBody));
+
+	for(uint8_t t = 0; t < ENT_TYPE_COUNT; t++) hash = HashWord(hash, handler->type_data[t].elem_size);
+
+	return hash;
+}
+
+// Lay out sections for header's counts, false if snapshot would be over 4 GiB
+static bool SnapSectionsOf(const SnapshotHeader *header, SnapSections *sec) {
+	uint64_t offset = Align8(sizeof(SnapshotHeader));
+	uint64_t chunk_count = ((uint64_t)header->ent_top + ENT_CHUNK_SIZE - 1) >> ENT_CHUNK_BITS;
+
+	uint64_t free_count = (uint64_t)header->ent_free + header->orbit_free;
+	for(uint8_t t = 0; t < ENT_TYPE_COUNT; t++) free_count += header->data_free[t];
+
+	sec->active = offset;
+	offset = Align8(offset + (uint64_t)header->count * sizeof(uint32_t));
+
+	sec->free_lists = offset;
+	offset = Align8(offset + free_count * sizeof(uint32_t));
+
+	sec->chunks = offset;
+	offset += chunk_count * sizeof(EntChunk);
+
+	for(uint8_t t = 0; t < ENT_TYPE_COUNT; t++) {
+		offset = Align8(offset);
+		sec->type_data[t] = offset;
+		offset += (uint64_t)header->data_top[t] * header->data_elem_size[t];
+	}
+
+	offset = Align8(offset);
+	sec->orbit_data = offset;
+	offset = Align8(offset + (uint64_t)header->orbit_top * sizeof(OrbitData));
+
+	sec->grid_head = offset;
+	offset += GRID_BUCKETS * sizeof(int32_t);
+
+	sec->grid_links = offset;
+	offset = Align8(offset + (uint64_t)header->ent_top * sizeof(GridLink));
+
+	sec->projectiles = offset;
+	offset = Align8(offset + (uint64_t)header->projectile_count * SNAP_PROJECTILE_FIELDS * sizeof(uint32_t));
+
+	sec->world_resident = offset;
+	offset = Align8(offset + (uint64_t)header->world_resident * sizeof(WorldChunk));
+
+	sec->world_records = offset;
+	offset = Align8(offset + (uint64_t)header->world_records * sizeof(WorldRecord));
+
+	sec->world_bodies = offset;
+	offset = Align8(offset + (uint64_t)header->world_record_bodies * sizeof(WorldBody));
+
+	if(offset > UINT32_MAX) return false;
+
+	sec->end = offset;
+	return true;
+}
+
+static bool SnapshotReserve(Snapshot *snap, uint32_t size) {
+	if(size <= snap->cap) return true;
+
+	// malloc alignment covers the 8 bytes sections need
+	uint8_t *data = realloc(snap->data, size);
+	if(!data) return false;
+
+	snap->data = data;
+	snap->cap = size;
+	return true;
+}
+
+// Projectile arrays in SNAP_PROJECTILE_FIELDS order, all 4 byte elements
+static void ProjectileFields(ProjectileSystem *ps, void *fields[SNAP_PROJECTILE_FIELDS]) {
+	fields[0] = ps->pos_x;
+	fields[1] = ps->pos_y;
+	fields[2] = ps->vel_x;
+	fields[3] = ps->vel_y;
+	fields[4] = ps->radius;
+	fields[5] = ps->life;
+	fields[6] = ps->owner;
+}
+
+// Copy first count elements of an arena into contiguous memory
+static void ArenaCopyOut(ChunkArena *arena, uint8_t *dst, uint32_t count) {
+	uint32_t per_chunk = 1u << arena->chunk_bits;
+
+	for(uint32_t c = 0; count > 0; c++) {
+		uint32_t n = (count < per_chunk) ? count : per_chunk;
+		memcpy(dst, arena->chunks[c], n * arena->elem_size);
+
+		dst += n * arena->elem_size;
+		count -= n;
+	}
+}
+
+// Copy contiguous elements into the first count elements of an arena, arena must hold count elements
+static void ArenaCopyIn(ChunkArena *arena, const uint8_t *src, uint32_t count) {
+	uint32_t per_chunk = 1u << arena->chunk_bits;
+
+	for(uint32_t c = 0; count > 0; c++) {
+		uint32_t n = (count < per_chunk) ? count : per_chunk;
+		memcpy(arena->chunks[c], src, n * arena->elem_size);
+
+		src += n * arena->elem_size;
+		count -= n;
+	}
+}
+
+bool SnapshotSave(EntHandler *handler, Snapshot *snap) {
+	SnapshotHeader header = {
+		.magic = SNAPSHOT_MAGIC,
+		.version = SNAPSHOT_VERSION,
+		.layout = LayoutHash(handler),
+		.count = handler->count,
+		.max_radius = handler->max_radius,
+		.max_body_radius = handler->max_body_radius,
+		.grid_count = handler->grid.count,
+		.ent_top = handler->ent_pool.top,
+		.ent_free = handler->ent_pool.free_count,
+		.orbit_top = handler->orbit_pool.top,
+		.orbit_free = handler->orbit_pool.free_count,
+		.projectile_count = (handler->projectiles) ? handler->projectiles->count : 0
+	};
+
+	World *world = handler->world;
+	if(world) {
+		header.world_seed = world->seed;
+		header.world_resident = world->resident_count;
+		header.world_records = world->record_count;
+		header.world_record_bodies = world->record_bytes / sizeof(WorldBody);
+	}
+
+	for(uint8_t t = 0; t < ENT_TYPE_COUNT; t++) {
+		header.type_counts[t] = handler->type_counts[t];
+		header.data_top[t] = handler->data_pools[t].top;
+		header.data_free[t] = handler->data_pools[t].free_count;
+		header.data_elem_size[t] = handler->type_data[t].elem_size;
+	}
+
+	SnapSections sec;
+	if(!SnapSectionsOf(&header, &sec) || !SnapshotReserve(snap, sec.end)) return false;
+
+	header.size = sec.end;
+	uint8_t *out = snap->data;
+	memset(out, 0, sec.active);
+	memcpy(out, &header, sizeof(header));
+
+	if(handler->count) memcpy(out + sec.active, handler->active, handler->count * sizeof(uint32_t));
+
+	// Free stacks in pool order: entities, each type's data, orbits
+	uint8_t *free_out = out + sec.free_lists;
+	SlotPool *pools[ENT_TYPE_COUNT + 2];
+	pools[0] = &handler->ent_pool;
+	for(uint8_t t = 0; t < ENT_TYPE_COUNT; t++) pools[1 + t] = &handler->data_pools[t];
+	pools[ENT_TYPE_COUNT + 1] = &handler->orbit_pool;
+
+	for(uint8_t i = 0; i < ENT_TYPE_COUNT + 2; i++) {
+		if(pools[i]->free_count) memcpy(free_out, pools[i]->free_slots, pools[i]->free_count * sizeof(uint32_t));
+		free_out += pools[i]->free_count * sizeof(uint32_t);
+	}
+
+	// Chunks are copied whole, then pointers are cleared so snapshots of equal state are equal
+	EntChunk *chunks_out = (EntChunk*)(out + sec.chunks);
+	uint32_t chunk_count = (header.ent_top + ENT_CHUNK_SIZE - 1) >> ENT_CHUNK_BITS;
+
+	for(uint32_t c = 0; c < chunk_count; c++) {
+		EntChunk *chunk = &chunks_out[c];
+		memcpy(chunk, handler->chunks.chunks[c], sizeof(EntChunk));
+
+		for(uint32_t i = 0; i < ENT_CHUNK_SIZE; i++) {
+			Entity *ent = &chunk->ents[i];
+			if((chunk->hot.flags[i] & ENT_ACTIVE) && !ent->orbit) ent->orbit_id = SNAPSHOT_NO_ORBIT;
+
+			ent->hot = NULL;
+			ent->orbit = NULL;
+			ent->data = NULL;
+		}
+	}
+
+	for(uint8_t t = 0; t < ENT_TYPE_COUNT; t++)
+		ArenaCopyOut(&handler->type_data[t], out + sec.type_data[t], header.data_top[t]);
+
+	ArenaCopyOut(&handler->orbit_data, out + sec.orbit_data, header.orbit_top);
+
+	// Clear pointers out of type data copies
+	for(uint32_t i = 0; i < handler->count; i++) {
+		Entity *ent = EntAt(handler, handler->active[i]);
+		uint8_t type = ENT_TYPEOF(ent);
+		if(!snap_unlink_funcs[type]) continue;
+
+		snap_unlink_funcs[type](out + sec.type_data[type] + (size_t)ent->data_id * handler->type_data[type].elem_size);
+	}
+
+	// Grid is stored as is, query order after restore matches the saved world's
+	memcpy(out + sec.grid_head, handler->grid.head, GRID_BUCKETS * sizeof(int32_t));
+	if(header.ent_top) memcpy(out + sec.grid_links, handler->grid.links, header.ent_top * sizeof(GridLink));
+
+	// Projectiles array by array, hits and stats are results of last update and aren't state
+	if(header.projectile_count) {
+		void *fields[SNAP_PROJECTILE_FIELDS];
+		ProjectileFields(handler->projectiles, fields);
+
+		size_t bytes = header.projectile_count * sizeof(uint32_t);
+		for(uint32_t f = 0; f < SNAP_PROJECTILE_FIELDS; f++) memcpy(out + sec.projectiles + f * bytes, fields[f], bytes);
+	}
+
+	// Resident chunks hold entity handles, records are packed in table order with their bodies after them
+	if(world) {
+		if(header.world_resident) memcpy(out + sec.world_resident, world->resident, header.world_resident * sizeof(WorldChunk));
+
+		WorldRecord *records_out = (WorldRecord*)(out + sec.world_records);
+		WorldBody *bodies_out = (WorldBody*)(out + sec.world_bodies);
+
+		for(uint32_t i = 0; i < world->record_cap; i++) {
+			WorldRecord *rec = &world->records[i];
+			if(!rec->used) continue;
+
+			*records_out = *rec;
+			(records_out++)->bodies = NULL;
+
+			memcpy(bodies_out, rec->bodies, rec->body_count * sizeof(WorldBody));
+			bodies_out += rec->body_count;
+		}
+	}
+
+	snap->size = sec.end;
+	return true;
+}
+
+// Check ids and counts stored in snapshot before any of it is used as an index
+static bool SnapshotValidate(EntHandler *handler, const SnapshotHeader *header, const SnapSections *sec, const uint8_t *data) {
+	uint32_t type_total = 0;
+	for(uint8_t t = 0; t < ENT_TYPE_COUNT; t++) {
+		if(header->type_counts[t] > header->data_top[t] || header->data_top[t] > handler->data_pools[t].cap) return false;
+		if(header->data_free[t] > header->data_top[t]) return false;
+		type_total += header->type_counts[t];
+	}
+
+	if(type_total != header->count || header->count > header->ent_top || header->ent_top > handler->ent_pool.cap) return false;
+	if(header->ent_free > header->ent_top || header->orbit_free > header->orbit_top || header->orbit_top > handler->orbit_pool.cap) return false;
+	if(header->grid_count < 0 || (uint32_t)header->grid_count > header->ent_top) return false;
+
+	uint32_t projectile_cap = (handler->projectiles) ? handler->projectiles->capacity : 0;
+	if(header->projectile_count > projectile_cap) return false;
+
+	if(!handler->world && (header->world_resident || header->world_records)) return false;
+	if(header->world_resident > WORLD_MAX_RESIDENT) return false;
+
+	const WorldChunk *resident = (const WorldChunk*)(data + sec->world_resident);
+	for(uint32_t i = 0; i < header->world_resident; i++)
+		if(resident[i].body_count > WORLD_BODIES_MAX) return false;
+
+	const WorldRecord *records = (const WorldRecord*)(data + sec->world_records);
+	uint64_t record_bodies = 0;
+	for(uint32_t i = 0; i < header->world_records; i++) {
+		if(!records[i].used || records[i].body_count > WORLD_BODIES_MAX) return false;
+		record_bodies += records[i].body_count;
+	}
+
+	if(record_bodies != header->world_record_bodies) return false;
+
+	const uint32_t *free_slots = (const uint32_t*)(data + sec->free_lists);
+	for(uint32_t i = 0; i < header->ent_free; i++)
+		if(*free_slots++ >= header->ent_top) return false;
+
+	for(uint8_t t = 0; t < ENT_TYPE_COUNT; t++) {
+		for(uint32_t i = 0; i < header->data_free[t]; i++)
+			if(*free_slots++ >= header->data_top[t]) return false;
+	}
+
+	for(uint32_t i = 0; i < header->orbit_free; i++)
+		if(*free_slots++ >= header->orbit_top) return false;
+
+	const uint32_t *active = (const uint32_t*)(data + sec->active);
+	const EntChunk *chunks = (const EntChunk*)(data + sec->chunks);
+
+	for(uint32_t i = 0; i < header->count; i++) {
+		uint32_t id = active[i];
+		if(id >= header->ent_top) return false;
+
+		const EntChunk *chunk = &chunks[id >> ENT_CHUNK_BITS];
+		const Entity *ent = &chunk->ents[id & ENT_CHUNK_MASK];
+		uint8_t type = chunk->hot.type[id & ENT_CHUNK_MASK];
+
+		if(!(chunk->hot.flags[id & ENT_CHUNK_MASK] & ENT_ACTIVE) || type >= ENT_TYPE_COUNT) return false;
+		if(ent->id != id || chunk->active_pos[id & ENT_CHUNK_MASK] != i || chunk->generation[id & ENT_CHUNK_MASK] == 0) return false;
+		if(ent->data_id >= header->data_top[type]) return false;
+		if(ent->orbit_id != SNAPSHOT_NO_ORBIT && ent->orbit_id >= header->orbit_top) return false;
+	}
+
+	// Grid lists only link ids with storage
+	int32_t top = header->ent_top;
+	const int32_t *head = (const int32_t*)(data + sec->grid_head);
+	for(uint32_t b = 0; b < GRID_BUCKETS; b++)
+		if(head[b] < GRID_NONE || head[b] >= top) return false;
+
+	const GridLink *links = (const GridLink*)(data + sec->grid_links);
+	for(int32_t i = 0; i < top; i++) {
+		if(links[i].next < GRID_NONE || links[i].next >= top) return false;
+		if(links[i].prev < GRID_NONE || links[i].prev >= top) return false;
+	}
+
+	return true;
+}
+
+// Grow pool's free stack to hold count slots
+static bool SlotPoolReserve(SlotPool *pool, uint32_t count) {
+	if(count <= pool->free_cap) return true;
+
+	uint32_t *slots = realloc(pool->free_slots, sizeof(uint32_t) * count);
+	if(!slots) return false;
+
+	pool->free_slots = slots;
+	pool->free_cap = count;
+	return true;
+}
+
+bool SnapshotRestore(EntHandler *handler, const uint8_t *data, uint32_t size) {
+	SnapshotHeader header;
+	if(size < sizeof(header)) return false;
+	memcpy(&header, data, sizeof(header));
+
+	if(header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION || header.flags != 0) return false;
+	if(header.layout != LayoutHash(handler) || header.size != size) return false;
+
+	for(uint8_t t = 0; t < ENT_TYPE_COUNT; t++)
+		if(header.data_elem_size[t] != handler->type_data[t].elem_size) return false;
+
+	SnapSections sec;
+	if(!SnapSectionsOf(&header, &sec) || sec.end != size) return false;
+	if(!SnapshotValidate(handler, &header, &sec, data)) return false;
+
+	// Grow storage before anything is overwritten, a failed restore leaves old state in place
+	SlotPool *pools[ENT_TYPE_COUNT + 2];
+	uint32_t tops[ENT_TYPE_COUNT + 2], frees[ENT_TYPE_COUNT + 2];
+
+	pools[0] = &handler->ent_pool;
+	tops[0] = header.ent_top;
+	frees[0] = header.ent_free;
+
+	for(uint8_t t = 0; t < ENT_TYPE_COUNT; t++) {
+		pools[1 + t] = &handler->data_pools[t];
+		tops[1 + t] = header.data_top[t];
+		frees[1 + t] = header.data_free[t];
+		if(!ArenaReserve(&handler->type_data[t], header.data_top[t])) return false;
+	}
+
+	pools[ENT_TYPE_COUNT + 1] = &handler->orbit_pool;
+	tops[ENT_TYPE_COUNT + 1] = header.orbit_top;
+	frees[ENT_TYPE_COUNT + 1] = header.orbit_free;
+
+	if(!EntHandlerReserve(handler, header.ent_top) || !ArenaReserve(&handler->orbit_data, header.orbit_top)) return false;
+	for(uint8_t i = 0; i < ENT_TYPE_COUNT + 2; i++)
+		if(!SlotPoolReserve(pools[i], frees[i])) return false;
+
+	// Records are the last thing that can fail, they're only replaced once they're all allocated
+	World *world = handler->world;
+	if(world && !WorldLoadRecords(world, (const WorldRecord*)(data + sec.world_records), header.world_records,
+		(const WorldBody*)(data + sec.world_bodies))) return false;
+
+	const uint8_t *free_in = data + sec.free_lists;
+	for(uint8_t i = 0; i < ENT_TYPE_COUNT + 2; i++) {
+		pools[i]->top = tops[i];
+		pools[i]->free_count = frees[i];
+		if(frees[i]) memcpy(pools[i]->free_slots, free_in, frees[i] * sizeof(uint32_t));
+		free_in += frees[i] * sizeof(uint32_t);
+	}
+
+	// Saved chunks replace live ones, chunks past them are cleared. Slots not live in the snapshot take a generation
+	// past both their saved and live ones, so handles from either never resolve to entities made after the restore
+	const EntChunk *chunks_in = (const EntChunk*)(data + sec.chunks);
+	uint32_t chunk_count = (header.ent_top + ENT_CHUNK_SIZE - 1) >> ENT_CHUNK_BITS;
+
+	for(uint32_t c = 0; c < handler->chunks.chunk_count; c++) {
+		EntChunk *chunk = handler->chunks.chunks[c];
+		uint16_t live_gen[ENT_CHUNK_SIZE];
+		memcpy(live_gen, chunk->generation, sizeof(live_gen));
+
+		if(c < chunk_count) memcpy(chunk, &chunks_in[c], sizeof(EntChunk));
+		else memset(chunk, 0, sizeof(EntChunk));
+
+		for(uint32_t i = 0; i < ENT_CHUNK_SIZE; i++) {
+			if(chunk->hot.flags[i] & ENT_ACTIVE) continue;
+
+			uint16_t gen = (chunk->generation[i] > live_gen[i]) ? chunk->generation[i] : live_gen[i];
+			if(gen == 0) continue;
+
+			gen = (gen + 1) & ENT_GEN_MASK;
+			chunk->generation[i] = (gen) ? gen : 1;
+		}
+	}
+
+	for(uint8_t t = 0; t < ENT_TYPE_COUNT; t++)
+		ArenaCopyIn(&handler->type_data[t], data + sec.type_data[t], header.data_top[t]);
+
+	ArenaCopyIn(&handler->orbit_data, data + sec.orbit_data, header.orbit_top);
+
+	handler->count = header.count;
+	if(header.count) memcpy(handler->active, data + sec.active, header.count * sizeof(uint32_t));
+
+	for(uint8_t t = 0; t < ENT_TYPE_COUNT; t++) handler->type_counts[t] = header.type_counts[t];
+
+	// Rebuild pointers of live entities from their ids and type, a saved player is found again here
+	handler->player = ENT_HANDLE_NONE;
+	for(uint32_t i = 0; i < handler->count; i++) {
+		uint32_t id = handler->active[i];
+		EntChunk *chunk = EntChunkOf(handler, id);
+		Entity *ent = &chunk->ents[id & ENT_CHUNK_MASK];
+		uint8_t type = chunk->hot.type[id & ENT_CHUNK_MASK];
+
+		ent->hot = &chunk->hot;
+		ent->data = ArenaAt(&handler->type_data[type], ent->data_id);
+
+		if(ent->orbit_id == SNAPSHOT_NO_ORBIT) {
+			ent->orbit_id = 0;
+			ent->orbit = NULL;
+		} else {
+			ent->orbit = ArenaAt(&handler->orbit_data, ent->orbit_id);
+		}
+
+		if(snap_relink_funcs[type]) snap_relink_funcs[type](handler, ent);
+	}
+
+	SpatialGrid *grid = &handler->grid;
+	grid->count = header.grid_count;
+	memcpy(grid->head, data + sec.grid_head, GRID_BUCKETS * sizeof(int32_t));
+
+	// Links are only allocated once the handler has storage
+	if(grid->capacity) {
+		memcpy(grid->links, data + sec.grid_links, header.ent_top * sizeof(GridLink));
+		memset(grid->links + header.ent_top, 0, (grid->capacity - header.ent_top) * sizeof(GridLink));
+	}
+
+	handler->max_radius = header.max_radius;
+	handler->max_body_radius = header.max_body_radius;
+
+	if(handler->projectiles) {
+		ProjectileSystem *ps = handler->projectiles;
+		void *fields[SNAP_PROJECTILE_FIELDS];
+		ProjectileFields(ps, fields);
+
+		size_t bytes = header.projectile_count * sizeof(uint32_t);
+		for(uint32_t f = 0; f < SNAP_PROJECTILE_FIELDS; f++) memcpy(fields[f], data + sec.projectiles + f * bytes, bytes);
+
+		ps->count = header.projectile_count;
+		ps->hit_count = 0;
+		ps->stats.live = ps->count;
+	}
+
+	if(world) {
+		world->seed = header.world_seed;
+		world->resident_count = header.world_resident;
+		if(header.world_resident) memcpy(world->resident, data + sec.world_resident, header.world_resident * sizeof(WorldChunk));
+	}
+
+	return true;
+}
+
+void SnapshotFree(Snapshot *snap) {
+	free(snap->data);
+	*snap = (Snapshot){0};
+}
+
+uint32_t SnapshotHash(const Snapshot *snap) {
+	const uint32_t *words = (const uint32_t*)snap->data;
+	uint32_t hash = HashWord(2166136261u, snap->size);
+
+	for(uint32_t i = 0; i < snap->size / sizeof(uint32_t); i++) hash = HashWord(hash, words[i]);
+	return hash;
+}
+
+// Start of each delta span in order, followed by the end of the snapshot. Spans are word multiples,
+// projectile arrays get their own so a changed projectile count doesn't shift the arrays after the first
+static void SnapDeltaSpans(const SnapshotHeader *header, const SnapSections *sec, uint32_t starts[SNAP_DELTA_SPANS + 1]) {
+	uint32_t n = 0;
+
+	starts[n++] = 0;
+	starts[n++] = sec->active;
+	starts[n++] = sec->free_lists;
+	starts[n++] = sec->chunks;
+	for(uint8_t t = 0; t < ENT_TYPE_COUNT; t++) starts[n++] = sec->type_data[t];
+	starts[n++] = sec->orbit_data;
+	starts[n++] = sec->grid_head;
+	starts[n++] = sec->grid_links;
+	for(uint32_t f = 0; f < SNAP_PROJECTILE_FIELDS; f++) starts[n++] = sec->projectiles + f * header->projectile_count * sizeof(uint32_t);
+	starts[n++] = sec->world_resident;
+	starts[n++] = sec->world_records;
+	starts[n++] = sec->world_bodies;
+	starts[n] = sec->end;
+}
+
+// Spans of a snapshot whose header is readable and lays out to it's size, false otherwise
+static bool SnapDeltaSpansOf(const Snapshot *snap, uint32_t starts[SNAP_DELTA_SPANS + 1]) {
+	SnapshotHeader header;
+	SnapSections sec;
+	if(snap->size < sizeof(header)) return false;
+
+	memcpy(&header, snap->data, sizeof(header));
+	if(header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION || !SnapSectionsOf(&header, &sec) || sec.end != snap->size) return false;
+
+	SnapDeltaSpans(&header, &sec, starts);
+	return true;
+}
+
+// Delta payload of one span: runs of {unchanged words, changed words, changed words xor base}.
+// Base words past the end of base's span count as zero, so spans that grew encode their new words as is.
+// Returns words written, out needs room for 3 words per span word
+static uint32_t DeltaEncode(const uint32_t *cur, uint32_t words, const uint32_t *base, uint32_t base_words, uint32_t *out) {
+	uint32_t *start = out;
+	uint32_t i = 0;
+
+	while(i < words) {
+		uint32_t same = 0;
+		while(i < words && cur[i] == ((i < base_words) ? base[i] : 0)) {
+			same++;
+			i++;
+		}
+
+		uint32_t first = i;
+		while(i < words && cur[i] != ((i < base_words) ? base[i] : 0)) i++;
+
+		*out++ = same;
+		*out++ = i - first;
+		for(uint32_t w = first; w < i; w++) *out++ = cur[w] ^ ((w < base_words) ? base[w] : 0);
+	}
+
+	return out - start;
+}
+
+// Rebuild one span from base's span and delta payload, advancing *r past it. False if payload runs past either buffer
+static bool DeltaDecode(const uint32_t *in, uint32_t in_words, uint32_t *r, const uint32_t *base, uint32_t base_words,
+	uint32_t words, uint32_t *out) {
+	uint32_t i = 0;
+
+	while(i < words) {
+		if(in_words - *r < 2) return false;
+		uint32_t same = in[(*r)++], changed = in[(*r)++];
+
+		if(same > words - i || changed > words - i - same || changed > in_words - *r) return false;
+
+		for(uint32_t w = 0; w < same; w++, i++) out[i] = (i < base_words) ? base[i] : 0;
+		for(uint32_t w = 0; w < changed; w++, i++) out[i] = in[(*r)++] ^ ((i < base_words) ? base[i] : 0);
+	}
+
+	return true;
+}
+
+bool SnapshotWrite(const Snapshot *snap, const Snapshot *base, const char *path) {
+	uint32_t starts[SNAP_DELTA_SPANS + 1], base_starts[SNAP_DELTA_SPANS + 1];
+
+	// Delta needs a base laid out like snapshot, otherwise snapshot is written whole
+	if(base && (!SnapDeltaSpansOf(snap, starts) || !SnapDeltaSpansOf(base, base_starts) ||
+		((const SnapshotHeader*)base->data)->layout != ((const SnapshotHeader*)snap->data)->layout)) {
+		printf("snapshot: base doesn't match layout, writing %s whole\n", path);
+		base = NULL;
+	}
+
+	const void *bytes = snap->data;
+	size_t size = snap->size;
+	uint32_t *delta = NULL;
+
+	if(base) {
+		uint32_t words = snap->size / sizeof(uint32_t);
+		delta = malloc(sizeof(SnapshotHeader) + (size_t)words * 3 * sizeof(uint32_t));
+		if(!delta) return false;
+
+		SnapshotHeader header;
+		memcpy(&header, snap->data, sizeof(header));
+		header.flags = SNAPSHOT_DELTA;
+		header.base_hash = SnapshotHash(base);
+		memcpy(delta, &header, sizeof(header));
+
+		// Header is stored as is, every other span against the base's span
+		uint32_t *payload = delta + sizeof(header) / sizeof(uint32_t);
+		uint32_t payload_words = 0;
+
+		for(uint32_t s = 1; s < SNAP_DELTA_SPANS; s++) {
+			const uint32_t *cur = (const uint32_t*)(snap->data + starts[s]);
+			const uint32_t *prev = (const uint32_t*)(base->data + base_starts[s]);
+
+			payload_words += DeltaEncode(cur, (starts[s + 1] - starts[s]) / sizeof(uint32_t), prev,
+				(base_starts[s + 1] - base_starts[s]) / sizeof(uint32_t), payload + payload_words);
+		}
+
+		bytes = delta;
+		size = sizeof(header) + (size_t)payload_words * sizeof(uint32_t);
+	}
+
+	FILE *pF = fopen(path, "wb");
+	if(!pF) {
+		printf("ERROR: Could not write snapshot: %s\n", path);
+		free(delta);
+		return false;
+	}
+
+	bool ok = (fwrite(bytes, 1, size, pF) == size);
+	if(fclose(pF) != 0) ok = false;
+	free(delta);
+
+	if(!ok) printf("ERROR: Failed writing snapshot: %s\n", path);
+	return ok;
+}
+
+bool SnapshotRead(Snapshot *snap, const Snapshot *base, const char *path) {
+	int fd = open(path, O_RDONLY);
+	if(fd < 0) {
+		printf("ERROR: Could not open snapshot: %s\n", path);
+		return false;
+	}
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SnapshotHeader) || st.st_size > UINT32_MAX) {
+		printf("ERROR: Invalid snapshot: %s\n", path);
+		close(fd);
+		return false;
+	}
+
+	uint32_t file_size = st.st_size;
+	uint8_t *map = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if(map == MAP_FAILED) return false;
+
+	SnapshotHeader header;
+	memcpy(&header, map, sizeof(header));
+
+	bool ok = (header.magic == SNAPSHOT_MAGIC && header.version == SNAPSHOT_VERSION && header.size % 8 == 0 &&
+		header.size >= sizeof(header) && SnapshotReserve(snap, header.size));
+
+	if(ok && !(header.flags & SNAPSHOT_DELTA)) {
+		// Whole snapshot, one bulk copy out of the mapping
+		ok = (header.size == file_size);
+		if(ok) memcpy(snap->data, map, file_size);
+	} else if(ok) {
+		// Delta only decodes against the snapshot it was written against, spans of both come from their headers
+		uint32_t starts[SNAP_DELTA_SPANS + 1], base_starts[SNAP_DELTA_SPANS + 1];
+		SnapSections sec;
+
+		ok = (base && SnapshotHash(base) == header.base_hash && file_size % 4 == 0 && SnapDeltaSpansOf(base, base_starts) &&
+			SnapSectionsOf(&header, &sec) && sec.end == header.size);
+
+		const uint32_t *payload = (const uint32_t*)(map + sizeof(header));
+		uint32_t payload_words = (file_size - sizeof(header)) / sizeof(uint32_t), r = 0;
+
+		if(ok) {
+			// Saved header never has delta fields set, padding after it is zero
+			SnapshotHeader saved = header;
+			saved.flags = 0;
+			saved.base_hash = 0;
+
+			memset(snap->data, 0, sec.active);
+			memcpy(snap->data, &saved, sizeof(saved));
+			SnapDeltaSpans(&header, &sec, starts);
+		}
+
+		for(uint32_t s = 1; ok && s < SNAP_DELTA_SPANS; s++) {
+			ok = DeltaDecode(payload, payload_words, &r, (const uint32_t*)(base->data + base_starts[s]),
+				(base_starts[s + 1] - base_starts[s]) / sizeof(uint32_t), (starts[s + 1] - starts[s]) / sizeof(uint32_t),
+				(uint32_t*)(snap->data + starts[s]));
+		}
+
+		// Every payload word belongs to a span
+		if(ok) ok = (r == payload_words);
+	}
+
+	munmap(map, file_size);
+
+	if(!ok) {
+		printf("ERROR: Invalid snapshot: %s\n", path);
+		return false;
+	}
+
+	snap->size = header.size;
+	return true;
+}
@@ -0,0 +1,79 @@
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ent_handler.h"
+
+// World snapshots:
+// the entity handler's full state (entity chunks, type and orbit data, slot pools, active list, grid, projectiles and world chunks)
+// copied section by section into one buffer. Pointers are cleared on save and rebuilt from ids and types on restore,
+// generations of live entities are kept so handles (anchors, raycast hits) stay valid across a round trip,
+// free slots move past any generation they had so handles made since the save go stale.
+// Files are written with a single write and read back through a mapping, optionally as a delta against an earlier snapshot.
+// Deltas are encoded section by section against the base's matching section, so counts changing between the two
+// only touch the sections they size
+
+#define SNAPSHOT_MAGIC		0x50414E53		// "SNAP"
+#define SNAPSHOT_VERSION	4
+
+// Snapshot file holds xor of state against a base snapshot, zero runs encoded
+#define SNAPSHOT_DELTA		0x01
+
+// Stored in orbit_id of entities without orbit data, orbit_id is otherwise only valid if orbit is set
+#define SNAPSHOT_NO_ORBIT	UINT32_MAX
+
+// Start of every snapshot, state sections follow in a fixed order, each 8 byte aligned
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t flags;						// SNAPSHOT_DELTA for delta files, 0 in memory
+	uint32_t size;						// Bytes of snapshot, including header
+	uint32_t layout;					// Hash of struct sizes, snapshots only load into the build that made them
+	uint32_t base_hash;					// Delta files, hash of base snapshot
+
+	uint32_t count;						// Live entities
+	uint32_t type_counts[ENT_TYPE_COUNT];
+	float max_radius, max_body_radius;
+	int32_t grid_count;
+
+	// Slots handed out and free slot counts of each pool: entities, type data, orbit data
+	uint32_t ent_top, ent_free;
+	uint32_t data_top[ENT_TYPE_COUNT], data_free[ENT_TYPE_COUNT];
+	uint32_t data_elem_size[ENT_TYPE_COUNT];	// Bytes of each type's data, sections can be laid out from header alone
+	uint32_t orbit_top, orbit_free;
+
+	uint32_t projectile_count;			// 0 if handler has no projectile system
+
+	// Streamed world, all 0 if handler has none
+	uint32_t world_seed;
+	uint32_t world_resident;			// Resident chunks
+	uint32_t world_records;				// Changed chunk records
+	uint32_t world_record_bodies;		// Bodies of all records
+} SnapshotHeader;
+
+typedef struct {
+	uint8_t *data;			// 8 byte aligned, starts with SnapshotHeader
+	uint32_t size;
+	uint32_t cap;
+} Snapshot;
+
+// Copy handler state into snapshot, buffer is reused and grown as needed
+bool SnapshotSave(EntHandler *handler, Snapshot *snap);
+
+// Replace handler state with snapshot's, handler must be initialized with the loaders and camera to relink to.
+// Data must be 8 byte aligned, handler is left untouched if snapshot is invalid
+bool SnapshotRestore(EntHandler *handler, const uint8_t *data, uint32_t size);
+
+void SnapshotFree(Snapshot *snap);
+
+// Hash of snapshot bytes, identifies a delta's base
+uint32_t SnapshotHash(const Snapshot *snap);
+
+// Write snapshot to file in a single write, as a delta if base is set and has the same layout
+bool SnapshotWrite(const Snapshot *snap, const Snapshot *base, const char *path);
+
+// Map snapshot file and copy or decode it into snap, delta files need the base they were written against
+bool SnapshotRead(Snapshot *snap, const Snapshot *base, const char *path);
+
+#endif // !SNAPSHOT_H_
@@ -0,0 +1,15 @@
+#include <stdio.h>
+#include "raylib.h"
+#include "sounds.h"
+
+void SoundLoaderClose(SoundLoader *snd) {
+	for(uint16_t i = 0; i < snd->snd_count; i++) {
+		if(!(snd->snd_flags[i] & SND_VALID)) continue;
+
+		printf("sound[%d] unloaded from sound pool\n", i);
+		UnloadSound(snd->snd_pool[i]);
+		snd->snd_flags[i] = 0;
+	}
+
+	snd->snd_count = 0;
+}
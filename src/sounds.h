@@ -0,0 +1,21 @@
+#ifndef SOUNDS_H_
+#define SOUNDS_H_
+
+#include <stdint.h>
+#include "raylib.h"
+
+#define SND_POOL_CAPACITY	255
+
+#define SND_VALID			0x01
+
+typedef struct {
+	uint8_t snd_count;
+
+	uint8_t snd_flags[SND_POOL_CAPACITY];
+	Sound snd_pool[SND_POOL_CAPACITY];
+} SoundLoader;
+
+// Unload every valid sound
+void SoundLoaderClose(SoundLoader *snd);
+
+#endif // !SOUNDS_H_
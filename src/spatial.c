@@ -0,0 +1,208 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raylib.h"
+#include "spatial.h"
+
+// Map cell coordinates to a bucket index
+static inline uint32_t CellHash(int32_t cx, int32_t cy) {
+	return ((uint32_t)cx * 73856093u ^ (uint32_t)cy * 19349663u) & (GRID_BUCKETS - 1);
+}
+
+static inline int32_t CellCoord(SpatialGrid *grid, float v) {
+	return (int32_t)floorf(v * grid->inv_cell_size);
+}
+
+// Initialize grid, allocate link data for provided number of items
+void GridInit(SpatialGrid *grid, float cell_size, int32_t capacity) {
+	grid->cell_size = cell_size;
+	grid->inv_cell_size = 1.0f / cell_size;
+	grid->capacity = capacity;
+	grid->count = 0;
+
+	for(uint32_t i = 0; i < GRID_BUCKETS; i++)
+		grid->head[i] = GRID_NONE;
+
+	grid->links = calloc(capacity, sizeof(GridLink));
+}
+
+// Free allocated link data
+void GridClose(SpatialGrid *grid) {
+	free(grid->links);
+	grid->links = NULL;
+	grid->capacity = 0;
+	grid->count = 0;
+}
+
+bool GridReserve(SpatialGrid *grid, int32_t capacity) {
+	if(capacity <= grid->capacity) return true;
+
+	GridLink *links = realloc(grid->links, sizeof(GridLink) * capacity);
+	if(!links) return false;
+
+	memset(links + grid->capacity, 0, sizeof(GridLink) * (capacity - grid->capacity));
+	grid->links = links;
+	grid->capacity = capacity;
+
+	return true;
+}
+
+// Link item into the bucket of it's cell
+static void GridLinkCell(SpatialGrid *grid, int32_t id, int32_t cx, int32_t cy) {
+	GridLink *link = &grid->links[id];
+	uint32_t bucket = CellHash(cx, cy);
+
+	link->cx = cx;
+	link->cy = cy;
+	link->prev = GRID_NONE;
+	link->next = grid->head[bucket];
+
+	if(link->next != GRID_NONE) grid->links[link->next].prev = id;
+	grid->head[bucket] = id;
+}
+
+// Unlink item from it's current bucket
+static void GridUnlinkCell(SpatialGrid *grid, int32_t id) {
+	GridLink *link = &grid->links[id];
+
+	if(link->prev != GRID_NONE) grid->links[link->prev].next = link->next;
+	else grid->head[CellHash(link->cx, link->cy)] = link->next;
+
+	if(link->next != GRID_NONE) grid->links[link->next].prev = link->prev;
+}
+
+void GridInsert(SpatialGrid *grid, int32_t id, Vector2 position) {
+	if(id < 0 || id >= grid->capacity || grid->links[id].in_grid) return;
+
+	GridLinkCell(grid, id, CellCoord(grid, position.x), CellCoord(grid, position.y));
+	grid->links[id].in_grid = 1;
+	grid->count++;
+}
+
+void GridRemove(SpatialGrid *grid, int32_t id) {
+	if(id < 0 || id >= grid->capacity || !grid->links[id].in_grid) return;
+
+	GridUnlinkCell(grid, id);
+	grid->links[id].in_grid = 0;
+	grid->count--;
+}
+
+void GridMove(SpatialGrid *grid, int32_t id, Vector2 position) {
+	GridLink *link = &grid->links[id];
+	if(!link->in_grid) return;
+
+	int32_t cx = CellCoord(grid, position.x), cy = CellCoord(grid, position.y);
+
+	// Most moves stay inside the same cell, nothing to do
+	if(cx == link->cx && cy == link->cy) return;
+
+	GridUnlinkCell(grid, id);
+	GridLinkCell(grid, id, cx, cy);
+}
+
+int32_t GridQueryRect(SpatialGrid *grid, Rectangle rec, int32_t *out, int32_t out_cap) {
+	int32_t min_x = CellCoord(grid, rec.x), max_x = CellCoord(grid, rec.x + rec.width);
+	int32_t min_y = CellCoord(grid, rec.y), max_y = CellCoord(grid, rec.y + rec.height);
+
+	int32_t n = 0;
+	int64_t cell_count = (int64_t)(max_x - min_x + 1) * (max_y - min_y + 1);
+
+	// Very large queries: walk every bucket once instead of visiting the same buckets repeatedly
+	if(cell_count > GRID_BUCKETS) {
+		for(uint32_t b = 0; b < GRID_BUCKETS; b++) {
+			for(int32_t id = grid->head[b]; id != GRID_NONE; id = grid->links[id].next) {
+				GridLink *link = &grid->links[id];
+				if(link->cx < min_x || link->cx > max_x || link->cy < min_y || link->cy > max_y) continue;
+
+				if(n < out_cap) out[n++] = id;
+			}
+		}
+
+		return n;
+	}
+
+	for(int32_t cy = min_y; cy <= max_y; cy++) {
+		for(int32_t cx = min_x; cx <= max_x; cx++) {
+			for(int32_t id = grid->head[CellHash(cx, cy)]; id != GRID_NONE; id = grid->links[id].next) {
+				// Skip items from other cells sharing this bucket
+				GridLink *link = &grid->links[id];
+				if(link->cx != cx || link->cy != cy) continue;
+
+				if(n < out_cap) out[n++] = id;
+			}
+		}
+	}
+
+	return n;
+}
+
+int32_t GridQueryCircle(SpatialGrid *grid, Vector2 center, float radius, int32_t *out, int32_t out_cap) {
+	Rectangle rec = { center.x - radius, center.y - radius, radius * 2, radius * 2 };
+	return GridQueryRect(grid, rec, out, out_cap);
+}
+
+// Test items in a block of cells against ray, keeps closest hit
+static void GridRayScan(SpatialGrid *grid, int32_t min_x, int32_t max_x, int32_t min_y, int32_t max_y,
+		Vector2 origin, Vector2 dir, GridRayTest test, void *ctx, GridRayHit *hit) {
+	for(int32_t cy = min_y; cy <= max_y; cy++) {
+		for(int32_t cx = min_x; cx <= max_x; cx++) {
+			for(int32_t id = grid->head[CellHash(cx, cy)]; id != GRID_NONE; id = grid->links[id].next) {
+				// Skip items from other cells sharing this bucket
+				GridLink *link = &grid->links[id];
+				if(link->cx != cx || link->cy != cy) continue;
+
+				float t = test(ctx, id, origin, dir);
+				if(t >= 0 && t < hit->distance) {
+					hit->id = id;
+					hit->distance = t;
+				}
+			}
+		}
+	}
+}
+
+bool GridRaycast(SpatialGrid *grid, Vector2 origin, Vector2 dir, float max_dist, float pad, GridRayTest test, void *ctx, GridRayHit *hit) {
+	*hit = (GridRayHit){ .id = GRID_NONE, .distance = max_dist };
+
+	// Cells around each visited cell an item hit from that cell can be in
+	int32_t reach = (int32_t)ceilf(pad * grid->inv_cell_size);
+
+	int32_t cx = CellCoord(grid, origin.x), cy = CellCoord(grid, origin.y);
+	int32_t step_x = (dir.x > 0) - (dir.x < 0);
+	int32_t step_y = (dir.y > 0) - (dir.y < 0);
+
+	// Ray distance to next cell boundary on each axis, and between boundaries
+	float delta_x = (step_x) ? fabsf(grid->cell_size / dir.x) : INFINITY;
+	float delta_y = (step_y) ? fabsf(grid->cell_size / dir.y) : INFINITY;
+	float next_x = (step_x) ? (((cx + (step_x > 0)) * grid->cell_size) - origin.x) / dir.x : INFINITY;
+	float next_y = (step_y) ? (((cy + (step_y > 0)) * grid->cell_size) - origin.y) / dir.y : INFINITY;
+
+	GridRayScan(grid, cx - reach, cx + reach, cy - reach, cy + reach, origin, dir, test, ctx, hit);
+
+	// A hit point lies in a visited cell entered before it, so once the next cell is entered
+	// beyond the best hit, every item that could be closer has been tested
+	while(true) {
+		float enter = fminf(next_x, next_y);
+		if(enter > hit->distance) break;
+
+		// Ray moves monotonically on both axes, only leading row or column of neighbourhood is new
+		if(next_x < next_y) {
+			cx += step_x;
+			next_x += delta_x;
+			int32_t col = cx + step_x * reach;
+			GridRayScan(grid, col, col, cy - reach, cy + reach, origin, dir, test, ctx, hit);
+		} else {
+			cy += step_y;
+			next_y += delta_y;
+			int32_t row = cy + step_y * reach;
+			GridRayScan(grid, cx - reach, cx + reach, row, row, origin, dir, test, ctx, hit);
+		}
+	}
+
+	if(hit->id == GRID_NONE) return false;
+
+	hit->point = (Vector2){ origin.x + dir.x * hit->distance, origin.y + dir.y * hit->distance };
+	return true;
+}
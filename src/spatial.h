@@ -0,0 +1,64 @@
+#ifndef SPATIAL_H_
+#define SPATIAL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "raylib.h"
+
+// Number of hash buckets, must be a power of two
+#define GRID_BUCKETS	4096
+#define GRID_NONE		-1
+
+// Per item link data, items are chained into their bucket's list
+typedef struct {
+	int32_t next, prev;		// Neighbouring items in same bucket, GRID_NONE for end of list
+	int32_t cx, cy;			// Cell coordinates item was inserted in
+	uint8_t in_grid;
+} GridLink;
+
+// Spatial hash over a uniform grid of square cells,
+// items are referenced by index (ie. entity index)
+typedef struct {
+	float cell_size;
+	float inv_cell_size;
+
+	int32_t capacity;
+	int32_t count;
+
+	int32_t head[GRID_BUCKETS];		// First item in each bucket
+	GridLink *links;				// Link data for each item, indexed by item id
+} SpatialGrid;
+
+void GridInit(SpatialGrid *grid, float cell_size, int32_t capacity);
+void GridClose(SpatialGrid *grid);
+
+// Grow link data to hold ids below capacity, existing items stay in grid
+bool GridReserve(SpatialGrid *grid, int32_t capacity);
+
+void GridInsert(SpatialGrid *grid, int32_t id, Vector2 position);
+void GridRemove(SpatialGrid *grid, int32_t id);
+
+// Move an item, only relinks if item has changed cells
+void GridMove(SpatialGrid *grid, int32_t id, Vector2 position);
+
+// Collect ids of items in cells overlapping rectangle, returns number of ids written
+int32_t GridQueryRect(SpatialGrid *grid, Rectangle rec, int32_t *out, int32_t out_cap);
+
+// Collect ids of items in cells overlapping circle bounds, returns number of ids written
+int32_t GridQueryCircle(SpatialGrid *grid, Vector2 center, float radius, int32_t *out, int32_t out_cap);
+
+// Ray test callback, returns distance along ray to where item is hit, negative for a miss
+typedef float (*GridRayTest)(void *ctx, int32_t id, Vector2 origin, Vector2 dir);
+
+typedef struct {
+	int32_t id;				// Closest item hit, GRID_NONE for no hit
+	float distance;
+	Vector2 point;
+} GridRayHit;
+
+// Walk cells along ray (DDA), testing items in cells within pad of each visited cell,
+// stops once no untested item can be closer than the best hit.
+// dir must be normalized, pad must cover the furthest an item's hit surface reaches from it's position
+bool GridRaycast(SpatialGrid *grid, Vector2 origin, Vector2 dir, float max_dist, float pad, GridRayTest test, void *ctx, GridRayHit *hit);
+
+#endif // !SPATIAL_H_
@@ -1,4 +1,6 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "raylib.h"
 #include "sprites.h"
 
@@ -28,9 +30,52 @@ Spritesheet SpritesheetCreate(char *texture_path, Vector2 frame_dimensions) {
 	};
 }
 
+// Read image dimensions from a png file's header, without decoding it
+static bool ReadPngSize(char *path, int *width, int *height) {
+	FILE *pF = fopen(path, "rb");
+	if(!pF) return false;
+
+	// Signature (8 bytes), IHDR chunk length and type (8 bytes), then width and height (big endian)
+	unsigned char header[24];
+	size_t read = fread(header, 1, sizeof(header), pF);
+	fclose(pF);
+
+	if(read != sizeof(header) || header[1] != 'P' || header[2] != 'N' || header[3] != 'G') return false;
+
+	*width  = (header[16] << 24) | (header[17] << 16) | (header[18] << 8) | header[19];
+	*height = (header[20] << 24) | (header[21] << 16) | (header[22] << 8) | header[23];
+
+	return true;
+}
+
+// Make a spritesheet with frame layout only, no texture is loaded
+// used when running without a window or GL context
+Spritesheet SpritesheetCreateMeta(char *texture_path, Vector2 frame_dimensions) {
+	int width, height;
+	if(!ReadPngSize(texture_path, &width, &height)) {
+		printf("file missing: %s\n", texture_path);	
+		return (Spritesheet){0};
+	}
+
+	// Calculate column and row count
+	uint8_t cols = width  / frame_dimensions.x;
+	uint8_t rows = height / frame_dimensions.y;
+
+	return (Spritesheet) {
+		.flags = (SPR_META_ONLY),
+		.frame_w = frame_dimensions.x,
+		.frame_h = frame_dimensions.y,
+		.cols = cols,
+		.rows = rows,
+		.frame_count = (cols * rows),
+	};
+}
+
 // Unload data, free allocated memory
+// atlas pages are shared between sheets, sprite loader unloads those
 void SpritesheetClose(Spritesheet *spritesheet) {
-	UnloadTexture(spritesheet->texture);
+	if((spritesheet->flags & SPR_TEX_VALID) && !(spritesheet->flags & SPR_ATLAS)) 
+		UnloadTexture(spritesheet->texture);
 	spritesheet->flags &= ~SPR_ALLOCATED;
 }
 
@@ -80,8 +125,8 @@ Rectangle GetFrameRec(uint8_t idx, Spritesheet *spritesheet) {
 	uint8_t c = idx % spritesheet->cols, r = idx / spritesheet->cols;
 
 	return (Rectangle) {
-		.x  = c * spritesheet->frame_w,
-		.y  = r * spritesheet->frame_h,
+		.x  = spritesheet->atlas_x + c * spritesheet->frame_w,
+		.y  = spritesheet->atlas_y + r * spritesheet->frame_h,
 		.width  = spritesheet->frame_w,
 		.height = spritesheet->frame_h
 	};			
@@ -123,19 +168,298 @@ void AnimDrawPro(SpriteAnimation *anim, Vector2 position, float rotation, uint8_
 	DrawSpritePro(anim->spritesheet, anim->cur_frame, position, rotation, flags);
 }
 
+// Make a spritesheet from image data kept on the cpu, 
+// texture is assigned once the image is packed into an atlas page
+Spritesheet SpritesheetCreateStaged(char *texture_path, Vector2 frame_dimensions, Image *image) {
+	*image = LoadImage(texture_path);
+	if(!IsImageValid(*image)) {
+		printf("file missing: %s\n", texture_path);	
+		return (Spritesheet){0};
+	}
+
+	// Calculate column and row count
+	uint8_t cols = image->width  / frame_dimensions.x;
+	uint8_t rows = image->height / frame_dimensions.y;
+
+	return (Spritesheet) {
+		.flags = (SPR_META_ONLY),
+		.frame_w = frame_dimensions.x,
+		.frame_h = frame_dimensions.y,
+		.cols = cols,
+		.rows = rows,
+		.frame_count = (cols * rows),
+	};
+}
+
 // Load a spritesheet, push to sprite stack
+// sheets stay image only until SpriteLoaderPackAtlas is called
 void LoadSpritesheet(char *tex_path, Vector2 frame_dimensions, SpriteLoader *sl) {
-	Spritesheet ss = SpritesheetCreate(tex_path, frame_dimensions);	
-	if(!(ss.flags & SPR_TEX_VALID)) {
+	Spritesheet ss = (sl->flags & SPR_LOADER_HEADLESS) ? 
+		SpritesheetCreateMeta(tex_path, frame_dimensions) : 
+		SpritesheetCreateStaged(tex_path, frame_dimensions, &sl->staging[sl->spr_count]);	
+
+	if(!(ss.flags & (SPR_TEX_VALID | SPR_META_ONLY))) {
 		printf("error: spritesheet[%d], missing texture\n", sl->spr_count);
 		return;
 	}
 
 	ss.flags |= SPR_ALLOCATED;
+	ss.atlas_page = SPR_ATLAS_MAX_PAGES;
 	printf("spritesheet[%d] loaded to sprite pool\n", sl->spr_count);
+	sl->sources[sl->spr_count] = tex_path;
 	sl->spr_pool[sl->spr_count++] = ss;
 } 
 
+static void SkylineInit(Skyline *sky) {
+	sky->node_count = 1;
+	sky->used_w = sky->used_h = 0;
+	sky->nodes[0] = (SkylineNode){ 0, 0, SPR_ATLAS_PAGE_SIZE };
+}
+
+// Height a rectangle would rest at if placed at start of node, -1 if it doesn't fit there
+static int32_t SkylineFit(Skyline *sky, uint16_t node, int32_t w, int32_t h) {
+	int32_t x = sky->nodes[node].x;
+	if(x + w > SPR_ATLAS_PAGE_SIZE) return -1;
+
+	// Rectangle rests on the highest segment it spans
+	int32_t y = 0, remaining = w;
+	for(uint16_t i = node; remaining > 0; i++) {
+		if(sky->nodes[i].y > y) y = sky->nodes[i].y;
+		remaining -= sky->nodes[i].width;
+	}
+
+	return (y + h > SPR_ATLAS_PAGE_SIZE) ? -1 : y;
+}
+
+// Find lowest spot for a rectangle (bottom-left rule), raise skyline over it
+static bool SkylinePack(Skyline *sky, int32_t w, int32_t h, uint16_t *out_x, uint16_t *out_y) {
+	int32_t best = -1, best_y = SPR_ATLAS_PAGE_SIZE, best_w = SPR_ATLAS_PAGE_SIZE;
+
+	for(uint16_t i = 0; i < sky->node_count; i++) {
+		int32_t y = SkylineFit(sky, i, w, h);
+		if(y < 0) continue;
+
+		// Prefer lowest position, then narrowest segment to limit wasted space
+		if(y < best_y || (y == best_y && sky->nodes[i].width < best_w)) {
+			best = i;
+			best_y = y;
+			best_w = sky->nodes[i].width;
+		}
+	}
+
+	if(best < 0 || sky->node_count >= SPR_POOL_CAPACITY) return false;
+
+	SkylineNode placed = { sky->nodes[best].x, best_y + h, w };
+
+	// Insert new segment, shift following ones
+	for(int32_t i = sky->node_count; i > best; i--) sky->nodes[i] = sky->nodes[i - 1];
+	sky->nodes[best] = placed;
+	sky->node_count++;
+
+	// Trim or remove segments now covered by the new one
+	for(uint16_t i = best + 1; i < sky->node_count; i++) {
+		SkylineNode *prev = &sky->nodes[i - 1], *node = &sky->nodes[i];
+		int32_t overlap = (prev->x + prev->width) - node->x;
+		if(overlap <= 0) break;
+
+		if(overlap < node->width) {
+			node->x += overlap;
+			node->width -= overlap;
+			break;
+		}
+
+		for(uint16_t j = i; j < sky->node_count - 1; j++) sky->nodes[j] = sky->nodes[j + 1];
+		sky->node_count--;
+		i--;
+	}
+
+	// Merge neighbouring segments at equal height
+	for(uint16_t i = 0; i + 1 < sky->node_count; i++) {
+		if(sky->nodes[i].y != sky->nodes[i + 1].y) continue;
+
+		sky->nodes[i].width += sky->nodes[i + 1].width;
+		for(uint16_t j = i + 1; j < sky->node_count - 1; j++) sky->nodes[j] = sky->nodes[j + 1];
+		sky->node_count--;
+		i--;
+	}
+
+	*out_x = placed.x;
+	*out_y = best_y;
+
+	if(placed.x + w > sky->used_w) sky->used_w = placed.x + w;
+	if(best_y + h > sky->used_h) sky->used_h = best_y + h;
+
+	return true;
+}
+
+// Size of a staged sheet's frame area, including padding
+static inline int32_t PackedWidth(Spritesheet *ss)  { return ss->cols * ss->frame_w + SPR_ATLAS_PADDING; }
+static inline int32_t PackedHeight(Spritesheet *ss) { return ss->rows * ss->frame_h + SPR_ATLAS_PADDING; }
+
+// Sort helper, tallest sheets first pack tighter
+typedef struct {
+	uint8_t index;
+	int32_t height;
+} SheetOrder;
+
+static int CompareSheetHeight(const void *a, const void *b) {
+	const SheetOrder *sa = a, *sb = b;
+	int32_t d = sb->height - sa->height;
+	return d ? d : (sa->index - sb->index);
+}
+
+// Pack sheet images into the atlas on the cpu, makes no GL calls so it's safe off the main thread.
+// Sheets go into free space of open pages before new ones are opened, pages that took sheets are grown to their
+// used area keeping the pixels they had. Sets atlas_page and atlas offset of each sheet, sheets that fit no page get
+// SPR_ATLAS_MAX_PAGES. Returns a bit for every page that changed
+uint32_t SpriteAtlasAdd(SpriteAtlas *atlas, Spritesheet **sheets, Image *images, uint8_t count) {
+	if(count == 0) return 0;
+
+	SheetOrder order[SPR_POOL_CAPACITY];
+	for(uint8_t i = 0; i < count; i++) order[i] = (SheetOrder){ i, PackedHeight(sheets[i]) };
+	qsort(order, count, sizeof(SheetOrder), CompareSheetHeight);
+
+	// Place sheets, opening a new page when none of the open ones has room
+	uint32_t changed = 0;
+
+	for(uint8_t n = 0; n < count; n++) {
+		Spritesheet *ss = sheets[order[n].index];
+		ss->atlas_page = SPR_ATLAS_MAX_PAGES;
+
+		for(uint8_t p = 0; p <= atlas->page_count && p < SPR_ATLAS_MAX_PAGES; p++) {
+			if(p == atlas->page_count) {
+				SkylineInit(&atlas->skylines[p]);
+				atlas->pages[p] = (Image){0};
+				atlas->page_count++;
+			}
+
+			if(SkylinePack(&atlas->skylines[p], PackedWidth(ss), PackedHeight(ss), &ss->atlas_x, &ss->atlas_y)) {
+				ss->atlas_page = p;
+				changed |= 1u << p;
+				break;
+			}
+		}
+
+		// Page opened for a sheet that never fit, drop it
+		if(ss->atlas_page == SPR_ATLAS_MAX_PAGES && atlas->page_count > 0 && atlas->skylines[atlas->page_count - 1].used_h == 0)
+			atlas->page_count--;
+	}
+
+	for(uint8_t p = 0; p < atlas->page_count; p++) {
+		if(!(changed & (1u << p))) continue;
+
+		// Used area only grows, rows of the old image are copied to the top left of the new one
+		Skyline *sky = &atlas->skylines[p];
+		Image *page = &atlas->pages[p];
+
+		if(page->width != sky->used_w || page->height != sky->used_h) {
+			Image grown = GenImageColor(sky->used_w, sky->used_h, BLANK);
+
+			if(page->data) {
+				for(int y = 0; y < page->height; y++)
+					memcpy((uint8_t*)grown.data + (size_t)y * grown.width * 4, (uint8_t*)page->data + (size_t)y * page->width * 4, (size_t)page->width * 4);
+				UnloadImage(*page);
+			}
+
+			*page = grown;
+		}
+
+		for(uint8_t i = 0; i < count; i++) {
+			Spritesheet *ss = sheets[i];
+			if(ss->atlas_page != p) continue;
+
+			float w = ss->cols * ss->frame_w, h = ss->rows * ss->frame_h;
+			ImageDraw(page, images[i], (Rectangle){0, 0, w, h}, (Rectangle){ss->atlas_x, ss->atlas_y, w, h}, WHITE);
+		}
+	}
+
+	return changed;
+}
+
+void SpriteAtlasClose(SpriteAtlas *atlas) {
+	for(uint8_t p = 0; p < atlas->page_count; p++)
+		if(atlas->pages[p].data) UnloadImage(atlas->pages[p]);
+
+	atlas->page_count = 0;
+}
+
+// Pack all staged spritesheets into the loader's atlas and upload pages that changed,
+// sheets keep their frame layout, GetFrameRec adds the atlas offset
+void SpriteLoaderPackAtlas(SpriteLoader *sl) {
+	if(sl->flags & SPR_LOADER_HEADLESS) return;
+
+	Spritesheet *sheets[SPR_POOL_CAPACITY];
+	Image images[SPR_POOL_CAPACITY];
+	uint8_t slots[SPR_POOL_CAPACITY];
+	uint8_t staged = 0;
+
+	for(uint8_t i = 0; i < sl->spr_count; i++) {
+		if(!sl->staging[i].data) continue;
+
+		sheets[staged] = &sl->spr_pool[i];
+		images[staged] = sl->staging[i];
+		slots[staged++] = i;
+	}
+
+	if(staged == 0) return;
+
+	uint32_t changed = SpriteAtlasAdd(&sl->atlas, sheets, images, staged);
+
+	// Upload pages (asset packer keeps the images instead), pages uploaded before are replaced
+	for(uint8_t p = 0; p < sl->atlas.page_count; p++) {
+		if(!(changed & (1u << p))) continue;
+
+		Image *page = &sl->atlas.pages[p];
+		if(sl->flags & SPR_LOADER_KEEP_PAGES) {
+			printf("atlas page[%d] %dx%d packed\n", p, page->width, page->height);
+			continue;
+		}
+
+		if(p < sl->atlas_count) UnloadTexture(sl->atlas_pages[p]);
+		sl->atlas_pages[p] = LoadTextureFromImage(*page);
+		printf("atlas page[%d] %dx%d uploaded\n", p, page->width, page->height);
+
+		// Sheets packed into page before point at it's new texture
+		for(uint8_t i = 0; i < sl->spr_count; i++) {
+			Spritesheet *ss = &sl->spr_pool[i];
+			if((ss->flags & SPR_ATLAS) && ss->atlas_page == p) ss->texture = sl->atlas_pages[p];
+		}
+	}
+
+	sl->atlas_count = sl->atlas.page_count;
+
+	// Point sheets at their page, sheets that didn't fit get their own texture
+	for(uint8_t n = 0; n < staged; n++) {
+		uint8_t i = slots[n];
+		Spritesheet *ss = sheets[n];
+		bool packed = (ss->atlas_page < SPR_ATLAS_MAX_PAGES);
+
+		// No textures without upload, page images hold the pixels
+		if(sl->flags & SPR_LOADER_KEEP_PAGES) {
+			if(packed) {
+				UnloadImage(sl->staging[i]);
+				sl->staging[i] = (Image){0};
+			}
+			continue;
+		}
+
+		ss->flags &= ~SPR_META_ONLY;
+
+		if(packed) {
+			ss->texture = sl->atlas_pages[ss->atlas_page];
+			ss->flags |= (SPR_ATLAS | SPR_TEX_VALID);
+		} else {
+			ss->texture = LoadTextureFromImage(sl->staging[i]);
+			ss->atlas_x = ss->atlas_y = 0;
+			if(IsTextureValid(ss->texture)) ss->flags |= SPR_TEX_VALID;
+			printf("spritesheet[%d] too large for atlas, using own texture\n", i);
+		}
+
+		UnloadImage(sl->staging[i]);
+		sl->staging[i] = (Image){0};
+	}
+}
+
 // Create a new sprite animation, push to animation stack
 void AddSpriteAnim(Spritesheet *spritesheet, uint8_t start_frame, uint8_t frame_count, float speed, SpriteLoader *sl) {
 	SpriteAnimation anim = AnimCreate(spritesheet, start_frame, frame_count, speed);
@@ -144,14 +468,25 @@ void AddSpriteAnim(Spritesheet *spritesheet, uint8_t start_frame, uint8_t frame_
 
 // Unload spritesheets
 void SpriteLoaderClose(SpriteLoader *sl) {
-	uint16_t i = 0;
-	while(i < sl->spr_count) {
+	for(uint16_t i = 0; i < sl->spr_count; i++) {
 		// Skip unallocated spritesheet slots
 		if(!(sl->spr_pool[i].flags & SPR_ALLOCATED)) continue;
 
 		// Unload spritesheet
 		printf("spritesheet[%d] unloaded from sprite pool\n", i);
-		SpritesheetClose(&sl->spr_pool[i++]);
+		SpritesheetClose(&sl->spr_pool[i]);
+
+		// Free images never packed
+		if(sl->staging[i].data) UnloadImage(sl->staging[i]);
+		sl->staging[i] = (Image){0};
 	}
+
+	// Unload shared atlas pages and their cpu images
+	if(!(sl->flags & SPR_LOADER_KEEP_PAGES)) {
+		for(uint8_t i = 0; i < sl->atlas_count; i++) UnloadTexture(sl->atlas_pages[i]);
+	}
+
+	SpriteAtlasClose(&sl->atlas);
+	sl->atlas_count = 0;
 }
 
@@ -9,6 +9,8 @@
 #define SPR_PERSIST  	0x04
 #define SPR_FLIP_X	   	0x08
 #define SPR_FLIP_Y	   	0x10
+#define SPR_META_ONLY	0x20		// Frame layout loaded without a texture (headless)
+#define SPR_ATLAS		0x40		// Texture is a shared atlas page owned by the sprite loader
 
 typedef struct {
 	uint8_t flags;
@@ -16,11 +18,15 @@ typedef struct {
 	uint8_t cols, rows;			// Number of columns and rows
 
 	uint8_t frame_w, frame_h;	// Width and height of frames
+	uint8_t atlas_page;			// Index of atlas page holding sheet, SPR_ATLAS_MAX_PAGES if not packed
+	uint16_t atlas_x, atlas_y;	// Offset of sheet inside texture, zero unless packed in an atlas
 
 	Texture2D texture;			// Source image
 } Spritesheet;
 
 Spritesheet SpritesheetCreate(char *texture_path, Vector2 frame_dimensions);
+Spritesheet SpritesheetCreateMeta(char *texture_path, Vector2 frame_dimensions);
+Spritesheet SpritesheetCreateStaged(char *texture_path, Vector2 frame_dimensions, Image *image);
 void SpritesheetClose(Spritesheet *spritesheet);
 
 void DrawSprite(Spritesheet *spritesheet, uint8_t frame_index, Vector2 position, uint8_t flags);
@@ -47,16 +53,57 @@ void AnimDrawPro(SpriteAnimation *anim, Vector2 position, float rotation, uint8_
 
 #define SPR_POOL_CAPACITY	255
 
+// Sprite loader flags
+#define SPR_LOADER_HEADLESS		0x01	// Only load frame layouts, no textures or GL context needed
+#define SPR_LOADER_KEEP_PAGES	0x02	// Keep atlas pages as cpu images instead of uploading them (asset packer)
+#define SPR_LOADER_NO_PACK		0x04	// Skip asset pack, always load loose pngs
+
+// Atlas page limits, sheets that don't fit any page keep their own texture,
+// content blocks share pages, a block packed later fills free space of earlier pages first
+#define SPR_ATLAS_PAGE_SIZE		2048
+#define SPR_ATLAS_MAX_PAGES		8
+#define SPR_ATLAS_PADDING		2		// Empty pixels between packed sheets, stops filtering bleed
+
+// Skyline packer state for one atlas page,
+// skyline is the top edge of packed rectangles as a list of horizontal segments
+typedef struct {
+	uint16_t x, y, width;
+} SkylineNode;
+
+typedef struct {
+	uint16_t node_count;
+	uint16_t used_w, used_h;
+	SkylineNode nodes[SPR_POOL_CAPACITY + 1];
+} Skyline;
+
+// Atlas pages kept open between packs, page images stay on the cpu sized to their used area
+// so a page that takes more sheets can be uploaded again
+typedef struct {
+	uint8_t page_count;
+	Skyline skylines[SPR_ATLAS_MAX_PAGES];
+	Image pages[SPR_ATLAS_MAX_PAGES];
+} SpriteAtlas;
+
 typedef struct {
+	uint8_t flags;
 	uint8_t spr_count;
 	uint8_t anim_count;
+	uint8_t atlas_count;
 
 	Spritesheet spr_pool[SPR_POOL_CAPACITY];
 	SpriteAnimation anims[SPR_POOL_CAPACITY];
+
+	Image staging[SPR_POOL_CAPACITY];			// Loaded sheet images waiting to be packed
+	const char *sources[SPR_POOL_CAPACITY];		// Png each sheet was loaded from, paths must outlive the loader
+	Texture2D atlas_pages[SPR_ATLAS_MAX_PAGES];	// Not uploaded with SPR_LOADER_KEEP_PAGES
+	SpriteAtlas atlas;							// Only touched by the thread packing, streamer's loader thread if streaming
 } SpriteLoader;
 
 void LoadSpritesheet(char *tex_path, Vector2 frame_dimensions, SpriteLoader *sl);
 void AddSpriteAnim(Spritesheet *spritesheet, uint8_t start_frame, uint8_t frame_count, float speed, SpriteLoader *sl);
+void SpriteLoaderPackAtlas(SpriteLoader *sl);
+uint32_t SpriteAtlasAdd(SpriteAtlas *atlas, Spritesheet **sheets, Image *images, uint8_t count);
+void SpriteAtlasClose(SpriteAtlas *atlas);
 void SpriteLoaderClose(SpriteLoader *sl);
 
 void LoadSpritesAll(SpriteLoader *sl);
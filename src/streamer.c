@@ -0,0 +1,402 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include "raylib.h"
+#include "streamer.h"
+#include "clock.h"
+
+static uint8_t *BlockState(Streamer *st, uint8_t kind, uint8_t block) {
+	return (kind == STREAM_SPRITES) ? &st->sprite_state[block] : &st->audio_state[block];
+}
+
+static void StreamUploadFree(StreamUpload *up) {
+	if(up->image.data && !up->mapped) UnloadImage(up->image);
+	if(up->wave.data) UnloadWave(up->wave);
+}
+
+// Loader thread, queue an upload for the main thread, waits while queue is full.
+// Upload is dropped if streamer is closing
+static void StreamPush(Streamer *st, StreamUpload up) {
+	pthread_mutex_lock(&st->lock);
+
+	while(st->running && st->up_tail - st->up_head >= STREAM_QUEUE_CAP)
+		pthread_cond_wait(&st->wake, &st->lock);
+
+	if(!st->running) {
+		pthread_mutex_unlock(&st->lock);
+		StreamUploadFree(&up);
+		return;
+	}
+
+	st->uploads[st->up_tail++ % STREAM_QUEUE_CAP] = up;
+	pthread_cond_signal(&st->uploaded);
+	pthread_mutex_unlock(&st->lock);
+}
+
+// Take oldest upload, lock must be held
+static bool StreamPop(Streamer *st, StreamUpload *up) {
+	if(st->up_head == st->up_tail) return false;
+
+	*up = st->uploads[st->up_head++ % STREAM_QUEUE_CAP];
+
+	// Loader thread may be waiting for space
+	pthread_cond_signal(&st->wake);
+	return true;
+}
+
+// Read a block's tables from the pack, touch it's page pixels so the upload doesn't fault them in
+static bool StreamPackedSprites(Streamer *st, uint8_t block_id) {
+	AssetPack *pack = &st->pack;
+	AssetPackReadBlock(pack, block_id, st->sprites);
+
+	if(st->headless) return true;
+
+	// Pages shared with a block loaded before are already on their way
+	for(uint32_t p = 0; p < pack->header->page_count; p++) {
+		const AssetPackPage *page = &pack->pages[p];
+		if(!(page->blocks & (1u << block_id)) || (st->pages_sent & (1u << p))) continue;
+
+		st->pages_sent |= 1u << p;
+
+		uint8_t *pixels = pack->base + page->offset;
+		volatile uint8_t sink = 0;
+		for(uint32_t i = 0; i < page->size; i += ASSET_PACK_ALIGN) sink += pixels[i];
+		(void)sink;
+
+		Image image = {
+			.data = pixels,
+			.width = page->width,
+			.height = page->height,
+			.mipmaps = 1,
+			.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+		};
+
+		StreamPush(st, (StreamUpload){ .type = STREAM_UP_PAGE, .kind = STREAM_SPRITES, .block = block_id, .slot = p, .mapped = true, .image = image });
+	}
+
+	return true;
+}
+
+// Decode a block's pngs and pack them into the loader's atlas, all on the loader thread.
+// Sheet slots aren't read by the main thread until the block is done
+static bool StreamLooseSprites(Streamer *st, uint8_t block_id) {
+	SpriteLoader *sl = st->sprites;
+	SpriteBlock *block = &sprite_blocks[block_id];
+	bool ok = true;
+
+	Spritesheet *sheets[BLOCK_MAX_SHEETS];
+	Image images[BLOCK_MAX_SHEETS];
+	uint8_t slots[BLOCK_MAX_SHEETS];
+	uint8_t count = 0;
+
+	for(uint8_t i = 0; i < block->sheet_count; i++) {
+		BlockSheet *sheet = &block->sheets[i];
+		uint8_t slot = block->sheet_base + i;
+		Vector2 frame_dimensions = { sheet->frame_w, sheet->frame_h };
+
+		Spritesheet ss = (st->headless) ?
+			SpritesheetCreateMeta((char*)sheet->path, frame_dimensions) :
+			SpritesheetCreateStaged((char*)sheet->path, frame_dimensions, &images[count]);
+
+		if(!(ss.flags & (SPR_TEX_VALID | SPR_META_ONLY))) {
+			printf("error: spritesheet[%d], missing texture\n", slot);
+			ok = false;
+			continue;
+		}
+
+		ss.flags |= SPR_ALLOCATED;
+		ss.atlas_page = SPR_ATLAS_MAX_PAGES;
+		sl->spr_pool[slot] = ss;
+		sl->sources[slot] = sheet->path;
+
+		if(!st->headless) {
+			sheets[count] = &sl->spr_pool[slot];
+			slots[count++] = slot;
+		}
+	}
+
+	for(uint8_t i = 0; i < block->anim_count; i++) {
+		BlockAnim *anim = &block->anims[i];
+		Spritesheet *ss = &sl->spr_pool[block->sheet_base + anim->sheet];
+		sl->anims[block->anim_base + i] = AnimCreate(ss, FrameIndex(ss, anim->col, anim->row), anim->frame_count, anim->speed);
+	}
+
+	if(count == 0) return ok;
+
+	// Atlas keeps it's page images for later blocks, uploads get a copy of each page that changed
+	SpriteAtlas *atlas = &sl->atlas;
+	uint32_t changed = SpriteAtlasAdd(atlas, sheets, images, count);
+
+	for(uint8_t p = 0; p < atlas->page_count; p++) {
+		if(!(changed & (1u << p))) continue;
+		StreamPush(st, (StreamUpload){ .type = STREAM_UP_PAGE, .kind = STREAM_SPRITES, .block = block_id, .slot = p, .image = ImageCopy(atlas->pages[p]) });
+	}
+
+	// Sheets that fit no page are uploaded on their own
+	for(uint8_t n = 0; n < count; n++) {
+		if(sheets[n]->atlas_page < SPR_ATLAS_MAX_PAGES) UnloadImage(images[n]);
+		else StreamPush(st, (StreamUpload){ .type = STREAM_UP_SHEET, .kind = STREAM_SPRITES, .block = block_id, .slot = slots[n], .image = images[n] });
+	}
+
+	return ok;
+}
+
+// Decode a block's waves, headless runs have no audio device so nothing is read
+static bool StreamAudio(Streamer *st, uint8_t block_id) {
+	AudioBlock *block = &audio_blocks[block_id];
+	if(st->headless) return true;
+
+	bool ok = true;
+	for(uint8_t i = 0; i < block->sound_count; i++) {
+		Wave wave = LoadWave(block->paths[i]);
+		if(!IsWaveValid(wave)) {
+			printf("file missing: %s\n", block->paths[i]);
+			ok = false;
+			continue;
+		}
+
+		StreamPush(st, (StreamUpload){ .type = STREAM_UP_SOUND, .kind = STREAM_AUDIO, .block = block_id, .slot = block->sound_base + i, .wave = wave });
+	}
+
+	return ok;
+}
+
+static void *StreamThread(void *arg) {
+	Streamer *st = arg;
+
+	pthread_mutex_lock(&st->lock);
+	while(st->running) {
+		if(st->req_head == st->req_tail) {
+			pthread_cond_wait(&st->wake, &st->lock);
+			continue;
+		}
+
+		StreamRequest req = st->requests[st->req_head++ % STREAM_MAX_REQUESTS];
+		*BlockState(st, req.kind, req.block) = BLOCK_LOADING;
+		pthread_mutex_unlock(&st->lock);
+
+		bool ok;
+		if(req.kind == STREAM_AUDIO) ok = StreamAudio(st, req.block);
+		else ok = (st->pack.base) ? StreamPackedSprites(st, req.block) : StreamLooseSprites(st, req.block);
+
+		StreamPush(st, (StreamUpload){ .type = STREAM_UP_DONE, .kind = req.kind, .block = req.block, .failed = !ok });
+		pthread_mutex_lock(&st->lock);
+	}
+	pthread_mutex_unlock(&st->lock);
+
+	return NULL;
+}
+
+// Point a finished block's sheets at their uploaded pages, publish it's slots
+static void StreamSpritesDone(Streamer *st, uint8_t block_id) {
+	SpriteLoader *sl = st->sprites;
+	SpriteBlock *block = &sprite_blocks[block_id];
+
+	for(uint8_t i = 0; i < block->sheet_count; i++) {
+		Spritesheet *ss = &sl->spr_pool[block->sheet_base + i];
+		if(!(ss->flags & SPR_ALLOCATED) || st->headless || ss->atlas_page >= SPR_ATLAS_MAX_PAGES) continue;
+
+		uint8_t page = st->page_slot[ss->atlas_page];
+		ss->atlas_page = page;
+		if(page >= sl->atlas_count) continue;
+
+		ss->texture = sl->atlas_pages[page];
+		ss->flags = (ss->flags & ~SPR_META_ONLY) | (SPR_ATLAS | SPR_TEX_VALID);
+	}
+
+	st->blocks_done |= 1u << block_id;
+
+	uint8_t spr_end = block->sheet_base + block->sheet_count, anim_end = block->anim_base + block->anim_count;
+	if(spr_end > sl->spr_count) sl->spr_count = spr_end;
+	if(anim_end > sl->anim_count) sl->anim_count = anim_end;
+}
+
+// Point sheets of finished blocks on page at it's current texture
+static void StreamRelinkPage(Streamer *st, uint8_t page) {
+	SpriteLoader *sl = st->sprites;
+
+	for(uint8_t b = 0; b < SPR_BLOCK_COUNT; b++) {
+		if(!(st->blocks_done & (1u << b))) continue;
+
+		SpriteBlock *block = &sprite_blocks[b];
+		for(uint8_t i = 0; i < block->sheet_count; i++) {
+			Spritesheet *ss = &sl->spr_pool[block->sheet_base + i];
+			if((ss->flags & SPR_ATLAS) && ss->atlas_page == page) ss->texture = sl->atlas_pages[page];
+		}
+	}
+}
+
+// Main thread side of an upload
+static void StreamApply(Streamer *st, StreamUpload *up) {
+	SpriteLoader *sl = st->sprites;
+
+	switch(up->type) {
+		case STREAM_UP_PAGE: {
+			uint8_t page = st->page_slot[up->slot];
+
+			if(page < SPR_ATLAS_MAX_PAGES) {
+				// Page grew, sheets of finished blocks move to it's new texture. Sheets of this block are pointed at it once done
+				UnloadTexture(sl->atlas_pages[page]);
+				sl->atlas_pages[page] = LoadTextureFromImage(up->image);
+				StreamRelinkPage(st, page);
+				printf("atlas page[%d] %dx%d uploaded again\n", page, up->image.width, up->image.height);
+			} else if(sl->atlas_count < SPR_ATLAS_MAX_PAGES) {
+				st->page_slot[up->slot] = sl->atlas_count;
+				sl->atlas_pages[sl->atlas_count++] = LoadTextureFromImage(up->image);
+				printf("atlas page[%d] %dx%d uploaded\n", sl->atlas_count - 1, up->image.width, up->image.height);
+			} else
+				printf("ERROR: No atlas page left for sprite block[%d]\n", up->block);
+
+			// Mapped pixels are in the gpu now, let the kernel drop them
+			if(up->mapped) posix_madvise(up->image.data, (size_t)up->image.width * up->image.height * 4, POSIX_MADV_DONTNEED);
+		} break;
+
+		case STREAM_UP_SHEET: {
+			Spritesheet *ss = &sl->spr_pool[up->slot];
+			ss->texture = LoadTextureFromImage(up->image);
+			ss->atlas_x = ss->atlas_y = 0;
+			ss->flags &= ~SPR_META_ONLY;
+			if(IsTextureValid(ss->texture)) ss->flags |= SPR_TEX_VALID;
+			printf("spritesheet[%d] too large for atlas, using own texture\n", up->slot);
+		} break;
+
+		case STREAM_UP_SOUND: {
+			SoundLoader *snd = st->sounds;
+			if(!IsAudioDeviceReady()) break;
+
+			snd->snd_pool[up->slot] = LoadSoundFromWave(up->wave);
+			snd->snd_flags[up->slot] |= SND_VALID;
+			if(up->slot >= snd->snd_count) snd->snd_count = up->slot + 1;
+		} break;
+
+		case STREAM_UP_DONE: {
+			if(up->kind == STREAM_SPRITES) StreamSpritesDone(st, up->block);
+
+			uint64_t start = (up->kind == STREAM_SPRITES) ? st->sprite_start[up->block] : st->audio_start[up->block];
+			printf("%s block[%d] %s from %s in %.2f ms, peak rss: %ld KiB\n",
+				(up->kind == STREAM_SPRITES) ? "sprite" : "audio", up->block, (up->failed) ? "failed" : "ready",
+				(up->kind == STREAM_SPRITES && st->pack.base) ? "asset pack" : "loose files",
+				(ClockNowNs() - start) * 1e-6, ProcessPeakRssKiB());
+
+			pthread_mutex_lock(&st->lock);
+			*BlockState(st, up->kind, up->block) = (up->failed) ? BLOCK_FAILED : BLOCK_READY;
+			pthread_mutex_unlock(&st->lock);
+		} break;
+	}
+
+	StreamUploadFree(up);
+}
+
+void StreamerInit(Streamer *st, SpriteLoader *sl, SoundLoader *snd) {
+	*st = (Streamer){0};
+	st->sprites = sl;
+	st->sounds = snd;
+	st->headless = (sl->flags & SPR_LOADER_HEADLESS);
+	for(uint8_t p = 0; p < SPR_ATLAS_MAX_PAGES; p++) st->page_slot[p] = SPR_ATLAS_MAX_PAGES;
+
+	// Prebuilt pack skips png decoding and atlas packing, loose files are the fallback during development
+	if(!(sl->flags & SPR_LOADER_NO_PACK)) AssetPackOpen(&st->pack, ASSET_PACK_PATH);
+
+	pthread_mutex_init(&st->lock, NULL);
+	pthread_cond_init(&st->wake, NULL);
+	pthread_cond_init(&st->uploaded, NULL);
+
+	st->running = true;
+	if(pthread_create(&st->thread, NULL, StreamThread, st) != 0) {
+		puts("ERROR: Could not start content streamer thread");
+		st->running = false;
+	}
+}
+
+void StreamerClose(Streamer *st) {
+	pthread_mutex_lock(&st->lock);
+	bool started = st->running;
+	st->running = false;
+	pthread_cond_broadcast(&st->wake);
+	pthread_mutex_unlock(&st->lock);
+
+	if(started) pthread_join(st->thread, NULL);
+
+	// Uploads never applied
+	StreamUpload up;
+	while(StreamPop(st, &up)) StreamUploadFree(&up);
+
+	AssetPackClose(&st->pack);
+	pthread_cond_destroy(&st->uploaded);
+	pthread_cond_destroy(&st->wake);
+	pthread_mutex_destroy(&st->lock);
+}
+
+bool StreamerRequest(Streamer *st, uint8_t kind, uint8_t block) {
+	pthread_mutex_lock(&st->lock);
+
+	uint8_t *state = BlockState(st, kind, block);
+	bool queued = true;
+
+	if(*state == BLOCK_UNLOADED) {
+		queued = st->running && (st->req_tail - st->req_head < STREAM_MAX_REQUESTS);
+
+		if(queued) {
+			st->requests[st->req_tail++ % STREAM_MAX_REQUESTS] = (StreamRequest){ kind, block };
+			*state = BLOCK_QUEUED;
+
+			if(kind == STREAM_SPRITES) st->sprite_start[block] = ClockNowNs();
+			else st->audio_start[block] = ClockNowNs();
+
+			pthread_cond_signal(&st->wake);
+		}
+	}
+
+	pthread_mutex_unlock(&st->lock);
+	return queued;
+}
+
+uint8_t StreamerState(Streamer *st, uint8_t kind, uint8_t block) {
+	pthread_mutex_lock(&st->lock);
+	uint8_t state = *BlockState(st, kind, block);
+	pthread_mutex_unlock(&st->lock);
+
+	return state;
+}
+
+void StreamerUpdate(Streamer *st, uint64_t budget_ns) {
+	uint64_t start = ClockNowNs();
+
+	do {
+		StreamUpload up;
+
+		pthread_mutex_lock(&st->lock);
+		bool found = StreamPop(st, &up);
+		pthread_mutex_unlock(&st->lock);
+
+		if(!found) break;
+		StreamApply(st, &up);
+	} while(ClockNowNs() - start < budget_ns);
+}
+
+void StreamerFinish(Streamer *st, uint8_t kind, uint8_t block) {
+	if(!StreamerRequest(st, kind, block)) {
+		printf("ERROR: Could not request %s block[%d]\n", (kind == STREAM_SPRITES) ? "sprite" : "audio", block);
+		return;
+	}
+
+	pthread_mutex_lock(&st->lock);
+
+	uint8_t *state = BlockState(st, kind, block);
+	while(*state != BLOCK_READY && *state != BLOCK_FAILED) {
+		StreamUpload up;
+		if(!StreamPop(st, &up)) {
+			pthread_cond_wait(&st->uploaded, &st->lock);
+			continue;
+		}
+
+		// Uploads of other blocks queued before this one's are applied too
+		pthread_mutex_unlock(&st->lock);
+		StreamApply(st, &up);
+		pthread_mutex_lock(&st->lock);
+	}
+
+	pthread_mutex_unlock(&st->lock);
+}
@@ -0,0 +1,107 @@
+#ifndef STREAMER_H_
+#define STREAMER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "raylib.h"
+#include "sprites.h"
+#include "sounds.h"
+#include "content.h"
+#include "asset_pack.h"
+
+// Content streamer:
+// a loader thread does file reads and decoding (png decode, atlas packing, wave decode) into a bounded staging queue,
+// main thread only uploads from the queue, up to a time budget per frame.
+// Blocks go unloaded -> queued -> loading -> ready, so state changes can request blocks early and check on them later.
+// With a valid asset pack sprite blocks are read from the mapping instead of loose pngs.
+// Blocks share atlas pages: pack pages are uploaded once by the first block on them, loose blocks are packed into
+// the sprite loader's atlas and pages that took more sheets are uploaded again
+
+#define STREAM_QUEUE_CAP		8			// Decoded uploads waiting for main thread, loader thread waits when full
+#define STREAM_MAX_REQUESTS		16			// Block requests waiting for loader thread
+#define STREAM_UPLOAD_BUDGET_NS	2000000		// Main thread upload time per frame, at least one upload always runs
+
+enum BLOCK_STATES {
+	BLOCK_UNLOADED,
+	BLOCK_QUEUED,
+	BLOCK_LOADING,
+	BLOCK_READY,
+	BLOCK_FAILED
+};
+
+enum STREAM_KINDS {
+	STREAM_SPRITES,
+	STREAM_AUDIO
+};
+
+enum STREAM_UPLOADS {
+	STREAM_UP_PAGE,			// Atlas page, new or grown, slot is page index in pack or sprite loader's atlas
+	STREAM_UP_SHEET,		// Sheet too large for atlas, slot is sheet's pool slot
+	STREAM_UP_SOUND,		// Decoded wave, slot is sound's pool slot
+	STREAM_UP_DONE			// Last upload of a block
+};
+
+typedef struct {
+	uint8_t type;
+	uint8_t kind, block;
+	uint8_t slot;
+	bool mapped;			// Image points into asset pack mapping, nothing to free
+	bool failed;			// STREAM_UP_DONE only, some of block's files failed to load
+
+	Image image;
+	Wave wave;
+} StreamUpload;
+
+typedef struct {
+	uint8_t kind, block;
+} StreamRequest;
+
+typedef struct {
+	SpriteLoader *sprites;
+	SoundLoader *sounds;
+	bool headless;							// Frame layouts only, nothing is uploaded
+	AssetPack pack;							// Mapped for streamer's lifetime, base is NULL without a pack
+
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;					// Loader thread waits for requests and queue space
+	pthread_cond_t uploaded;				// Main thread waits for uploads when finishing a block
+	bool running;
+
+	uint32_t req_head, req_tail;
+	StreamRequest requests[STREAM_MAX_REQUESTS];
+
+	uint32_t up_head, up_tail;
+	StreamUpload uploads[STREAM_QUEUE_CAP];
+
+	uint8_t sprite_state[SPR_BLOCK_COUNT];
+	uint8_t audio_state[AUDIO_BLOCK_COUNT];
+	uint8_t page_slot[SPR_ATLAS_MAX_PAGES];	// Main thread, uploaded texture of each page, SPR_ATLAS_MAX_PAGES until uploaded
+	uint32_t pages_sent;					// Loader thread, bit for each pack page already queued
+	uint32_t blocks_done;					// Main thread, bit for each sprite block whose sheets point at their pages
+	uint64_t sprite_start[SPR_BLOCK_COUNT];	// Request times, for load time report
+	uint64_t audio_start[AUDIO_BLOCK_COUNT];
+} Streamer;
+
+// Start loader thread, headless and no pack flags are taken from sprite loader,
+// content blocks must be initialized first
+void StreamerInit(Streamer *st, SpriteLoader *sl, SoundLoader *snd);
+
+// Stop loader thread, drop pending uploads, unmap pack
+void StreamerClose(Streamer *st);
+
+// Queue block for loading, nothing happens if it was requested before,
+// false if request queue is full
+bool StreamerRequest(Streamer *st, uint8_t kind, uint8_t block);
+
+// Block's BLOCK_STATES value
+uint8_t StreamerState(Streamer *st, uint8_t kind, uint8_t block);
+
+// Main thread, run queued uploads until budget is spent
+void StreamerUpdate(Streamer *st, uint64_t budget_ns);
+
+// Main thread, request block if needed and run uploads until it's ready or failed
+void StreamerFinish(Streamer *st, uint8_t kind, uint8_t block);
+
+#endif // !STREAMER_H_
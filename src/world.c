@@ -0,0 +1,283 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "world.h"
+#include "kmath.h"
+#include "field_gen.h"
+
+#define WORLD_RECORD_MIN_CAP	64
+
+static uint32_t CellHash(int32_t cx, int32_t cy) {
+	return ((uint32_t)cx * 73856093u) ^ ((uint32_t)cy * 19349663u);
+}
+
+static inline int32_t CellDistance(int32_t ax, int32_t ay, int32_t bx, int32_t by) {
+	int32_t dx = abs(ax - bx), dy = abs(ay - by);
+	return (dx > dy) ? dx : dy;
+}
+
+// Positions of a chunk's generated bodies, returns count. Same cell and seed always give the same bodies.
+// Bodies are Poisson-disk placed so capture zones don't overlap, margins keep them apart across chunk edges too
+static uint16_t ChunkGenerate(World *world, int32_t cx, int32_t cy, Vector2 *out) {
+	uint32_t rng = RandCellSeed(world->seed, cx, cy);
+	uint16_t count = WORLD_BODIES_MIN + RandNext(&rng) % (WORLD_BODIES_MAX - WORLD_BODIES_MIN + 1);
+
+	float span = WORLD_CHUNK_SIZE - WORLD_BODY_MARGIN * 2;
+
+	FieldParams params = {
+		.seed = RandNext(&rng),
+		.bounds = { cx * WORLD_CHUNK_SIZE + WORLD_BODY_MARGIN, cy * WORLD_CHUNK_SIZE + WORLD_BODY_MARGIN, span, span },
+		.spacing = FieldBodySpacing(AsteroidSpawnRadius(world->handler)),
+		.max_points = count
+	};
+
+	// Few points per chunk, not worth spreading over jobs
+	FieldPoints field;
+	if(!FieldGenerate(&params, NULL, &field)) return 0;
+
+	uint16_t kept = 0;
+	for(uint32_t i = 0; i < field.count; i++) {
+		if(Vector2Length(field.points[i]) < WORLD_CLEAR_RADIUS) continue;
+		out[kept++] = field.points[i];
+	}
+
+	FieldPointsFree(&field);
+	return kept;
+}
+
+void WorldInit(World *world, EntHandler *handler, uint32_t seed) {
+	*world = (World){0};
+	world->handler = handler;
+	world->seed = (seed) ? seed : WORLD_DEFAULT_SEED;
+}
+
+void WorldClose(World *world) {
+	for(uint32_t i = 0; i < world->record_cap; i++) free(world->records[i].bodies);
+	free(world->records);
+
+	world->records = NULL;
+	world->record_cap = 0;
+	world->record_count = 0;
+	world->record_bytes = 0;
+	world->resident_count = 0;
+}
+
+// Table slot of cell, either it's record or the empty slot it would go in
+static WorldRecord *RecordSlot(WorldRecord *records, uint32_t cap, int32_t cx, int32_t cy) {
+	uint32_t mask = cap - 1;
+	uint32_t i = CellHash(cx, cy) & mask;
+
+	while(records[i].used && (records[i].cx != cx || records[i].cy != cy)) i = (i + 1) & mask;
+	return &records[i];
+}
+
+static WorldRecord *RecordFind(World *world, int32_t cx, int32_t cy) {
+	if(!world->record_cap) return NULL;
+
+	WorldRecord *rec = RecordSlot(world->records, world->record_cap, cx, cy);
+	return (rec->used) ? rec : NULL;
+}
+
+// Table is kept at most half full, grows by rehashing into a table twice the size
+static bool RecordsGrow(World *world) {
+	uint32_t cap = (world->record_cap) ? world->record_cap * 2 : WORLD_RECORD_MIN_CAP;
+	WorldRecord *records = calloc(cap, sizeof(WorldRecord));
+	if(!records) return false;
+
+	for(uint32_t i = 0; i < world->record_cap; i++) {
+		WorldRecord *old = &world->records[i];
+		if(old->used) *RecordSlot(records, cap, old->cx, old->cy) = *old;
+	}
+
+	free(world->records);
+	world->records = records;
+	world->record_cap = cap;
+	return true;
+}
+
+static inline bool BodyEqual(const WorldBody *a, const WorldBody *b) {
+	return a->position.x == b->position.x && a->position.y == b->position.y &&
+		a->data.ex_flags == b->data.ex_flags && a->data.state == b->data.state;
+}
+
+// Keep spawned body's handle and state, bodies that fail to spawn are left out
+static void ChunkAddBody(World *world, WorldChunk *chunk, EntHandle handle) {
+	Entity *body = EntGet(world->handler, handle);
+	if(!body) return;
+
+	chunk->spawned[chunk->body_count] = (WorldBody){ ENT_POS(body), *(AsteroidData*)body->data };
+	chunk->bodies[chunk->body_count++] = handle;
+}
+
+// Spawn chunk's bodies, from it's record if it has one
+static void ChunkActivate(World *world, int32_t cx, int32_t cy) {
+	WorldChunk *chunk = &world->resident[world->resident_count++];
+	*chunk = (WorldChunk){ .cx = cx, .cy = cy };
+
+	EntHandler *handler = world->handler;
+	WorldRecord *rec = RecordFind(world, cx, cy);
+
+	if(rec) {
+		chunk->from_record = true;
+
+		for(uint16_t i = 0; i < rec->body_count; i++) {
+			EntHandle handle = AsteroidSpawn(handler, rec->bodies[i].position);
+			Entity *body = EntGet(handler, handle);
+			if(!body) continue;
+
+			*(AsteroidData*)body->data = rec->bodies[i].data;
+			ChunkAddBody(world, chunk, handle);
+		}
+
+		return;
+	}
+
+	Vector2 positions[WORLD_BODIES_MAX];
+	uint16_t count = ChunkGenerate(world, cx, cy, positions);
+
+	for(uint16_t i = 0; i < count; i++) ChunkAddBody(world, chunk, AsteroidSpawn(handler, positions[i]));
+}
+
+// Destroy chunk's bodies, keeping a record of them if the chunk changed since it was generated or last stored
+static void ChunkStore(World *world, uint32_t index) {
+	WorldChunk *chunk = &world->resident[index];
+	EntHandler *handler = world->handler;
+
+	WorldBody bodies[WORLD_BODIES_MAX];
+	uint16_t count = 0;
+	bool changed = false;
+
+	for(uint16_t i = 0; i < chunk->body_count; i++) {
+		Entity *body = EntGet(handler, chunk->bodies[i]);
+		if(!body) {
+			changed = true;
+			continue;
+		}
+
+		bodies[count] = (WorldBody){ ENT_POS(body), *(AsteroidData*)body->data };
+		if(!BodyEqual(&bodies[count], &chunk->spawned[i])) changed = true;
+
+		count++;
+		EntDestroy(handler, chunk->bodies[i]);
+	}
+
+	// Every body there as spawned, generation or existing record still describes the chunk
+
+	if(changed) {
+		WorldRecord *rec = RecordFind(world, chunk->cx, chunk->cy);
+
+		if(!rec && (world->record_count + 1) * 2 > world->record_cap && !RecordsGrow(world)) {
+			printf("ERROR: Could not store world chunk [%d, %d]\n", chunk->cx, chunk->cy);
+		} else {
+			if(!rec) {
+				rec = RecordSlot(world->records, world->record_cap, chunk->cx, chunk->cy);
+				*rec = (WorldRecord){ .cx = chunk->cx, .cy = chunk->cy, .used = true };
+				world->record_count++;
+			}
+
+			// Bodies are only ever lost, a rewrite never needs more room than the record had
+			if(!rec->bodies) rec->bodies = malloc(sizeof(WorldBody) * (count ? count : 1));
+			world->record_bytes -= sizeof(WorldBody) * rec->body_count;
+
+			if(rec->bodies) {
+				memcpy(rec->bodies, bodies, sizeof(WorldBody) * count);
+				rec->body_count = count;
+				world->record_bytes += sizeof(WorldBody) * count;
+			} else {
+				rec->body_count = 0;
+			}
+		}
+	}
+
+	world->resident[index] = world->resident[--world->resident_count];
+}
+
+bool WorldLoadRecords(World *world, const WorldRecord *records, uint32_t count, const WorldBody *bodies) {
+	uint32_t cap = WORLD_RECORD_MIN_CAP;
+	while(count * 2 > cap) cap *= 2;
+
+	WorldRecord *table = calloc(cap, sizeof(WorldRecord));
+	if(!table) return false;
+
+	size_t bytes = 0;
+	bool ok = true;
+
+	for(uint32_t i = 0; i < count && ok; i++) {
+		// A cell recorded twice can't be told apart in the table
+		WorldRecord *rec = RecordSlot(table, cap, records[i].cx, records[i].cy);
+		if(rec->used) {
+			ok = false;
+			break;
+		}
+
+		*rec = (WorldRecord){ .cx = records[i].cx, .cy = records[i].cy, .used = true, .body_count = records[i].body_count };
+
+		size_t size = sizeof(WorldBody) * rec->body_count;
+		rec->bodies = malloc(size ? size : sizeof(WorldBody));
+		ok = (rec->bodies != NULL);
+
+		if(ok) memcpy(rec->bodies, bodies, size);
+		bodies += rec->body_count;
+		bytes += size;
+	}
+
+	if(!ok) {
+		for(uint32_t i = 0; i < cap; i++) free(table[i].bodies);
+		free(table);
+		return false;
+	}
+
+	for(uint32_t i = 0; i < world->record_cap; i++) free(world->records[i].bodies);
+	free(world->records);
+
+	world->records = table;
+	world->record_cap = cap;
+	world->record_count = count;
+	world->record_bytes = bytes;
+	return true;
+}
+
+static bool ChunkResident(World *world, int32_t cx, int32_t cy) {
+	for(uint32_t i = 0; i < world->resident_count; i++)
+		if(world->resident[i].cx == cx && world->resident[i].cy == cy) return true;
+
+	return false;
+}
+
+void WorldUpdate(World *world, Vector2 center) {
+	int32_t ccx = (int32_t)floorf(center.x / WORLD_CHUNK_SIZE);
+	int32_t ccy = (int32_t)floorf(center.y / WORLD_CHUNK_SIZE);
+
+	// Store first, frees resident slots for activations
+	uint32_t stores = 0;
+	for(uint32_t i = 0; i < world->resident_count && stores < WORLD_STORES_PER_TICK;) {
+		WorldChunk *chunk = &world->resident[i];
+
+		if(CellDistance(chunk->cx, chunk->cy, ccx, ccy) > WORLD_KEEP_RADIUS) {
+			ChunkStore(world, i);
+			stores++;
+		} else {
+			i++;
+		}
+	}
+
+	// Walk rings outward from center so the nearest missing chunks come in first
+	uint32_t activations = 0;
+	for(int32_t r = 0; r <= WORLD_ACTIVE_RADIUS && activations < WORLD_ACTIVATIONS_PER_TICK; r++) {
+		for(int32_t dy = -r; dy <= r && activations < WORLD_ACTIVATIONS_PER_TICK; dy++) {
+			for(int32_t dx = -r; dx <= r && activations < WORLD_ACTIVATIONS_PER_TICK; dx++) {
+				if(abs(dx) != r && abs(dy) != r) continue;
+				if(ChunkResident(world, ccx + dx, ccy + dy)) continue;
+
+				// Stores are limited per tick too, out of range chunks may still be holding slots
+				if(world->resident_count >= WORLD_MAX_RESIDENT) return;
+
+				ChunkActivate(world, ccx + dx, ccy + dy);
+				activations++;
+			}
+		}
+	}
+}
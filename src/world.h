@@ -0,0 +1,80 @@
+#ifndef WORLD_H_
+#define WORLD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "raylib.h"
+#include "entity.h"
+#include "ent_handler.h"
+
+// Streamed asteroid field:
+// the world is split into square chunks keyed by cell coordinate, each chunk's bodies are generated from the world seed and it's cell.
+// Chunks near the stream center are resident (bodies exist as entities), chunks that drift out of range are stored back.
+// A chunk whose bodies are all still there as they were spawned is simply dropped and regenerated next time,
+// only chunks that changed keep a compact record, so memory follows what the player changed, not how far they went.
+// Chunk changes are spread over ticks, a few activations and stores per tick at most
+
+#define WORLD_CHUNK_SIZE			4096.0f		// World units per chunk side
+#define WORLD_ACTIVE_RADIUS			1			// Chunks within this many cells of center are made resident
+#define WORLD_KEEP_RADIUS			2			// Resident chunks further than this are stored, gap keeps edges from thrashing
+#define WORLD_MAX_RESIDENT			((2 * WORLD_KEEP_RADIUS + 1) * (2 * WORLD_KEEP_RADIUS + 1))
+
+#define WORLD_ACTIVATIONS_PER_TICK	1
+#define WORLD_STORES_PER_TICK		2
+
+#define WORLD_BODIES_MIN			8			// Bodies generated per chunk
+#define WORLD_BODIES_MAX			24
+#define WORLD_BODY_MARGIN			256.0f		// Bodies keep this far from chunk edges, twice this covers field spacing so capture zones never meet across edges
+#define WORLD_CLEAR_RADIUS			1200.0f		// No generated bodies this close to origin, start scene lives there
+
+#define WORLD_DEFAULT_SEED			0x5EED1234
+
+// Stored form of a body, enough to spawn it again
+typedef struct {
+	Vector2 position;
+	AsteroidData data;
+} WorldBody;
+
+// Chunk that changed since it was generated
+typedef struct {
+	int32_t cx, cy;
+	bool used;					// Table slot holds a chunk
+	uint16_t body_count;
+	WorldBody *bodies;			// Bodies still there when chunk was stored
+} WorldRecord;
+
+typedef struct {
+	int32_t cx, cy;
+	bool from_record;			// Spawned from a record instead of generated
+	uint16_t body_count;
+	EntHandle bodies[WORLD_BODIES_MAX];
+	WorldBody spawned[WORLD_BODIES_MAX];	// Each body as it was spawned, a chunk whose bodies all still match is unchanged
+} WorldChunk;
+
+typedef struct World {
+	EntHandler *handler;
+	uint32_t seed;
+
+	uint32_t resident_count;
+	WorldChunk resident[WORLD_MAX_RESIDENT];
+
+	// Changed chunks, open addressed on cell coordinate, records are only ever added or rewritten
+	uint32_t record_count;
+	uint32_t record_cap;		// Power of two
+	WorldRecord *records;
+	size_t record_bytes;		// Body storage of all records
+} World;
+
+void WorldInit(World *world, EntHandler *handler, uint32_t seed);
+
+// Free records, resident bodies are left to the entity handler
+void WorldClose(World *world);
+
+// Store chunks out of range and activate missing chunks around center, nearest first, within per tick limits
+void WorldUpdate(World *world, Vector2 center);
+
+// Replace records with count used records whose bodies follow each other in bodies, record body pointers are ignored.
+// Returns false if out of memory, old records are kept then
+bool WorldLoadRecords(World *world, const WorldRecord *records, uint32_t count, const WorldBody *bodies);
+
+#endif // !WORLD_H_
@@ -0,0 +1,32 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "raylib.h"
+#include "sprites.h"
+#include "asset_pack.h"
+
+// Offline asset packer:
+// loads loose content the same way the game does (load_content.c), packs atlas pages on the cpu,
+// writes the result as a single pack file. Image decoding needs no window or GL context.
+//
+// usage: asset_packer [output path]
+
+int main(int argc, char **argv) {
+	const char *path = (argc > 1) ? argv[1] : ASSET_PACK_PATH;
+	SetTraceLogLevel(LOG_WARNING);
+
+	SpriteLoader *sl = calloc(1, sizeof(SpriteLoader));
+	if(!sl) {
+		puts("ERROR: Could not allocate sprite loader");
+		return 1;
+	}
+
+	sl->flags = (SPR_LOADER_KEEP_PAGES | SPR_LOADER_NO_PACK);
+	LoadSpritesAll(sl);
+
+	bool ok = AssetPackWrite(sl, path);
+
+	SpriteLoaderClose(sl);
+	free(sl);
+
+	return (ok) ? 0 : 1;
+}